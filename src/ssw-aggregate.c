@@ -0,0 +1,472 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <math.h>
+#include "ssw-aggregate.h"
+#include "ssw-data-model.h"
+#include "ssw-parallel.h"
+#include "ssw-permutation.h"
+#include "ssw-selection.h"
+
+/* The number of rows of a column whose statistics are remembered
+   together */
+#define AGG_BLOCK_ROWS 4096
+
+/* The number of blocks computed at each step, if the model may be
+   read by several threads, and if it may not.  A step blocks the main
+   loop, so it is kept short enough for the sheet to stay responsive.
+   The steps cannot instead run in threads alongside the main loop,
+   since the model may be changed whilst they read it.  */
+#define AGG_PARALLEL_BLOCKS 8
+#define AGG_SERIAL_BLOCKS 1
+
+/* The greatest number of blocks whose statistics are remembered */
+#define AGG_CACHE_MAX (1 << 18)
+
+struct partial
+{
+  gint64 count;
+  gdouble sum;
+  gdouble min;
+  gdouble max;
+};
+
+/* A part of one column of the selection, no larger than a block */
+struct item
+{
+  /* The column of the data model */
+  gint col;
+
+  /* The rows of the view */
+  gint row0;
+  gint n_rows;
+
+  /* The block of the data model which the rows fill exactly, or -1 */
+  gint block;
+
+  struct partial p;
+};
+
+struct ssw_aggregator
+{
+  SswSheet *sheet;
+
+  /* The selection whose statistics are wanted, or NULL if none */
+  SswSelection *sel;
+
+  /* If TRUE, the items must be recalculated from SEL */
+  gboolean restart;
+
+  /* The parts of SEL whose statistics are not remembered.  Those
+     before NEXT have been computed, and added to TOTAL together with
+     those which were remembered.  */
+  GArray *items;
+  guint next;
+  struct partial total;
+
+  gint n_model_rows;
+  gboolean rows_in_order;
+  guint idle_id;
+
+  SswAggregates result;
+  gboolean valid;
+
+  /* Maps a block number to a table which maps a column of the data
+     model to the struct partial of that block of the column */
+  GHashTable *cache;
+  gint n_cached;
+};
+
+static void
+partial_init (struct partial *p)
+{
+  p->count = 0;
+  p->sum = 0;
+  p->min = INFINITY;
+  p->max = -INFINITY;
+}
+
+static void
+partial_merge (struct partial *p, const struct partial *q)
+{
+  p->count += q->count;
+  p->sum += q->sum;
+  p->min = MIN (p->min, q->min);
+  p->max = MAX (p->max, q->max);
+}
+
+static const struct partial *
+cache_lookup (struct ssw_aggregator *a, gint block, gint col)
+{
+  GHashTable *cols = g_hash_table_lookup (a->cache, GINT_TO_POINTER (block));
+
+  return cols ? g_hash_table_lookup (cols, GINT_TO_POINTER (col)) : NULL;
+}
+
+static void
+cache_insert (struct ssw_aggregator *a, gint block, gint col,
+              const struct partial *p)
+{
+  if (a->n_cached >= AGG_CACHE_MAX)
+    {
+      g_hash_table_remove_all (a->cache);
+      a->n_cached = 0;
+    }
+
+  GHashTable *cols = g_hash_table_lookup (a->cache, GINT_TO_POINTER (block));
+  if (cols == NULL)
+    {
+      cols = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+      g_hash_table_insert (a->cache, GINT_TO_POINTER (block), cols);
+    }
+
+  if (!g_hash_table_contains (cols, GINT_TO_POINTER (col)))
+    a->n_cached++;
+
+  struct partial *copy = g_new (struct partial, 1);
+  *copy = *p;
+  g_hash_table_insert (cols, GINT_TO_POINTER (col), copy);
+}
+
+gboolean
+ssw_value_get_number (const GValue *v, gdouble *d)
+{
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (v)))
+    {
+    case G_TYPE_INT:
+      *d = g_value_get_int (v);
+      return TRUE;
+    case G_TYPE_UINT:
+      *d = g_value_get_uint (v);
+      return TRUE;
+    case G_TYPE_LONG:
+      *d = g_value_get_long (v);
+      return TRUE;
+    case G_TYPE_ULONG:
+      *d = g_value_get_ulong (v);
+      return TRUE;
+    case G_TYPE_INT64:
+      *d = g_value_get_int64 (v);
+      return TRUE;
+    case G_TYPE_UINT64:
+      *d = g_value_get_uint64 (v);
+      return TRUE;
+    case G_TYPE_FLOAT:
+      *d = g_value_get_float (v);
+      return isfinite (*d);
+    case G_TYPE_DOUBLE:
+      *d = g_value_get_double (v);
+      return isfinite (*d);
+    case G_TYPE_STRING:
+      {
+        const gchar *s = g_value_get_string (v);
+        gchar *end;
+
+        if (s == NULL)
+          return FALSE;
+
+        while (g_ascii_isspace (*s))
+          s++;
+        if (*s == '\0')
+          return FALSE;
+
+        *d = g_ascii_strtod (s, &end);
+        if (end == s)
+          return FALSE;
+
+        while (g_ascii_isspace (*end))
+          end++;
+
+        return *end == '\0' && isfinite (*d);
+      }
+    default:
+      return FALSE;
+    }
+}
+
+/* An ssw_parallel_func computing the TASKth of the items from NEXT */
+static void
+compute_item (gint task, gpointer data)
+{
+  struct ssw_aggregator *a = data;
+  struct item *it = &g_array_index (a->items, struct item, a->next + task);
+  GtkTreeModel *model = a->sheet->data_model;
+  gint i;
+
+  partial_init (&it->p);
+
+  if (a->rows_in_order
+      && ssw_data_model_is_block_empty (model, it->col, it->row0, 1, it->n_rows))
+    return;
+
+  GValue *values = g_new0 (GValue, it->n_rows);
+
+  if (a->rows_in_order)
+    ssw_data_model_fetch_block (model, it->col, it->row0, 1, it->n_rows, values);
+  else
+    for (i = 0; i < it->n_rows; ++i)
+      ssw_data_model_fetch_block (model, it->col,
+                                  ssw_sheet_get_model_row (a->sheet, it->row0 + i),
+                                  1, 1, values + i);
+
+  for (i = 0; i < it->n_rows; ++i)
+    {
+      gdouble x;
+
+      if (!G_IS_VALUE (&values[i]))
+        continue;
+
+      if (ssw_value_get_number (&values[i], &x))
+        {
+          it->p.count++;
+          it->p.sum += x;
+          it->p.min = MIN (it->p.min, x);
+          it->p.max = MAX (it->p.max, x);
+        }
+      g_value_unset (&values[i]);
+    }
+
+  g_free (values);
+}
+
+/* A SswRangeFunc, dividing a range of the selection into items */
+static void
+add_range (const SswRange *r, gpointer data)
+{
+  struct ssw_aggregator *a = data;
+  gint col;
+
+  for (col = r->start_x; col <= r->end_x; ++col)
+    {
+      gint mcol = ssw_sheet_get_model_column (a->sheet, col);
+      gint row = r->start_y;
+
+      while (row <= r->end_y)
+        {
+          gint block = row / AGG_BLOCK_ROWS;
+          gint first = block * AGG_BLOCK_ROWS;
+          gint last = MIN (first + AGG_BLOCK_ROWS, a->n_model_rows) - 1;
+          struct item it;
+
+          it.col = mcol;
+          it.row0 = row;
+          it.n_rows = MIN (last, r->end_y) - row + 1;
+          it.block = -1;
+          row += it.n_rows;
+
+          if (a->rows_in_order && it.row0 == first && it.n_rows == last - first + 1)
+            {
+              const struct partial *p = cache_lookup (a, block, mcol);
+              if (p)
+                {
+                  partial_merge (&a->total, p);
+                  continue;
+                }
+              it.block = block;
+            }
+
+          g_array_append_val (a->items, it);
+        }
+    }
+}
+
+static void
+build_items (struct ssw_aggregator *a)
+{
+  GtkTreeModel *model = a->sheet->data_model;
+
+  g_array_set_size (a->items, 0);
+  a->next = 0;
+  partial_init (&a->total);
+  a->restart = FALSE;
+
+  if (model == NULL || a->sel == NULL)
+    return;
+
+  gint n_cols = gtk_tree_model_get_n_columns (model);
+  a->n_model_rows = gtk_tree_model_iter_n_children (model, NULL);
+  if (n_cols <= 0 || a->n_model_rows <= 0)
+    return;
+
+  /* Cells beyond the extent of the model are not counted */
+  SswRange extent;
+  extent.start_x = 0;
+  extent.end_x = n_cols - 1;
+  extent.start_y = 0;
+  extent.end_y = a->n_model_rows - 1;
+
+  a->rows_in_order = ssw_permutation_is_identity (a->sheet->row_order);
+  ssw_selection_foreach (a->sel, &extent, add_range, a);
+}
+
+static void
+finish (struct ssw_aggregator *a)
+{
+  const struct partial *t = &a->total;
+
+  a->result.count = t->count;
+  a->result.sum = t->sum;
+  a->result.mean = t->count ? t->sum / t->count : 0;
+  a->result.min = t->count ? t->min : 0;
+  a->result.max = t->count ? t->max : 0;
+  a->valid = TRUE;
+
+  g_signal_emit_by_name (a->sheet, "aggregates-ready", &a->result);
+}
+
+static gboolean
+aggregate_idle (gpointer data)
+{
+  struct ssw_aggregator *a = data;
+  GtkTreeModel *model = a->sheet->data_model;
+  gint i;
+
+  if (a->restart)
+    build_items (a);
+
+  gint n = a->items->len - a->next;
+  if (n > 0)
+    {
+      gboolean parallel = ssw_data_model_is_thread_safe (model);
+      n = MIN (n, parallel ? AGG_PARALLEL_BLOCKS : AGG_SERIAL_BLOCKS);
+
+      if (parallel)
+        ssw_parallel_for (n, compute_item, a);
+      else
+        for (i = 0; i < n; ++i)
+          compute_item (i, a);
+
+      for (i = 0; i < n; ++i)
+        {
+          const struct item *it =
+            &g_array_index (a->items, struct item, a->next + i);
+
+          partial_merge (&a->total, &it->p);
+          if (it->block >= 0)
+            cache_insert (a, it->block, it->col, &it->p);
+        }
+      a->next += n;
+    }
+
+  if (a->next < a->items->len)
+    return G_SOURCE_CONTINUE;
+
+  a->idle_id = 0;
+  finish (a);
+
+  return G_SOURCE_REMOVE;
+}
+
+struct ssw_aggregator *
+ssw_aggregator_new (SswSheet *sheet)
+{
+  struct ssw_aggregator *a = g_malloc0 (sizeof *a);
+
+  a->sheet = sheet;
+  a->items = g_array_new (FALSE, FALSE, sizeof (struct item));
+  a->cache = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                    (GDestroyNotify) g_hash_table_unref);
+
+  return a;
+}
+
+void
+ssw_aggregator_free (struct ssw_aggregator *a)
+{
+  if (a == NULL)
+    return;
+
+  ssw_aggregator_cancel (a);
+  g_array_free (a->items, TRUE);
+  g_hash_table_unref (a->cache);
+  g_free (a);
+}
+
+static void
+schedule (struct ssw_aggregator *a)
+{
+  a->valid = FALSE;
+  a->restart = TRUE;
+
+  if (a->idle_id == 0)
+    a->idle_id = g_idle_add (aggregate_idle, a);
+}
+
+void
+ssw_aggregator_start (struct ssw_aggregator *a, const SswSelection *sel)
+{
+  ssw_selection_free (a->sel);
+  a->sel = ssw_selection_copy (sel);
+
+  schedule (a);
+}
+
+void
+ssw_aggregator_cancel (struct ssw_aggregator *a)
+{
+  if (a->idle_id)
+    {
+      g_source_remove (a->idle_id);
+      a->idle_id = 0;
+    }
+
+  ssw_selection_free (a->sel);
+  a->sel = NULL;
+  a->valid = FALSE;
+  g_array_set_size (a->items, 0);
+  a->next = 0;
+}
+
+void
+ssw_aggregator_invalidate (struct ssw_aggregator *a, gint row0, gint n_rows)
+{
+  if (n_rows < 0)
+    {
+      g_hash_table_remove_all (a->cache);
+      a->n_cached = 0;
+    }
+  else if (n_rows > 0)
+    {
+      gint b;
+      for (b = row0 / AGG_BLOCK_ROWS;
+           b <= (row0 + n_rows - 1) / AGG_BLOCK_ROWS; ++b)
+        {
+          GHashTable *cols =
+            g_hash_table_lookup (a->cache, GINT_TO_POINTER (b));
+          if (cols)
+            {
+              a->n_cached -= g_hash_table_size (cols);
+              g_hash_table_remove (a->cache, GINT_TO_POINTER (b));
+            }
+        }
+    }
+
+  if (a->sel)
+    schedule (a);
+}
+
+gboolean
+ssw_aggregator_get (const struct ssw_aggregator *a, SswAggregates *agg)
+{
+  if (!a->valid)
+    return FALSE;
+
+  *agg = a->result;
+  return TRUE;
+}
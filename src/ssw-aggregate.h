@@ -0,0 +1,57 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Computation of the statistics of the numeric cells of a sheet's
+   selection.  The work is done a part at a time whilst the main loop
+   is idle, spreading each part over several threads if the data model
+   permits.  The statistics of whole blocks of rows of each column are
+   remembered, so that when a selection is extended, only the cells
+   newly selected need be read.  When the statistics are complete, the
+   sheet's "aggregates-ready" signal is emitted.  */
+
+#ifndef _SSW_AGGREGATE_H
+#define _SSW_AGGREGATE_H
+
+#include "ssw-sheet.h"
+
+struct ssw_aggregator;
+
+struct ssw_aggregator *ssw_aggregator_new (SswSheet *sheet);
+void ssw_aggregator_free (struct ssw_aggregator *a);
+
+/* Begin computing the statistics of SEL, abandoning any computation
+   in progress.  */
+void ssw_aggregator_start (struct ssw_aggregator *a, const SswSelection *sel);
+
+/* Abandon any computation in progress */
+void ssw_aggregator_cancel (struct ssw_aggregator *a);
+
+/* Forget what is known of the rows ROW0 .. ROW0 + N_ROWS - 1 of the
+   data model, or of all rows if N_ROWS is negative.  The statistics
+   of the current selection are then computed afresh.  */
+void ssw_aggregator_invalidate (struct ssw_aggregator *a, gint row0, gint n_rows);
+
+/* If the statistics of the current selection are known, copy them to
+   AGG and return TRUE.  */
+gboolean ssw_aggregator_get (const struct ssw_aggregator *a, SswAggregates *agg);
+
+/* If V holds a number, or a string which is a number, store it in D
+   and return TRUE.  */
+gboolean ssw_value_get_number (const GValue *v, gdouble *d);
+
+#endif
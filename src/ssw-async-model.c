@@ -0,0 +1,636 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <gtk/gtk.h>
+#include "ssw-async-model.h"
+#include "ssw-data-model.h"
+
+#define P_(X) (X)
+
+enum  {ITEMS_CHANGED,
+       n_SIGNALS};
+
+static guint signals [n_SIGNALS];
+
+/* A rectangular region of the child model */
+struct block
+{
+  /* The index of the block (not of its first cell) */
+  gint brow;
+  gint bcol;
+
+  /* The dimensions of this block.  Blocks at the bottom and right
+     edges of the model may be smaller than the others */
+  gint n_rows;
+  gint n_cols;
+
+  /* The cached values or NULL whilst they are being fetched */
+  GValue *values;
+
+  /* The generation of the model when the fetch of the values began */
+  guint generation;
+
+  /* The block's link in the model's AGE queue */
+  GList *link;
+};
+
+/* The data passed to the worker thread */
+struct fetch
+{
+  GtkTreeModel *child;
+  guint generation;
+  gint col0;
+  gint row0;
+  gint n_cols;
+  gint n_rows;
+  GValue *values;
+};
+
+static void
+free_values (GValue *values, gint n)
+{
+  gint i;
+
+  if (values == NULL)
+    return;
+
+  for (i = 0; i < n; ++i)
+    if (G_IS_VALUE (values + i))
+      g_value_unset (values + i);
+
+  g_free (values);
+}
+
+static guint
+block_hash (gconstpointer p)
+{
+  const struct block *b = p;
+  return b->brow * 65599u + b->bcol;
+}
+
+static gboolean
+block_equal (gconstpointer p1, gconstpointer p2)
+{
+  const struct block *b1 = p1;
+  const struct block *b2 = p2;
+  return b1->brow == b2->brow && b1->bcol == b2->bcol;
+}
+
+static void
+block_free (struct block *b)
+{
+  free_values (b->values, b->n_rows * b->n_cols);
+  g_free (b);
+}
+
+static void
+fetch_free (gpointer p)
+{
+  struct fetch *f = p;
+  free_values (f->values, f->n_rows * f->n_cols);
+  g_object_unref (f->child);
+  g_free (f);
+}
+
+static void
+drop_block (SswAsyncModel *m, struct block *b)
+{
+  g_hash_table_remove (m->blocks, b);
+  g_queue_delete_link (m->age, b->link);
+  block_free (b);
+}
+
+/* Make B the most recently used block */
+static void
+touch_block (SswAsyncModel *m, struct block *b)
+{
+  g_queue_unlink (m->age, b->link);
+  g_queue_push_tail_link (m->age, b->link);
+}
+
+/* Evict the least recently used loaded blocks until the cache is
+   within its limit.  Blocks which are still being fetched are not
+   evicted, and nor is KEEP, so that a block which has just arrived is
+   not lost before it can be used.  */
+static void
+trim_cache (SswAsyncModel *m, const struct block *keep)
+{
+  GList *l = m->age->head;
+
+  while (g_queue_get_length (m->age) > m->cache_size && l)
+    {
+      struct block *b = l->data;
+      l = l->next;
+
+      if (b->values != NULL && b != keep)
+        drop_block (m, b);
+    }
+}
+
+static void
+fetch_in_thread (GTask *task, gpointer source_object,
+                 gpointer task_data, GCancellable *cancellable)
+{
+  struct fetch *f = task_data;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  ssw_data_model_fetch_block (f->child, f->col0, f->row0,
+                              f->n_cols, f->n_rows, f->values);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+on_block_fetched (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (source);
+  GTask *task = G_TASK (res);
+  struct fetch *f = g_task_get_task_data (task);
+
+  if (!g_task_propagate_boolean (task, NULL))
+    return;
+
+  struct block key;
+  key.brow = f->row0 / m->block_rows;
+  key.bcol = f->col0 / m->block_cols;
+
+  /* The block has been dropped, or the cache flushed, since this fetch
+     was started */
+  struct block *b = g_hash_table_lookup (m->blocks, &key);
+  if (b == NULL || b->values != NULL || b->generation != f->generation)
+    return;
+
+  b->values = f->values;
+  f->values = NULL;
+
+  touch_block (m, b);
+  trim_cache (m, b);
+
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, f->row0, f->n_rows, f->n_rows);
+}
+
+/* Return the block containing COL, ROW, starting a fetch if it is not
+   already in the cache.  */
+static const struct block *
+lookup_block (SswAsyncModel *m, gint col, gint row)
+{
+  struct block key;
+  key.brow = row / m->block_rows;
+  key.bcol = col / m->block_cols;
+
+  /* The blocks drawn recently are thus the last to be evicted */
+  struct block *b = g_hash_table_lookup (m->blocks, &key);
+  if (b)
+    {
+      touch_block (m, b);
+      return b;
+    }
+
+  b = g_malloc (sizeof *b);
+  b->brow = key.brow;
+  b->bcol = key.bcol;
+  b->n_rows = MIN (m->block_rows, m->n_rows - b->brow * m->block_rows);
+  b->n_cols = MIN (m->block_cols, m->n_cols - b->bcol * m->block_cols);
+  b->values = NULL;
+  b->generation = m->generation;
+
+  g_hash_table_add (m->blocks, b);
+  g_queue_push_tail (m->age, b);
+  b->link = m->age->tail;
+
+  struct fetch *f = g_malloc (sizeof *f);
+  f->child = g_object_ref (m->child);
+  f->generation = m->generation;
+  f->row0 = b->brow * m->block_rows;
+  f->col0 = b->bcol * m->block_cols;
+  f->n_rows = b->n_rows;
+  f->n_cols = b->n_cols;
+  f->values = g_new0 (GValue, f->n_rows * f->n_cols);
+
+  GTask *task = g_task_new (m, m->cancellable, on_block_fetched, NULL);
+  g_task_set_task_data (task, f, fetch_free);
+  g_task_run_in_thread (task, fetch_in_thread);
+  g_object_unref (task);
+
+  return b;
+}
+
+void
+ssw_async_model_flush (SswAsyncModel *m)
+{
+  g_return_if_fail (SSW_IS_ASYNC_MODEL (m));
+
+  m->generation++;
+  g_hash_table_remove_all (m->blocks);
+  g_queue_foreach (m->age, (GFunc) block_free, NULL);
+  g_queue_clear (m->age);
+}
+
+/* Forget about the blocks containing ROW.  Any fetch of them still
+   under way is then ignored when it completes.  */
+static void
+drop_row (SswAsyncModel *m, gint row)
+{
+  GList *doomed = NULL;
+
+  m->generation++;
+  GList *l;
+  for (l = m->age->head; l; l = l->next)
+    {
+      struct block *b = l->data;
+      if (b->brow == row / m->block_rows)
+        doomed = g_list_prepend (doomed, b);
+    }
+
+  for (l = doomed; l; l = l->next)
+    drop_block (m, l->data);
+
+  g_list_free (doomed);
+}
+
+static void
+update_dimensions (SswAsyncModel *m)
+{
+  m->n_rows = gtk_tree_model_iter_n_children (m->child, NULL);
+  m->n_cols = gtk_tree_model_get_n_columns (m->child);
+}
+
+static void
+on_child_items_changed (GtkTreeModel *child, guint posn, guint rm, guint add,
+                        gpointer ud)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (ud);
+
+  update_dimensions (m);
+  ssw_async_model_flush (m);
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, posn, rm, add);
+}
+
+static void
+on_child_row_changed (GtkTreeModel *child, GtkTreePath *path,
+                      GtkTreeIter *iter, gpointer ud)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (ud);
+  gint row = gtk_tree_path_get_indices (path)[0];
+
+  drop_row (m, row);
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, row, 1, 1);
+}
+
+static void
+on_child_row_inserted (GtkTreeModel *child, GtkTreePath *path,
+                       GtkTreeIter *iter, gpointer ud)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (ud);
+  gint row = gtk_tree_path_get_indices (path)[0];
+
+  update_dimensions (m);
+  ssw_async_model_flush (m);
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, row, 0, 1);
+}
+
+static void
+on_child_row_deleted (GtkTreeModel *child, GtkTreePath *path, gpointer ud)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (ud);
+  gint row = gtk_tree_path_get_indices (path)[0];
+
+  update_dimensions (m);
+  ssw_async_model_flush (m);
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, row, 1, 0);
+}
+
+
+static  gint
+__iter_n_children (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+  return m->n_rows;
+}
+
+static gint
+__get_n_columns  (GtkTreeModel *tree_model)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+  return m->n_cols;
+}
+
+static gboolean
+__iter_nth_child  (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter,
+                   GtkTreeIter  *parent,
+                   gint          n)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+
+  g_assert (parent == NULL);
+
+  if (n < 0 || n >= m->n_rows)
+    return FALSE;
+
+  iter->stamp = m->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+  return TRUE;
+}
+
+static GType
+__get_type (GtkTreeModel *tree_model,
+            gint col)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+  return gtk_tree_model_get_column_type (m->child, col);
+}
+
+static void
+__get_value (GtkTreeModel *tree_model,
+             GtkTreeIter  *iter,
+             gint          column,
+             GValue       *value)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+  g_return_if_fail (iter->stamp == m->stamp);
+
+  gint row = GPOINTER_TO_INT (iter->user_data);
+
+  const struct block *b = lookup_block (m, column, row);
+  if (b->values == NULL)
+    {
+      ssw_value_set_pending (value);
+      return;
+    }
+
+  const GValue *v = b->values
+    + (row - b->brow * m->block_rows) * b->n_cols
+    + (column - b->bcol * m->block_cols);
+
+  if (G_IS_VALUE (v))
+    {
+      g_value_init (value, G_VALUE_TYPE (v));
+      g_value_copy (v, value);
+    }
+  else
+    g_value_init (value, __get_type (tree_model, column));
+}
+
+static GtkTreePath *
+__get_path (GtkTreeModel *tree_model,
+            GtkTreeIter  *iter)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (tree_model);
+  g_return_val_if_fail (iter->stamp == m->stamp, NULL);
+  return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+}
+
+static GtkTreeModelFlags
+__get_flags (GtkTreeModel *tm)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+
+static void
+__init_iface (GtkTreeModelIface *iface)
+{
+  iface->iter_n_children = __iter_n_children;
+  iface->get_n_columns = __get_n_columns;
+  iface->iter_nth_child = __iter_nth_child;
+  iface->get_value = __get_value;
+  iface->get_column_type = __get_type;
+  iface->get_path = __get_path;
+  iface->get_flags = __get_flags;
+}
+
+G_DEFINE_TYPE_WITH_CODE (SswAsyncModel, ssw_async_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL, __init_iface));
+
+
+static void
+__dispose (GObject *obj)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (obj);
+
+  if (m->dispose_has_run)
+    return;
+
+  m->dispose_has_run = TRUE;
+
+  g_cancellable_cancel (m->cancellable);
+
+  if (m->child)
+    g_signal_handlers_disconnect_by_data (m->child, m);
+  g_clear_object (&m->child);
+
+  G_OBJECT_CLASS (ssw_async_model_parent_class)->dispose (obj);
+}
+
+static void
+__finalize (GObject *obj)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (obj);
+
+  ssw_async_model_flush (m);
+  g_hash_table_unref (m->blocks);
+  g_queue_free (m->age);
+  g_object_unref (m->cancellable);
+
+  G_OBJECT_CLASS (ssw_async_model_parent_class)->finalize (obj);
+}
+
+
+enum
+  {
+   PROP_0,
+   PROP_CHILD,
+   PROP_BLOCK_ROWS,
+   PROP_BLOCK_COLS,
+   PROP_CACHE_SIZE
+  };
+
+static void
+set_child (SswAsyncModel *m, GtkTreeModel *child)
+{
+  m->child = g_object_ref (child);
+  update_dimensions (m);
+
+  if (g_signal_lookup ("items-changed", G_OBJECT_TYPE (child)))
+    {
+      g_signal_connect_object (child, "items-changed",
+                               G_CALLBACK (on_child_items_changed), m, 0);
+    }
+  else
+    {
+      g_signal_connect_object (child, "row-inserted",
+                               G_CALLBACK (on_child_row_inserted), m, 0);
+      g_signal_connect_object (child, "row-deleted",
+                               G_CALLBACK (on_child_row_deleted), m, 0);
+    }
+
+  g_signal_connect_object (child, "row-changed",
+                           G_CALLBACK (on_child_row_changed), m, 0);
+}
+
+/* GObject vfuncs {{{ */
+static void
+__set_property (GObject *object,
+                guint prop_id, const GValue *value, GParamSpec * pspec)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      set_child (m, g_value_get_object (value));
+      break;
+    case PROP_BLOCK_ROWS:
+      m->block_rows = g_value_get_int (value);
+      ssw_async_model_flush (m);
+      break;
+    case PROP_BLOCK_COLS:
+      m->block_cols = g_value_get_int (value);
+      ssw_async_model_flush (m);
+      break;
+    case PROP_CACHE_SIZE:
+      m->cache_size = g_value_get_uint (value);
+      trim_cache (m, NULL);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+__get_property (GObject * object,
+                guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  SswAsyncModel *m = SSW_ASYNC_MODEL (object);
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      g_value_set_object (value, m->child);
+      break;
+    case PROP_BLOCK_ROWS:
+      g_value_set_int (value, m->block_rows);
+      break;
+    case PROP_BLOCK_COLS:
+      g_value_set_int (value, m->block_cols);
+      break;
+    case PROP_CACHE_SIZE:
+      g_value_set_uint (value, m->cache_size);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+ssw_async_model_class_init (SswAsyncModelClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = __set_property;
+  object_class->get_property = __get_property;
+  object_class->dispose = __dispose;
+  object_class->finalize = __finalize;
+
+  GParamSpec *child_spec =
+    g_param_spec_object ("child-model",
+                         P_("Child Model"),
+                         P_("The model from which the data are fetched"),
+                         GTK_TYPE_TREE_MODEL,
+                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *block_rows_spec =
+    g_param_spec_int ("block-rows",
+                      P_("Block Rows"),
+                      P_("The number of rows fetched at a time"),
+                      1, G_MAXINT, 256,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *block_cols_spec =
+    g_param_spec_int ("block-columns",
+                      P_("Block Columns"),
+                      P_("The number of columns fetched at a time"),
+                      1, G_MAXINT, 32,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *cache_size_spec =
+    g_param_spec_uint ("cache-size",
+                       P_("Cache Size"),
+                       P_("The maximum number of blocks to keep in memory"),
+                       1, G_MAXUINT, 256,
+                       G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  g_object_class_install_property (object_class,
+                                   PROP_CHILD,
+                                   child_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_BLOCK_ROWS,
+                                   block_rows_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_BLOCK_COLS,
+                                   block_cols_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_CACHE_SIZE,
+                                   cache_size_spec);
+
+  signals [ITEMS_CHANGED] =
+    g_signal_new ("items-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_generic,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT);
+}
+
+static void
+ssw_async_model_init (SswAsyncModel *m)
+{
+  m->child = NULL;
+  m->n_rows = 0;
+  m->n_cols = 0;
+  m->generation = 0;
+  m->blocks = g_hash_table_new (block_hash, block_equal);
+  m->age = g_queue_new ();
+  m->cancellable = g_cancellable_new ();
+  m->stamp = g_random_int ();
+  m->dispose_has_run = FALSE;
+}
+
+
+GObject *
+ssw_async_model_new (GtkTreeModel *child)
+{
+  return g_object_new (SSW_TYPE_ASYNC_MODEL,
+                       "child-model", child,
+                       NULL);
+}
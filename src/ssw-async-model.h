@@ -0,0 +1,79 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* An implementation of GtkTreeModel which wraps a slow CHILD model.
+   Values are fetched from the child in rectangular blocks by a worker
+   thread and cached.  Whilst a block is being fetched, its cells are
+   reported as SSW_TYPE_PENDING, and when it arrives "items-changed"
+   is emitted for its rows.
+
+   The child model is read only from the worker threads (apart from
+   its dimensions and column types), so its get_value implementation
+   must not touch any GTK state.
+*/
+
+#ifndef _SSW_ASYNC_MODEL_H
+#define _SSW_ASYNC_MODEL_H
+
+#include <gtk/gtk.h>
+
+struct _SswAsyncModel
+{
+  GObject parent_instance;
+
+  GtkTreeModel *child;
+
+  /* Dimensions of the child, cached so that the main loop need
+     not ask the child for them */
+  gint n_rows;
+  gint n_cols;
+
+  /* The dimensions of a block */
+  gint block_rows;
+  gint block_cols;
+
+  /* The maximum number of blocks held in the cache */
+  guint cache_size;
+
+  GHashTable *blocks;
+  GQueue *age;
+
+  /* Incremented whenever the cache is flushed or blocks are dropped
+     from it, so that stale fetches can be recognised */
+  guint generation;
+
+  GCancellable *cancellable;
+  guint32 stamp;
+  gboolean dispose_has_run;
+};
+
+struct _SswAsyncModelClass
+{
+  GObjectClass parent_class;
+};
+
+#define SSW_TYPE_ASYNC_MODEL ssw_async_model_get_type ()
+
+G_DECLARE_FINAL_TYPE (SswAsyncModel, ssw_async_model, SSW, ASYNC_MODEL, GObject)
+
+  GObject * ssw_async_model_new (GtkTreeModel *child);
+
+/* Discard all cached values.  They will be fetched again on demand.  */
+void ssw_async_model_flush (SswAsyncModel *m);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include "ssw-axis-geometry.h"
+
+struct _SswAxisGeometry
+{
+  GObject parent_instance;
+
+  /* Maps the position of each item whose size has been set onto its
+     size */
+  GHashTable *sizes;
+};
+
+G_DEFINE_TYPE (SswAxisGeometry, ssw_axis_geometry, G_TYPE_OBJECT);
+
+enum  {SIZE_CHANGED,
+       n_SIGNALS};
+
+static guint signals [n_SIGNALS];
+
+static void
+__finalize (GObject *obj)
+{
+  SswAxisGeometry *geometry = SSW_AXIS_GEOMETRY (obj);
+
+  g_hash_table_destroy (geometry->sizes);
+
+  G_OBJECT_CLASS (ssw_axis_geometry_parent_class)->finalize (obj);
+}
+
+static void
+ssw_axis_geometry_class_init (SswAxisGeometryClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->finalize = __finalize;
+
+  signals [SIZE_CHANGED] =
+    g_signal_new ("size-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__INT,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_INT);
+}
+
+static void
+ssw_axis_geometry_init (SswAxisGeometry *geometry)
+{
+  geometry->sizes = g_hash_table_new (g_direct_hash, g_direct_equal);
+}
+
+SswAxisGeometry *
+ssw_axis_geometry_new (void)
+{
+  return g_object_new (SSW_TYPE_AXIS_GEOMETRY, NULL);
+}
+
+gint
+ssw_axis_geometry_get_size (SswAxisGeometry *geometry, gint pos)
+{
+  gpointer size;
+
+  if (!g_hash_table_lookup_extended (geometry->sizes, GINT_TO_POINTER (pos),
+                                     NULL, &size))
+    return -1;
+
+  return GPOINTER_TO_INT (size);
+}
+
+void
+ssw_axis_geometry_set_size (SswAxisGeometry *geometry, gint pos, gint size)
+{
+  if (size < 0)
+    g_hash_table_remove (geometry->sizes, GINT_TO_POINTER (pos));
+  else
+    g_hash_table_insert (geometry->sizes,
+                         GINT_TO_POINTER (pos),
+                         GINT_TO_POINTER (size));
+
+  g_signal_emit (geometry, signals [SIZE_CHANGED], 0, pos);
+}
@@ -0,0 +1,43 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The sizes of those items of an axis which have been given a size
+   other than their natural one.  Axes which show the same items share
+   one, so that an item resized in any of them is resized in all, and
+   they agree about where each item lies.  The "size-changed" signal is
+   emitted, with the position of the item, whenever a size is set.  */
+
+#ifndef _SSW_AXIS_GEOMETRY_H
+#define _SSW_AXIS_GEOMETRY_H
+
+#include <glib-object.h>
+
+G_DECLARE_FINAL_TYPE (SswAxisGeometry, ssw_axis_geometry, SSW, AXIS_GEOMETRY, GObject)
+
+#define SSW_TYPE_AXIS_GEOMETRY ssw_axis_geometry_get_type ()
+
+SswAxisGeometry *ssw_axis_geometry_new (void);
+
+/* The size of the item at POS, or -1 if it has its natural size */
+gint ssw_axis_geometry_get_size (SswAxisGeometry *geometry, gint pos);
+
+/* Set the size of the item at POS to SIZE.  If SIZE is negative, the
+   item has its natural size.  */
+void ssw_axis_geometry_set_size (SswAxisGeometry *geometry, gint pos, gint size);
+
+#endif
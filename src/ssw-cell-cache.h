@@ -0,0 +1,55 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The accessible objects of the cells which assistive technologies
+   have asked for recently, kept so that walking a table cell by cell
+   neither converts a cell's value twice nor creates an object for
+   every cell of the sheet.  The cache belongs to the sheet, and cells
+   are identified by their column and row in the data model.
+
+   The cache holds a bounded number of cells.  When it has filled, the
+   cells which have not been asked for since it last filled are
+   forgotten.  An object which is forgotten lives on for as long as
+   anything else holds a reference to it.  */
+
+#ifndef _SSW_CELL_CACHE_H
+#define _SSW_CELL_CACHE_H
+
+#include <atk/atk.h>
+
+struct ssw_cell_cache;
+
+struct ssw_cell_cache *ssw_cell_cache_new (void);
+void ssw_cell_cache_free (struct ssw_cell_cache *c);
+
+/* Forget the cells in the rows ROW0 .. ROW0 + N_ROWS - 1 of the data
+   model, or all cells if N_ROWS is negative.  */
+void ssw_cell_cache_invalidate (struct ssw_cell_cache *c,
+                                gint row0, gint n_rows);
+
+/* The object of the cell COL, ROW, or NULL if it is not in the cache.
+   The object belongs to the cache.  */
+AtkObject *ssw_cell_cache_lookup (struct ssw_cell_cache *c,
+                                  gint col, gint row);
+
+/* Remember OBJECT as the object of the cell COL, ROW.  The cache takes
+   a reference to it.  */
+void ssw_cell_cache_insert (struct ssw_cell_cache *c,
+                            gint col, gint row, AtkObject *object);
+
+#endif
@@ -53,6 +53,8 @@ __finalize (GObject *obj)
 {
   SswCell *cell = SSW_CELL (obj);
   g_free (cell->text);
+
+  G_OBJECT_CLASS (ssw_cell_parent_class)->finalize (obj);
 }
 
 
@@ -0,0 +1,90 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include "ssw-data-model.h"
+
+GType
+ssw_pending_get_type (void)
+{
+  static gsize type = 0;
+
+  if (g_once_init_enter (&type))
+    g_once_init_leave (&type, g_pointer_type_register_static ("SswPending"));
+
+  return type;
+}
+
+void
+ssw_value_set_pending (GValue *value)
+{
+  g_value_init (value, SSW_TYPE_PENDING);
+}
+
+void
+ssw_data_model_fetch_block (GtkTreeModel *model,
+                            gint col0, gint row0,
+                            gint n_cols, gint n_rows,
+                            GValue *values)
+{
+  guint sig = g_signal_lookup ("fetch-block", G_OBJECT_TYPE (model));
+  if (sig != 0)
+    {
+      gboolean done = FALSE;
+      g_signal_emit (model, sig, 0, col0, row0, n_cols, n_rows, values, &done);
+      if (done)
+        return;
+    }
+
+  gint r, c;
+  for (r = 0; r < n_rows; ++r)
+    {
+      GtkTreeIter iter;
+      if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, row0 + r))
+        continue;
+
+      for (c = 0; c < n_cols; ++c)
+        gtk_tree_model_get_value (model, &iter, col0 + c,
+                                  values + r * n_cols + c);
+    }
+}
+
+gboolean
+ssw_data_model_is_block_empty (GtkTreeModel *model,
+                               gint col0, gint row0,
+                               gint n_cols, gint n_rows)
+{
+  gboolean empty = FALSE;
+  guint sig = g_signal_lookup ("is-block-empty", G_OBJECT_TYPE (model));
+  if (sig != 0)
+    g_signal_emit (model, sig, 0, col0, row0, n_cols, n_rows, &empty);
+
+  return empty;
+}
+
+gboolean
+ssw_data_model_is_thread_safe (GtkTreeModel *model)
+{
+  gboolean safe = FALSE;
+
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (model),
+                                    "thread-safe-read"))
+    g_object_get (model, "thread-safe-read", &safe, NULL);
+
+  return safe;
+}
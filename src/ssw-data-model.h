@@ -0,0 +1,88 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Helpers describing the optional extensions which an SswSheet data
+   model may provide in addition to GtkTreeModel.
+*/
+
+#ifndef _SSW_DATA_MODEL_H
+#define _SSW_DATA_MODEL_H
+
+#include <gtk/gtk.h>
+
+/* A data model may return a value of this type from
+   gtk_tree_model_get_value to indicate that the datum is not yet
+   available.  The sheet draws such cells as placeholders and never
+   passes them to the conversion functions.  When the datum arrives,
+   the model should emit "items-changed" for the affected rows.  */
+#define SSW_TYPE_PENDING ssw_pending_get_type ()
+
+GType ssw_pending_get_type (void) G_GNUC_CONST;
+
+#define SSW_VALUE_HOLDS_PENDING(value) \
+  G_TYPE_CHECK_VALUE_TYPE ((value), SSW_TYPE_PENDING)
+
+void ssw_value_set_pending (GValue *value);
+
+/* Fill VALUES (which must contain N_COLS * N_ROWS zero initialised
+   GValues) with the block of MODEL whose top left cell is COL0, ROW0.
+   The values are stored in row major order.
+
+   If MODEL has a "fetch-block" signal, it is emitted with the
+   signature
+
+     gboolean (*) (GtkTreeModel *model, gint col0, gint row0,
+                   gint n_cols, gint n_rows, GValue *values)
+
+   which allows the model to provide the whole block at once.  If it
+   is not present, or returns FALSE, the block is filled cell by
+   cell.  */
+void ssw_data_model_fetch_block (GtkTreeModel *model,
+                                 gint col0, gint row0,
+                                 gint n_cols, gint n_rows,
+                                 GValue *values);
+
+/* Returns TRUE if every cell in the N_COLS x N_ROWS block of MODEL
+   whose top left cell is COL0, ROW0 is empty, that is to say has
+   nothing to display.  Such blocks may be skipped when drawing or
+   copying.
+
+   The answer is provided by the model's "is-block-empty" signal, with
+   the signature
+
+     gboolean (*) (GtkTreeModel *model, gint col0, gint row0,
+                   gint n_cols, gint n_rows)
+
+   If the model has no such signal, FALSE is returned.  */
+gboolean ssw_data_model_is_block_empty (GtkTreeModel *model,
+                                        gint col0, gint row0,
+                                        gint n_cols, gint n_rows);
+
+/* Returns TRUE if MODEL may be read from several threads at once.
+
+   A model declares this by installing a readable boolean property
+   "thread-safe-read" whose value is TRUE.  It thereby promises that
+   gtk_tree_model_iter_nth_child, gtk_tree_model_get_value, and its
+   "fetch-block" and "is-block-empty" signals may be called
+   concurrently, provided that nothing modifies the model meanwhile.
+   The sheet's forward conversion function, if it has one, is called
+   from several threads only if the sheet's "thread-safe-conversion"
+   property is also TRUE.  */
+gboolean ssw_data_model_is_thread_safe (GtkTreeModel *model);
+
+#endif
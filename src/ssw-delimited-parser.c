@@ -0,0 +1,132 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <glib.h>
+
+#include "ssw-paste.h"
+
+/* Split the LEN bytes at DATA into rows and fields.  DATA is
+   overwritten, and must have room for a terminating byte at
+   DATA[LEN].
+
+   Rows are terminated by "\n" or "\r\n", and fields by DELIMITER.  A
+   field which begins with a double quote extends to the matching
+   closing quote, and may contain delimiters and line breaks.  Within
+   it, two consecutive quotes stand for one.  Quoted fields are
+   unescaped in place, and every field is terminated with a NUL byte
+   in place, so no memory is allocated.
+
+   FIELD is called for every field, and END_OF_ROW at the end of every
+   row.  A line which is entirely empty contains no fields.
+
+   Parsing stops after MAX_ROWS rows.  The number of bytes consumed is
+   returned, so that parsing may be resumed from that point.  */
+gsize
+ssw_parse_delimited (gchar *data, gsize len, gchar delimiter,
+                     ssw_paste_field_func field,
+                     ssw_paste_row_func end_of_row,
+                     struct paste_state *ps, gint max_rows)
+{
+  gchar *p = data;
+  gchar *const end = data + len;
+  gint rows = 0;
+
+  while (p < end && rows < max_rows)
+    {
+      if (*p == '\n')
+        {
+          end_of_row (ps);
+          rows++;
+          p++;
+          continue;
+        }
+      if (*p == '\r' && p + 1 < end && p[1] == '\n')
+        {
+          end_of_row (ps);
+          rows++;
+          p += 2;
+          continue;
+        }
+
+      for (;;)
+        {
+          gchar *start = p;
+          gchar *out;
+
+          if (p < end && *p == '"')
+            {
+              /* Unescape the quoted text towards the start of the
+                 field.  The write position never overtakes the
+                 read position.  */
+              out = start;
+              p++;
+              while (p < end)
+                {
+                  if (*p == '"')
+                    {
+                      if (p + 1 < end && p[1] == '"')
+                        {
+                          *out++ = '"';
+                          p += 2;
+                          continue;
+                        }
+                      p++;
+                      break;
+                    }
+                  *out++ = *p++;
+                }
+
+              /* Tolerate stray text after the closing quote */
+              while (p < end && *p != delimiter && *p != '\n')
+                *out++ = *p++;
+            }
+          else
+            {
+              while (p < end && *p != delimiter && *p != '\n')
+                p++;
+              out = p;
+            }
+
+          const gchar term = (p < end) ? *p : '\0';
+
+          /* Drop the carriage return of a "\r\n" line ending */
+          if (term != delimiter && out > start && out[-1] == '\r')
+            out--;
+
+          *out = '\0';
+          field (start, out - start, ps);
+
+          if (p >= end)
+            {
+              end_of_row (ps);
+              return len;
+            }
+
+          p++;
+          if (term == '\n')
+            {
+              end_of_row (ps);
+              rows++;
+              break;
+            }
+        }
+    }
+
+  return p - data;
+}
@@ -0,0 +1,647 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <gtk/gtk.h>
+#include "ssw-filter-model.h"
+#include "ssw-data-model.h"
+#include "ssw-parallel.h"
+
+#define P_(X) (X)
+
+/* The number of rows evaluated by each task */
+#define BLOCK_ROWS 16384
+
+/* Changes to at most this many rows of the child are filtered at once,
+   on the calling thread.  Larger ones are filtered again in the
+   background.  */
+#define IMMEDIATE_ROWS 1024
+
+enum  {ITEMS_CHANGED,
+       n_SIGNALS};
+
+static guint signals [n_SIGNALS];
+
+struct filter
+{
+  ssw_filter_func func;
+  gpointer data;
+  GDestroyNotify destroy;
+};
+
+static void
+filter_clear (gpointer p)
+{
+  struct filter *f = p;
+  if (f->destroy)
+    f->destroy (f->data);
+}
+
+static void
+filter_unref (struct filter *f)
+{
+  g_atomic_rc_box_release_full (f, filter_clear);
+}
+
+/* The data passed to the worker thread */
+struct job
+{
+  GtkTreeModel *child;
+  struct filter *filter;
+  GCancellable *cancellable;
+
+  gint n_rows;
+  gint n_blocks;
+
+  /* The visible rows of each block */
+  GArray **results;
+};
+
+static void
+job_free (gpointer p)
+{
+  struct job *job = p;
+  gint i;
+
+  for (i = 0; i < job->n_blocks; ++i)
+    if (job->results[i])
+      g_array_unref (job->results[i]);
+
+  g_free (job->results);
+  filter_unref (job->filter);
+  g_object_unref (job->child);
+  g_free (job);
+}
+
+static void
+filter_block (gint task, gpointer data)
+{
+  struct job *job = data;
+  gint r0 = task * BLOCK_ROWS;
+  gint r1 = MIN (r0 + BLOCK_ROWS, job->n_rows);
+  GArray *result = g_array_new (FALSE, FALSE, sizeof (guint));
+  gint r;
+
+  for (r = r0; r < r1; ++r)
+    {
+      if ((r % 1024) == 0 && g_cancellable_is_cancelled (job->cancellable))
+        break;
+
+      if (job->filter->func (job->child, r, job->filter->data))
+        {
+          guint x = r;
+          g_array_append_val (result, x);
+        }
+    }
+
+  job->results[task] = result;
+}
+
+static void
+filter_in_thread (GTask *task, gpointer source_object,
+                  gpointer task_data, GCancellable *cancellable)
+{
+  struct job *job = task_data;
+  gint i;
+
+  ssw_parallel_for (job->n_blocks, filter_block, job);
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  guint total = 0;
+  for (i = 0; i < job->n_blocks; ++i)
+    total += job->results[i]->len;
+
+  GArray *visible = g_array_sized_new (FALSE, FALSE, sizeof (guint), total);
+  for (i = 0; i < job->n_blocks; ++i)
+    g_array_append_vals (visible, job->results[i]->data, job->results[i]->len);
+
+  g_task_return_pointer (task, visible, (GDestroyNotify) g_array_unref);
+}
+
+static gint
+n_child_rows (SswFilterModel *m)
+{
+  return gtk_tree_model_iter_n_children (m->child, NULL);
+}
+
+static inline guint
+row_at (SswFilterModel *m, GArray *visible, guint i)
+{
+  return visible ? g_array_index (visible, guint, i) : i;
+}
+
+/* Replace the visible rows with VISIBLE, and announce the range of
+   rows which has changed */
+static void
+publish (SswFilterModel *m, GArray *visible)
+{
+  GArray *old = m->visible;
+  guint old_n = old ? old->len : n_child_rows (m);
+  guint new_n = visible ? visible->len : n_child_rows (m);
+  guint n = MIN (old_n, new_n);
+
+  guint prefix = 0;
+  while (prefix < n && row_at (m, old, prefix) == row_at (m, visible, prefix))
+    prefix++;
+
+  guint suffix = 0;
+  while (suffix < n - prefix
+         && (row_at (m, old, old_n - 1 - suffix)
+             == row_at (m, visible, new_n - 1 - suffix)))
+    suffix++;
+
+  m->visible = visible;
+  if (old)
+    g_array_unref (old);
+
+  if (prefix + suffix < old_n || prefix + suffix < new_n)
+    g_signal_emit (m, signals [ITEMS_CHANGED], 0, prefix,
+                   old_n - prefix - suffix, new_n - prefix - suffix);
+}
+
+static void
+on_filtered (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (source);
+  GTask *task = G_TASK (res);
+
+  GArray *visible = g_task_propagate_pointer (task, NULL);
+  if (visible == NULL)
+    return;
+
+  if (m->running == g_task_get_cancellable (task))
+    g_clear_object (&m->running);
+
+  publish (m, visible);
+}
+
+static void
+cancel_running (SswFilterModel *m)
+{
+  if (m->running)
+    {
+      g_cancellable_cancel (m->running);
+      g_clear_object (&m->running);
+    }
+}
+
+void
+ssw_filter_model_refilter (SswFilterModel *m)
+{
+  g_return_if_fail (SSW_IS_FILTER_MODEL (m));
+
+  cancel_running (m);
+
+  if (m->filter == NULL)
+    return;
+
+  struct job *job = g_malloc (sizeof *job);
+  job->child = g_object_ref (m->child);
+  job->filter = g_atomic_rc_box_acquire (m->filter);
+  job->n_rows = n_child_rows (m);
+  job->n_blocks = (job->n_rows + BLOCK_ROWS - 1) / BLOCK_ROWS;
+  job->results = g_new0 (GArray *, job->n_blocks);
+
+  m->running = g_cancellable_new ();
+  job->cancellable = m->running;
+
+  GTask *task = g_task_new (m, m->running, on_filtered, NULL);
+  g_task_set_task_data (task, job, job_free);
+  g_task_run_in_thread (task, filter_in_thread);
+  g_object_unref (task);
+}
+
+void
+ssw_filter_model_set_filter (SswFilterModel *m, ssw_filter_func func,
+                             gpointer user_data, GDestroyNotify destroy)
+{
+  g_return_if_fail (SSW_IS_FILTER_MODEL (m));
+
+  cancel_running (m);
+
+  if (m->filter)
+    filter_unref (m->filter);
+  m->filter = NULL;
+
+  if (func == NULL)
+    {
+      if (destroy)
+        destroy (user_data);
+      publish (m, NULL);
+      return;
+    }
+
+  struct filter *f = g_atomic_rc_box_new (struct filter);
+  f->func = func;
+  f->data = user_data;
+  f->destroy = destroy;
+  m->filter = f;
+
+  ssw_filter_model_refilter (m);
+}
+
+gboolean
+ssw_filter_model_is_running (SswFilterModel *m)
+{
+  g_return_val_if_fail (SSW_IS_FILTER_MODEL (m), FALSE);
+
+  return m->running != NULL;
+}
+
+gint
+ssw_filter_model_get_child_row (SswFilterModel *m, gint row)
+{
+  g_return_val_if_fail (SSW_IS_FILTER_MODEL (m), -1);
+
+  if (m->visible == NULL)
+    return row;
+
+  if (row < 0 || row >= m->visible->len)
+    return -1;
+
+  return g_array_index (m->visible, guint, row);
+}
+
+
+/* The index of the first of VISIBLE which is not before child ROW */
+static guint
+lower_bound (GArray *visible, guint row)
+{
+  guint lo = 0, hi = visible->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (g_array_index (visible, guint, mid) < row)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+static void
+on_child_items_changed (GtkTreeModel *child, guint posn, guint rm, guint add,
+                        gpointer ud)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (ud);
+  GArray *visible = m->visible;
+
+  /* Until a filter has first been evaluated, every row is shown */
+  if (visible == NULL)
+    {
+      g_signal_emit (m, signals [ITEMS_CHANGED], 0, posn, rm, add);
+      if (m->filter)
+        ssw_filter_model_refilter (m);
+      return;
+    }
+
+  /* The visible rows which were among the RM rows of the child */
+  const guint lo = lower_bound (visible, posn);
+  const guint hi = lower_bound (visible, posn + rm);
+
+  /* Many rows changed in place stay visible until the filter has been
+     evaluated again */
+  if (rm == add && add > IMMEDIATE_ROWS)
+    {
+      if (hi > lo)
+        g_signal_emit (m, signals [ITEMS_CHANGED], 0, lo, hi - lo, hi - lo);
+      ssw_filter_model_refilter (m);
+      return;
+    }
+
+  /* The rows which followed the change move with it, so that VISIBLE
+     never refers to a row beyond the end of the child */
+  guint i;
+  if (rm != add)
+    for (i = hi; i < visible->len; ++i)
+      g_array_index (visible, guint, i) += add - rm;
+
+  g_array_remove_range (visible, lo, hi - lo);
+
+  /* A few new rows are filtered at once */
+  guint n_added = 0;
+  if (add <= IMMEDIATE_ROWS)
+    {
+      struct filter *f = m->filter;
+      GArray *added = g_array_new (FALSE, FALSE, sizeof (guint));
+      guint r;
+
+      for (r = posn; r < posn + add; ++r)
+        if (f->func (m->child, r, f->data))
+          g_array_append_val (added, r);
+
+      n_added = added->len;
+      g_array_insert_vals (visible, lo, added->data, n_added);
+      g_array_free (added, TRUE);
+    }
+
+  if (hi > lo || n_added > 0)
+    g_signal_emit (m, signals [ITEMS_CHANGED], 0, lo, hi - lo, n_added);
+
+  /* A filter which is running may have read the rows before they
+     changed, and numbers them as they were */
+  if (add > IMMEDIATE_ROWS || m->running)
+    ssw_filter_model_refilter (m);
+}
+
+static void
+on_child_row_changed (GtkTreeModel *child, GtkTreePath *path,
+                      GtkTreeIter *iter, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  on_child_items_changed (child, row, 1, 1, ud);
+}
+
+static void
+on_child_row_inserted (GtkTreeModel *child, GtkTreePath *path,
+                       GtkTreeIter *iter, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  on_child_items_changed (child, row, 0, 1, ud);
+}
+
+static void
+on_child_row_deleted (GtkTreeModel *child, GtkTreePath *path, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  on_child_items_changed (child, row, 1, 0, ud);
+}
+
+
+static  gint
+__iter_n_children (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+  return m->visible ? m->visible->len : n_child_rows (m);
+}
+
+static gint
+__get_n_columns  (GtkTreeModel *tree_model)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+  return gtk_tree_model_get_n_columns (m->child);
+}
+
+static gboolean
+__iter_nth_child  (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter,
+                   GtkTreeIter  *parent,
+                   gint          n)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+
+  g_assert (parent == NULL);
+
+  if (n < 0 || n >= __iter_n_children (tree_model, NULL))
+    return FALSE;
+
+  iter->stamp = m->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+  return TRUE;
+}
+
+static void
+__get_value (GtkTreeModel *tree_model,
+             GtkTreeIter  *iter,
+             gint          column,
+             GValue       *value)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+  g_return_if_fail (iter->stamp == m->stamp);
+
+  gint row = ssw_filter_model_get_child_row (m, GPOINTER_TO_INT (iter->user_data));
+
+  /* The row may have been deleted from the child since the filter
+     was last evaluated */
+  GtkTreeIter child_iter;
+  if (row >= 0 && gtk_tree_model_iter_nth_child (m->child, &child_iter, NULL, row))
+    gtk_tree_model_get_value (m->child, &child_iter, column, value);
+  else
+    g_value_init (value, gtk_tree_model_get_column_type (m->child, column));
+}
+
+static GType
+__get_type (GtkTreeModel *tree_model,
+            gint col)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+  return gtk_tree_model_get_column_type (m->child, col);
+}
+
+static GtkTreePath *
+__get_path (GtkTreeModel *tree_model,
+            GtkTreeIter  *iter)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (tree_model);
+  g_return_val_if_fail (iter->stamp == m->stamp, NULL);
+  return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+}
+
+static GtkTreeModelFlags
+__get_flags (GtkTreeModel *tm)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+
+static void
+__init_iface (GtkTreeModelIface *iface)
+{
+  iface->iter_n_children = __iter_n_children;
+  iface->get_n_columns = __get_n_columns;
+  iface->iter_nth_child = __iter_nth_child;
+  iface->get_value = __get_value;
+  iface->get_column_type = __get_type;
+  iface->get_path = __get_path;
+  iface->get_flags = __get_flags;
+}
+
+G_DEFINE_TYPE_WITH_CODE (SswFilterModel, ssw_filter_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL, __init_iface));
+
+
+static void
+__dispose (GObject *obj)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (obj);
+
+  if (m->dispose_has_run)
+    return;
+
+  m->dispose_has_run = TRUE;
+
+  cancel_running (m);
+
+  if (m->filter)
+    filter_unref (m->filter);
+  m->filter = NULL;
+
+  g_clear_object (&m->child);
+
+  G_OBJECT_CLASS (ssw_filter_model_parent_class)->dispose (obj);
+}
+
+static void
+__finalize (GObject *obj)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (obj);
+
+  if (m->visible)
+    g_array_unref (m->visible);
+
+  G_OBJECT_CLASS (ssw_filter_model_parent_class)->finalize (obj);
+}
+
+
+enum
+  {
+   PROP_0,
+   PROP_CHILD,
+   PROP_THREAD_SAFE_READ
+  };
+
+static void
+set_child (SswFilterModel *m, GtkTreeModel *child)
+{
+  m->child = g_object_ref (child);
+
+  if (g_signal_lookup ("items-changed", G_OBJECT_TYPE (child)))
+    {
+      g_signal_connect_object (child, "items-changed",
+                               G_CALLBACK (on_child_items_changed), m, 0);
+    }
+  else
+    {
+      g_signal_connect_object (child, "row-inserted",
+                               G_CALLBACK (on_child_row_inserted), m, 0);
+      g_signal_connect_object (child, "row-deleted",
+                               G_CALLBACK (on_child_row_deleted), m, 0);
+      g_signal_connect_object (child, "row-changed",
+                               G_CALLBACK (on_child_row_changed), m, 0);
+    }
+}
+
+/* GObject vfuncs {{{ */
+static void
+__set_property (GObject *object,
+                guint prop_id, const GValue *value, GParamSpec * pspec)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      set_child (m, g_value_get_object (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+__get_property (GObject * object,
+                guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  SswFilterModel *m = SSW_FILTER_MODEL (object);
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      g_value_set_object (value, m->child);
+      break;
+    case PROP_THREAD_SAFE_READ:
+      /* Reading never changes this model, so it is as safe as its child */
+      g_value_set_boolean (value, ssw_data_model_is_thread_safe (m->child));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+ssw_filter_model_class_init (SswFilterModelClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = __set_property;
+  object_class->get_property = __get_property;
+  object_class->dispose = __dispose;
+  object_class->finalize = __finalize;
+
+  GParamSpec *child_spec =
+    g_param_spec_object ("child-model",
+                         P_("Child Model"),
+                         P_("The model whose rows are to be filtered"),
+                         GTK_TYPE_TREE_MODEL,
+                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *thread_safe_read_spec =
+    g_param_spec_boolean ("thread-safe-read",
+                          P_("Thread Safe Read"),
+                          P_("True if the model may be read from several threads at once"),
+                          FALSE,
+                          G_PARAM_READABLE);
+
+  g_object_class_install_property (object_class,
+                                   PROP_CHILD,
+                                   child_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_THREAD_SAFE_READ,
+                                   thread_safe_read_spec);
+
+  signals [ITEMS_CHANGED] =
+    g_signal_new ("items-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_generic,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT);
+}
+
+static void
+ssw_filter_model_init (SswFilterModel *m)
+{
+  m->child = NULL;
+  m->visible = NULL;
+  m->filter = NULL;
+  m->running = NULL;
+  m->stamp = g_random_int ();
+  m->dispose_has_run = FALSE;
+}
+
+
+GObject *
+ssw_filter_model_new (GtkTreeModel *child)
+{
+  return g_object_new (SSW_TYPE_FILTER_MODEL,
+                       "child-model", child,
+                       NULL);
+}
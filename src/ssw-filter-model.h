@@ -0,0 +1,95 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* An implementation of GtkTreeModel which presents only those rows
+   of a CHILD model for which a predicate holds.  The model holds
+   a vector of the child's row numbers.
+
+   The predicate is evaluated in worker threads, over blocks of rows
+   concurrently.  Meanwhile the previous result remains visible, and
+   the model may be used as normal.  When the new result is complete,
+   a single "items-changed" signal is emitted for the range of rows
+   which differs from the previous result.  No per-row signals are
+   emitted.
+
+   Changes to the child are reported at once, at the visible rows
+   which they affect.  Rows inserted or changed in small numbers are
+   filtered on the thread which changed them.  Larger changes are
+   filtered again in the background.
+
+   Rows reported by the sheet are rows of this model.  Use
+   ssw_filter_model_get_child_row to find the corresponding row of the
+   child.
+*/
+
+#ifndef _SSW_FILTER_MODEL_H
+#define _SSW_FILTER_MODEL_H
+
+#include <gtk/gtk.h>
+
+/* Returns TRUE if ROW of CHILD should be visible.  This function is
+   called from worker threads, so it, and the child model's get_value
+   implementation, must be safe to call concurrently.  */
+typedef gboolean (*ssw_filter_func) (GtkTreeModel *child, gint row,
+                                     gpointer user_data);
+
+struct _SswFilterModel
+{
+  GObject parent_instance;
+
+  GtkTreeModel *child;
+
+  /* The child rows which are visible, or NULL if there is no filter */
+  GArray *visible;
+
+  /* The predicate, or NULL.  This is reference counted since
+     running filters hold it too */
+  gpointer filter;
+
+  /* Used to abandon a filter which is running */
+  GCancellable *running;
+
+  guint32 stamp;
+  gboolean dispose_has_run;
+};
+
+struct _SswFilterModelClass
+{
+  GObjectClass parent_class;
+};
+
+#define SSW_TYPE_FILTER_MODEL ssw_filter_model_get_type ()
+
+G_DECLARE_FINAL_TYPE (SswFilterModel, ssw_filter_model, SSW, FILTER_MODEL, GObject)
+
+  GObject * ssw_filter_model_new (GtkTreeModel *child);
+
+/* Start filtering the child's rows with FUNC.  If FUNC is NULL, all
+   rows become visible.  Any filter already running is abandoned.  */
+void ssw_filter_model_set_filter (SswFilterModel *m, ssw_filter_func func,
+                                  gpointer user_data, GDestroyNotify destroy);
+
+/* Evaluate the current filter again */
+void ssw_filter_model_refilter (SswFilterModel *m);
+
+/* Returns TRUE if a filter is being evaluated */
+gboolean ssw_filter_model_is_running (SswFilterModel *m);
+
+gint ssw_filter_model_get_child_row (SswFilterModel *m, gint row);
+
+#endif
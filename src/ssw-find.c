@@ -0,0 +1,529 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <string.h>
+#include "ssw-find.h"
+#include "ssw-aggregate.h"
+#include "ssw-data-model.h"
+#include "ssw-parallel.h"
+#include "ssw-permutation.h"
+
+/* The number of cells searched by each task.  A step of the search
+   blocks the main loop, so this is kept small enough for one to take
+   no more than a few milliseconds.  */
+#define FIND_BLOCK_CELLS 8192
+
+/* The number of tasks performed at each step, if the model may be
+   read by several threads, and if it may not */
+#define FIND_PARALLEL_BLOCKS 8
+#define FIND_SERIAL_BLOCKS 1
+
+/* A cell of the view */
+struct match
+{
+  gint col;
+  gint row;
+};
+
+/* The rows ROW0 .. ROW0 + N_ROWS - 1 of the view, and the cells among
+   them which match */
+struct block
+{
+  gint row0;
+  gint n_rows;
+  GArray *matches;
+};
+
+/* The rows ROW0 .. ROW0 + N_ROWS - 1 of the view */
+struct rows
+{
+  gint row0;
+  gint n_rows;
+};
+
+struct ssw_finder
+{
+  SswSheet *sheet;
+
+  /* What is sought.  TEXT is NULL if there is no search.  */
+  gchar *text;
+  SswFindMode mode;
+  gboolean case_sensitive;
+  GRegex *regex;
+  gdouble number;
+  ssw_sheet_forward_conversion_func cf;
+
+  /* The extent of the model, and the next row of the view to search */
+  gint n_rows;
+  gint n_cols;
+  gint rows_per_block;
+  gint next_row;
+  gboolean rows_in_order;
+
+  struct block blocks[FIND_PARALLEL_BLOCKS];
+
+  /* The matches found so far, row by row */
+  GArray *matches;
+
+  /* The rows before NEXT_ROW whose data have changed since they were
+     searched, as an array of struct rows.  They are searched again
+     before the search goes on.  */
+  GArray *stale;
+
+  guint idle_id;
+};
+
+/* Returns TRUE if the cell at MCOL, MROW of the model, whose value is
+   V, is one which F seeks.  */
+static gboolean
+cell_matches (const struct ssw_finder *f, gint mcol, gint mrow, const GValue *v)
+{
+  gboolean match = FALSE;
+
+  if (!G_IS_VALUE (v) || SSW_VALUE_HOLDS_PENDING (v))
+    return FALSE;
+
+  if (f->mode == SSW_FIND_NUMBER)
+    {
+      gdouble x;
+      return ssw_value_get_number (v, &x) && x == f->number;
+    }
+
+  gchar *s = f->cf (f->sheet, f->sheet->data_model, mcol, mrow, v);
+  if (s == NULL)
+    return FALSE;
+
+  if (f->mode == SSW_FIND_REGEX)
+    match = g_regex_match (f->regex, s, 0, NULL);
+  else if (f->case_sensitive)
+    match = (strstr (s, f->text) != NULL);
+  else
+    {
+      gchar *folded = g_utf8_casefold (s, -1);
+      match = (strstr (folded, f->text) != NULL);
+      g_free (folded);
+    }
+
+  g_free (s);
+
+  return match;
+}
+
+/* An ssw_parallel_func searching the TASKth block of the step */
+static void
+search_block (gint task, gpointer data)
+{
+  struct ssw_finder *f = data;
+  struct block *b = &f->blocks[task];
+  GtkTreeModel *model = f->sheet->data_model;
+  gint i, col;
+
+  g_array_set_size (b->matches, 0);
+
+  if (f->rows_in_order
+      && ssw_data_model_is_block_empty (model, 0, b->row0, f->n_cols, b->n_rows))
+    return;
+
+  GValue *values = g_new0 (GValue, (gsize) f->n_cols * b->n_rows);
+
+  if (f->rows_in_order)
+    ssw_data_model_fetch_block (model, 0, b->row0, f->n_cols, b->n_rows, values);
+  else
+    for (i = 0; i < b->n_rows; ++i)
+      ssw_data_model_fetch_block (model, 0,
+                                  ssw_sheet_get_model_row (f->sheet, b->row0 + i),
+                                  f->n_cols, 1, values + (gsize) i * f->n_cols);
+
+  for (i = 0; i < b->n_rows; ++i)
+    {
+      gint mrow = ssw_sheet_get_model_row (f->sheet, b->row0 + i);
+      GValue *row_values = values + (gsize) i * f->n_cols;
+
+      for (col = 0; col < f->n_cols; ++col)
+        {
+          gint mcol = ssw_sheet_get_model_column (f->sheet, col);
+          if (mcol < 0 || mcol >= f->n_cols)
+            continue;
+
+          if (cell_matches (f, mcol, mrow, &row_values[mcol]))
+            {
+              struct match m = {col, b->row0 + i};
+              g_array_append_val (b->matches, m);
+            }
+        }
+
+      for (col = 0; col < f->n_cols; ++col)
+        if (G_IS_VALUE (&row_values[col]))
+          g_value_unset (&row_values[col]);
+    }
+
+  g_free (values);
+}
+
+/* Search again the first of the stale rows, replacing their matches */
+static void
+search_stale (struct ssw_finder *f)
+{
+  struct rows *r = &g_array_index (f->stale, struct rows, 0);
+  struct block *b = &f->blocks[0];
+
+  b->row0 = r->row0;
+  b->n_rows = MIN (f->rows_per_block, r->n_rows);
+  r->row0 += b->n_rows;
+  r->n_rows -= b->n_rows;
+  if (r->n_rows == 0)
+    g_array_remove_index (f->stale, 0);
+
+  search_block (0, f);
+
+  gint lo = ssw_finder_lookup (f, 0, b->row0);
+  gint hi = ssw_finder_lookup (f, 0, b->row0 + b->n_rows);
+
+  if (hi > lo)
+    g_array_remove_range (f->matches, lo, hi - lo);
+
+  if (b->matches->len > 0)
+    g_array_insert_vals (f->matches, lo, b->matches->data, b->matches->len);
+
+  if (hi > lo || b->matches->len > 0)
+    gtk_widget_queue_draw (GTK_WIDGET (f->sheet));
+
+  if (b->matches->len > 0)
+    g_signal_emit_by_name (f->sheet, "find-matches", lo, b->matches->len);
+}
+
+/* Search the next rows which the search has not yet reached */
+static void
+search_onwards (struct ssw_finder *f)
+{
+  GtkTreeModel *model = f->sheet->data_model;
+  gint i;
+
+  /* The conversion function is called from several threads only if
+     the sheet permits it */
+  gboolean parallel = model && ssw_data_model_is_thread_safe (model)
+    && (f->cf == ssw_sheet_default_forward_conversion
+        || f->sheet->thread_safe_conversion);
+  gint n_tasks = 0;
+
+  while (n_tasks < (parallel ? FIND_PARALLEL_BLOCKS : FIND_SERIAL_BLOCKS)
+         && f->next_row < f->n_rows)
+    {
+      struct block *b = &f->blocks[n_tasks++];
+      b->row0 = f->next_row;
+      b->n_rows = MIN (f->rows_per_block, f->n_rows - f->next_row);
+      f->next_row += b->n_rows;
+    }
+
+  if (n_tasks > 1)
+    ssw_parallel_for (n_tasks, search_block, f);
+  else if (n_tasks == 1)
+    search_block (0, f);
+
+  /* The blocks were taken in order, so the matches remain in order */
+  gint first = f->matches->len;
+  for (i = 0; i < n_tasks; ++i)
+    g_array_append_vals (f->matches, f->blocks[i].matches->data,
+                         f->blocks[i].matches->len);
+
+  if (f->matches->len > first)
+    {
+      gtk_widget_queue_draw (GTK_WIDGET (f->sheet));
+      g_signal_emit_by_name (f->sheet, "find-matches",
+                             first, f->matches->len - first);
+    }
+}
+
+static gboolean
+find_idle (gpointer data)
+{
+  struct ssw_finder *f = data;
+
+  if (f->stale->len > 0)
+    search_stale (f);
+  else
+    search_onwards (f);
+
+  if (f->stale->len > 0 || f->next_row < f->n_rows)
+    return G_SOURCE_CONTINUE;
+
+  f->idle_id = 0;
+  g_signal_emit_by_name (f->sheet, "find-done", f->matches->len);
+
+  return G_SOURCE_REMOVE;
+}
+
+struct ssw_finder *
+ssw_finder_new (SswSheet *sheet)
+{
+  struct ssw_finder *f = g_malloc0 (sizeof *f);
+  gint i;
+
+  f->sheet = sheet;
+  f->matches = g_array_new (FALSE, FALSE, sizeof (struct match));
+  f->stale = g_array_new (FALSE, FALSE, sizeof (struct rows));
+  for (i = 0; i < FIND_PARALLEL_BLOCKS; ++i)
+    f->blocks[i].matches = g_array_new (FALSE, FALSE, sizeof (struct match));
+
+  return f;
+}
+
+void
+ssw_finder_free (struct ssw_finder *f)
+{
+  gint i;
+
+  if (f == NULL)
+    return;
+
+  ssw_finder_cancel (f);
+  g_array_free (f->matches, TRUE);
+  g_array_free (f->stale, TRUE);
+  for (i = 0; i < FIND_PARALLEL_BLOCKS; ++i)
+    g_array_free (f->blocks[i].matches, TRUE);
+  g_free (f);
+}
+
+void
+ssw_finder_cancel (struct ssw_finder *f)
+{
+  if (f->idle_id)
+    {
+      g_source_remove (f->idle_id);
+      f->idle_id = 0;
+    }
+
+  if (f->regex)
+    g_regex_unref (f->regex);
+  f->regex = NULL;
+
+  g_free (f->text);
+  f->text = NULL;
+
+  g_array_set_size (f->stale, 0);
+
+  if (f->matches->len > 0)
+    {
+      g_array_set_size (f->matches, 0);
+      gtk_widget_queue_draw (GTK_WIDGET (f->sheet));
+    }
+}
+
+gboolean
+ssw_finder_start (struct ssw_finder *f, const gchar *text,
+                  SswFindMode mode, gboolean case_sensitive)
+{
+  GtkTreeModel *model = f->sheet->data_model;
+
+  ssw_finder_cancel (f);
+
+  g_return_val_if_fail (text, FALSE);
+
+  /* An empty string would match every cell */
+  if (text[0] == '\0')
+    return FALSE;
+
+  switch (mode)
+    {
+    case SSW_FIND_REGEX:
+      f->regex = g_regex_new (text,
+                              G_REGEX_OPTIMIZE
+                              | (case_sensitive ? 0 : G_REGEX_CASELESS),
+                              0, NULL);
+      if (f->regex == NULL)
+        return FALSE;
+      f->text = g_strdup (text);
+      break;
+    case SSW_FIND_NUMBER:
+      {
+        GValue v = G_VALUE_INIT;
+        gboolean ok;
+
+        g_value_init (&v, G_TYPE_STRING);
+        g_value_set_string (&v, text);
+        ok = ssw_value_get_number (&v, &f->number);
+        g_value_unset (&v);
+        if (!ok)
+          return FALSE;
+        f->text = g_strdup (text);
+      }
+      break;
+    default:
+      f->text = case_sensitive ? g_strdup (text) : g_utf8_casefold (text, -1);
+      break;
+    }
+
+  f->mode = mode;
+  f->case_sensitive = case_sensitive;
+
+  g_object_get (f->sheet->selected_body, "forward-conversion", &f->cf, NULL);
+  if (f->cf == NULL)
+    f->cf = ssw_sheet_default_forward_conversion;
+
+  f->n_rows = model ? gtk_tree_model_iter_n_children (model, NULL) : 0;
+  f->n_cols = model ? gtk_tree_model_get_n_columns (model) : 0;
+  f->rows_per_block = MAX (1, FIND_BLOCK_CELLS / MAX (1, f->n_cols));
+  f->rows_in_order = ssw_permutation_is_identity (f->sheet->row_order);
+  f->next_row = (f->n_cols > 0) ? 0 : f->n_rows;
+
+  f->idle_id = g_idle_add (find_idle, f);
+
+  return TRUE;
+}
+
+void
+ssw_finder_restart (struct ssw_finder *f)
+{
+  if (f->text == NULL)
+    return;
+
+  gchar *text = g_strdup (f->text);
+  ssw_finder_start (f, text, f->mode, f->case_sensitive);
+  g_free (text);
+}
+
+/* The row to which ROW moves when the rows POSN .. POSN + RM - 1 are
+   replaced by ADD others.  Rows which were removed move to POSN.  */
+static gint
+shift_row (gint row, gint posn, gint rm, gint add)
+{
+  if (row <= posn)
+    return row;
+
+  if (row >= posn + rm)
+    return row + add - rm;
+
+  return posn;
+}
+
+/* Mark the rows ROW0 .. ROW0 + N_ROWS - 1 to be searched again */
+static void
+add_stale (struct ssw_finder *f, gint row0, gint n_rows)
+{
+  if (n_rows <= 0)
+    return;
+
+  if (f->stale->len > 0)
+    {
+      struct rows *last =
+        &g_array_index (f->stale, struct rows, f->stale->len - 1);
+
+      if (row0 <= last->row0 + last->n_rows && row0 + n_rows >= last->row0)
+        {
+          gint end = MAX (last->row0 + last->n_rows, row0 + n_rows);
+          last->row0 = MIN (last->row0, row0);
+          last->n_rows = end - last->row0;
+          return;
+        }
+    }
+
+  struct rows r = {row0, n_rows};
+  g_array_append_val (f->stale, r);
+}
+
+void
+ssw_finder_update (struct ssw_finder *f, gint posn, gint rm, gint add)
+{
+  gint i;
+
+  if (f->text == NULL)
+    return;
+
+  /* The changed rows of the model cannot be found in a view whose
+     rows have been reordered */
+  if (!f->rows_in_order || !ssw_permutation_is_identity (f->sheet->row_order))
+    {
+      ssw_finder_restart (f);
+      return;
+    }
+
+  if (rm != add)
+    {
+      /* Forget the matches in the rows removed, and move those after */
+      gint lo = ssw_finder_lookup (f, 0, posn);
+      gint hi = ssw_finder_lookup (f, 0, posn + rm);
+
+      if (hi > lo)
+        g_array_remove_range (f->matches, lo, hi - lo);
+
+      for (i = lo; i < f->matches->len; ++i)
+        g_array_index (f->matches, struct match, i).row += add - rm;
+
+      for (i = f->stale->len - 1; i >= 0; --i)
+        {
+          struct rows *r = &g_array_index (f->stale, struct rows, i);
+          gint start = shift_row (r->row0, posn, rm, add);
+          gint end = shift_row (r->row0 + r->n_rows, posn, rm, add);
+
+          if (end > start)
+            {
+              r->row0 = start;
+              r->n_rows = end - start;
+            }
+          else
+            g_array_remove_index (f->stale, i);
+        }
+
+      f->n_rows += add - rm;
+      f->next_row = shift_row (f->next_row, posn, rm, add);
+      gtk_widget_queue_draw (GTK_WIDGET (f->sheet));
+    }
+
+  /* Rows which the search has yet to reach need not be marked */
+  add_stale (f, posn, MIN (posn + add, f->next_row) - posn);
+
+  if (f->idle_id == 0 && f->stale->len > 0)
+    f->idle_id = g_idle_add (find_idle, f);
+}
+
+gint
+ssw_finder_get_n_matches (const struct ssw_finder *f)
+{
+  return f->matches->len;
+}
+
+void
+ssw_finder_get_match (const struct ssw_finder *f, gint i,
+                      gint *col, gint *row)
+{
+  g_return_if_fail (i >= 0 && i < f->matches->len);
+
+  const struct match *m = &g_array_index (f->matches, struct match, i);
+  *col = m->col;
+  *row = m->row;
+}
+
+gint
+ssw_finder_lookup (const struct ssw_finder *f, gint col, gint row)
+{
+  guint lo = 0;
+  guint hi = f->matches->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      const struct match *m = &g_array_index (f->matches, struct match, mid);
+      if (m->row < row || (m->row == row && m->col < col))
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
@@ -0,0 +1,66 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A search of the cells of a sheet.  The rows are searched a block at
+   a time whilst the main loop is idle, spreading each block over
+   several threads if the data model permits.  The cells which match
+   are held in the order of the view, row by row, and are announced by
+   the sheet's "find-matches" signal as they are found.  The sheet's
+   "find-done" signal is emitted when the search is complete.  */
+
+#ifndef _SSW_FIND_H
+#define _SSW_FIND_H
+
+#include "ssw-sheet.h"
+
+struct ssw_finder;
+
+struct ssw_finder *ssw_finder_new (SswSheet *sheet);
+void ssw_finder_free (struct ssw_finder *f);
+
+/* Begin searching for TEXT, abandoning any search in progress.
+   Returns FALSE, and searches for nothing, if TEXT is empty, or is not
+   a valid regular expression or number as MODE requires.  */
+gboolean ssw_finder_start (struct ssw_finder *f, const gchar *text,
+                           SswFindMode mode, gboolean case_sensitive);
+
+/* Abandon any search in progress, and forget its matches */
+void ssw_finder_cancel (struct ssw_finder *f);
+
+/* Search again for what was last sought, if anything, because the
+   data or its order has changed */
+void ssw_finder_restart (struct ssw_finder *f);
+
+/* Bring the search up to date after the rows POSN .. POSN + RM - 1 of
+   the data model have been replaced by ADD others.  Only the rows which
+   the search has passed, and whose data have changed, are searched
+   again.  */
+void ssw_finder_update (struct ssw_finder *f, gint posn, gint rm, gint add);
+
+gint ssw_finder_get_n_matches (const struct ssw_finder *f);
+
+/* Store the column and row of the Ith match in COL and ROW */
+void ssw_finder_get_match (const struct ssw_finder *f, gint i,
+                           gint *col, gint *row);
+
+/* Return the index of the first match which lies at or after the cell
+   COL, ROW, taking the cells row by row.  Returns the number of matches
+   if there is none.  */
+gint ssw_finder_lookup (const struct ssw_finder *f, gint col, gint row);
+
+#endif
@@ -17,85 +17,631 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include <glib.h>
 
 #include "ssw-paste.h"
 
+/* A tokenizer for the tables in HTML copied from browsers and office
+   applications.  Such markup is rarely well formed, so rather than
+   validating it, the tokenizer recognises only the elements which
+   delimit tables, rows, cells and lines, and ignores everything else.
+   End tags may be omitted, as HTML allows.  The text of each cell is
+   decoded in place, so no memory is allocated for it.  */
+
+#define IS_SPACE(C) ((C) == ' ' || (C) == '\t' || (C) == '\n' \
+                     || (C) == '\r' || (C) == '\f')
+
+enum tag_id
+  {
+   TAG_OTHER,
+   TAG_TABLE,
+   TAG_ROW,
+   TAG_CELL,
+   TAG_BREAK,
+   TAG_BLOCK,
+   TAG_RAW
+  };
+
+struct tag
+{
+  enum tag_id id;
+  gboolean closing;
+  const gchar *name;
+  gsize name_len;
+  gint colspan;
+  gint rowspan;
+};
+
+struct html_parser
+{
+  /* The depth of nesting of tables.  Only the outermost is pasted */
+  gint depth;
+
+  gboolean row_open;
+
+  /* The column at which the next cell in the row is placed */
+  gint col;
+
+  /* For each column, the number of rows, including the current one,
+     which are covered by a cell spanning down from above.  */
+  GArray *spans;
+
+  /* The cell whose text is being decoded.  Its text is written back
+     to the buffer, between CELL and W.  */
+  gboolean in_cell;
+  gint cell_col;
+  gchar *cell;
+  gchar *w;
+  gboolean space;
+  gboolean newline;
+};
+
 static void
-start_element (GMarkupParseContext *context,
-               const gchar *element_name,
-               const gchar **attribute_names,
-               const gchar **attribute_values,
-               gpointer user_data,
-               GError **error)
+html_parser_free (gpointer data)
+{
+  struct html_parser *hp = data;
+
+  g_array_free (hp->spans, TRUE);
+  g_free (hp);
+}
+
+#define NAME_IS(NAME, LEN, S) \
+  ((LEN) == sizeof (S) - 1 && 0 == g_ascii_strncasecmp ((NAME), (S), (LEN)))
+
+static enum tag_id
+identify_tag (const gchar *name, gsize len)
+{
+  /* This is called for every tag, so avoid comparing names which
+     cannot match.  */
+  switch (len)
+    {
+    case 1:
+      return NAME_IS (name, len, "p") ? TAG_BLOCK : TAG_OTHER;
+    case 2:
+      if (NAME_IS (name, len, "td") || NAME_IS (name, len, "th"))
+        return TAG_CELL;
+      if (NAME_IS (name, len, "tr"))
+        return TAG_ROW;
+      if (NAME_IS (name, len, "br"))
+        return TAG_BREAK;
+      if (NAME_IS (name, len, "li"))
+        return TAG_BLOCK;
+      break;
+    case 3:
+      return NAME_IS (name, len, "div") ? TAG_BLOCK : TAG_OTHER;
+    case 5:
+      if (NAME_IS (name, len, "table"))
+        return TAG_TABLE;
+      if (NAME_IS (name, len, "style"))
+        return TAG_RAW;
+      break;
+    case 6:
+      return NAME_IS (name, len, "script") ? TAG_RAW : TAG_OTHER;
+    }
+
+  return TAG_OTHER;
+}
+
+/* Return the value of a colspan or rowspan attribute, between VAL and
+   END, clamped to at least one and at most MAX.  */
+static gint
+parse_span (const gchar *val, const gchar *end, gint max)
+{
+  gint n = 0;
+
+  while (val < end && IS_SPACE (*val))
+    val++;
+
+  while (val < end && g_ascii_isdigit (*val) && n < max)
+    n = n * 10 + (*val++ - '0');
+
+  return CLAMP (n, 1, max);
+}
+
+/* Skip to the character after the next '>' at or after P */
+static const gchar *
+skip_to_gt (const gchar *p, const gchar *end)
+{
+  const gchar *gt = memchr (p, '>', end - p);
+  return gt ? gt + 1 : end;
+}
+
+/* Parse the markup at P, which is a '<'.  Return the position
+   following it, having filled in TAG.  Return NULL if P does not
+   begin a tag, in which case the '<' is text.  Comments, doctypes and
+   processing instructions are returned as TAG_OTHER.  */
+static const gchar *
+parse_tag (const gchar *p, const gchar *end, struct tag *tag)
 {
-  struct paste_state *state = user_data;
+  const gchar *q = p + 1;
 
-  if (0 == g_ascii_strcasecmp ("table", element_name))
+  tag->id = TAG_OTHER;
+  tag->closing = FALSE;
+  tag->name = NULL;
+  tag->name_len = 0;
+  tag->colspan = 1;
+  tag->rowspan = 1;
+
+  if (q < end && *q == '!')
     {
-      state->row = 0;
-      state->col = 0;
-      state->cell_element = FALSE;
+      if (end - q >= 3 && q[1] == '-' && q[2] == '-')
+        {
+          const gchar *c;
+          for (c = q + 3; (c = memchr (c, '>', end - c)); c++)
+            if (c - 2 >= q + 3 && c[-1] == '-' && c[-2] == '-')
+              return c + 1;
+          return end;
+        }
+      return skip_to_gt (q, end);
     }
-  else if (0 == g_ascii_strcasecmp ("tr", element_name))
+
+  if (q < end && *q == '?')
+    return skip_to_gt (q, end);
+
+  if (q < end && *q == '/')
     {
-      state->col = 0;
+      tag->closing = TRUE;
+      q++;
     }
-  else if (0 == g_ascii_strcasecmp ("td", element_name))
+
+  if (q >= end || !g_ascii_isalpha (*q))
+    return NULL;
+
+  tag->name = q;
+  while (q < end && g_ascii_isalnum (*q))
+    q++;
+  tag->name_len = q - tag->name;
+  tag->id = identify_tag (tag->name, tag->name_len);
+
+  /* The attributes.  Only the spans of cells are of interest */
+  while (q < end && *q != '>')
     {
-      state->cell_element = TRUE;
+      if (IS_SPACE (*q) || *q == '/')
+        {
+          q++;
+          continue;
+        }
+
+      const gchar *attr = q;
+      while (q < end && !IS_SPACE (*q) && *q != '=' && *q != '>' && *q != '/')
+        q++;
+      gsize attr_len = q - attr;
+
+      while (q < end && IS_SPACE (*q))
+        q++;
+
+      if (q >= end || *q != '=')
+        continue;
+
+      q++;
+      while (q < end && IS_SPACE (*q))
+        q++;
+
+      const gchar *val = q;
+      const gchar *val_end;
+      if (q < end && (*q == '"' || *q == '\''))
+        {
+          gchar quote = *q++;
+          val = q;
+          q = memchr (q, quote, end - q);
+          if (q == NULL)
+            q = end;
+          val_end = q;
+          if (q < end)
+            q++;
+        }
+      else
+        {
+          while (q < end && !IS_SPACE (*q) && *q != '>')
+            q++;
+          val_end = q;
+        }
+
+      if (tag->id != TAG_CELL)
+        continue;
+
+      if (attr_len == 7 && 0 == g_ascii_strncasecmp (attr, "colspan", 7))
+        tag->colspan = parse_span (val, val_end, 1000);
+      else if (attr_len == 7 && 0 == g_ascii_strncasecmp (attr, "rowspan", 7))
+        tag->rowspan = parse_span (val, val_end, 65534);
     }
+
+  return q < end ? q + 1 : end;
 }
 
-static void
-end_element (GMarkupParseContext *context,
-             const gchar *element_name,
-             gpointer user_data,
-             GError **error)
+/* Return the position of the end tag of the raw text element NAME,
+   such as a script, at or after P.  */
+static const gchar *
+skip_raw_text (const gchar *p, const gchar *end, const gchar *name, gsize len)
+{
+  while ((p = memchr (p, '<', end - p)))
+    {
+      if (end - p > len + 1 && p[1] == '/'
+          && 0 == g_ascii_strncasecmp (p + 2, name, len))
+        return p;
+      p++;
+    }
+
+  return end;
+}
+
+/* The named character references which are commonly found in tables.
+   An empty replacement is white space.  */
+static const struct
+{
+  const gchar *name;
+  const gchar *utf8;
+} entities[] =
+  {
+   {"amp", "&"},
+   {"lt", "<"},
+   {"gt", ">"},
+   {"quot", "\""},
+   {"apos", "'"},
+   {"nbsp", ""},
+   {"ensp", ""},
+   {"emsp", ""},
+   {"thinsp", ""},
+   {"shy", NULL},
+   {"copy", "©"},
+   {"reg", "®"},
+   {"deg", "°"},
+   {"plusmn", "±"},
+   {"micro", "µ"},
+   {"middot", "·"},
+   {"times", "×"},
+   {"divide", "÷"},
+   {"cent", "¢"},
+   {"pound", "£"},
+   {"yen", "¥"},
+   {"euro", "€"},
+   {"sect", "§"},
+   {"para", "¶"},
+   {"laquo", "«"},
+   {"raquo", "»"},
+   {"lsquo", "‘"},
+   {"rsquo", "’"},
+   {"ldquo", "“"},
+   {"rdquo", "”"},
+   {"ndash", "–"},
+   {"mdash", "—"},
+   {"hellip", "…"},
+   {"sup2", "²"},
+   {"sup3", "³"},
+   {"frac14", "¼"},
+   {"frac12", "½"},
+   {"frac34", "¾"}
+  };
+
+/* Decode the character reference at P, which is a '&', into OUT.
+   Return the position following it, and set *N to the number of
+   bytes written, or to -1 if the reference stands for white space.
+   A reference which is not recognised is decoded as a literal '&'.
+   The decoded form is never longer than the reference.  */
+static const gchar *
+decode_entity (const gchar *p, const gchar *end, gchar *out, gint *n)
 {
-  struct paste_state *state = user_data;
+  const gchar *q = p + 1;
 
-  if (0 == g_ascii_strcasecmp ("table", element_name))
+  if (q < end && *q == '#')
     {
-      state->row = -1;
-      state->col = -1;
+      gboolean hex = (q + 1 < end && (q[1] == 'x' || q[1] == 'X'));
+      const gchar *digits = q = q + (hex ? 2 : 1);
+      gunichar c = 0;
+
+      while (q < end && (hex ? g_ascii_isxdigit (*q) : g_ascii_isdigit (*q)))
+        {
+          if (c <= 0x10FFFF)
+            c = c * (hex ? 16 : 10)
+              + (hex ? g_ascii_xdigit_value (*q) : g_ascii_digit_value (*q));
+          q++;
+        }
+
+      if (q > digits)
+        {
+          if (q < end && *q == ';')
+            q++;
+
+          if (c == 0xA0)
+            {
+              *n = -1;
+              return q;
+            }
+
+          if (c == 0 || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+            c = 0xFFFD;
+
+          *n = g_unichar_to_utf8 (c, out);
+          return q;
+        }
     }
-  else if (0 == g_ascii_strcasecmp ("tr", element_name))
+  else
     {
-      state->row++;
-      state->col = -1;
+      while (q < end && q - p <= 8 && g_ascii_isalnum (*q))
+        q++;
+
+      if (q < end && *q == ';')
+        {
+          gsize len = q - (p + 1);
+          gint i;
+          for (i = 0; i < G_N_ELEMENTS (entities); ++i)
+            if (strlen (entities[i].name) == len
+                && 0 == strncmp (entities[i].name, p + 1, len))
+              {
+                const gchar *utf8 = entities[i].utf8;
+                if (utf8 == NULL)
+                  *n = 0;
+                else if (*utf8 == '\0')
+                  *n = -1;
+                else
+                  {
+                    *n = strlen (utf8);
+                    memcpy (out, utf8, *n);
+                  }
+                return q + 1;
+              }
+        }
     }
-  else if (0 == g_ascii_strcasecmp ("td", element_name))
+
+  *out = '&';
+  *n = 1;
+  return p + 1;
+}
+
+/* Decode the text of the current cell, from P up to the next tag.
+   White space is collapsed, and line breaks are kept only between
+   pieces of text.  */
+static gchar *
+cell_text (struct html_parser *hp, gchar *p, gchar *end)
+{
+  gchar *w = hp->w;
+
+  while (p < end && *p != '<')
     {
-      state->col++;
-      state->cell_element = FALSE;
+      gchar buf[6];
+      const gchar *text = p;
+      gint n = 1;
+
+      if (IS_SPACE (*p))
+        {
+          hp->space = TRUE;
+          p++;
+          continue;
+        }
+
+      if (*p == '&')
+        {
+          p = (gchar *) decode_entity (p, end, buf, &n);
+          text = buf;
+          if (n < 0)
+            {
+              hp->space = TRUE;
+              continue;
+            }
+          if (n == 0)
+            continue;
+        }
+      else
+        p++;
+
+      /* Every separator is paid for by the white space or tag which
+         it replaces, so W never overtakes P.  */
+      if (w > hp->cell)
+        {
+          if (hp->newline)
+            *w++ = '\n';
+          else if (hp->space)
+            *w++ = ' ';
+        }
+      hp->space = hp->newline = FALSE;
+
+      memmove (w, text, n);
+      w += n;
     }
+
+  hp->w = w;
+  return p;
+}
+
+static void
+start_cell (struct html_parser *hp, const struct tag *tag, gchar *text)
+{
+  GArray *spans = hp->spans;
+  gint col = hp->col;
+  gint c;
+
+  /* Skip the columns covered by cells spanning from rows above */
+  while (col < spans->len && g_array_index (spans, guint, col) > 0)
+    col++;
+
+  if (spans->len < col + tag->colspan)
+    g_array_set_size (spans, col + tag->colspan);
+
+  for (c = col; c < col + tag->colspan; ++c)
+    g_array_index (spans, guint, c) = tag->rowspan;
+
+  hp->cell_col = col;
+  hp->col = col + tag->colspan;
+
+  hp->in_cell = TRUE;
+  hp->cell = hp->w = text;
+  hp->space = hp->newline = FALSE;
 }
 
 static void
-text_i (GMarkupParseContext *context,
-      const gchar *text,
-      gsize text_len,
-      gpointer user_data,
-      GError **error)
-{
-  struct paste_state *state = user_data;
-  if (state->cell_element)
+end_cell (struct html_parser *hp, struct paste_state *ps)
+{
+  if (!hp->in_cell)
+    return;
+
+  /* W is at or before the tag which closed the cell, which has
+     already been consumed, or at the end of the data.  */
+  *hp->w = '\0';
+  ps->col = hp->cell_col;
+  ssw_sheet_paste_insert_datum (hp->cell, hp->w - hp->cell, ps);
+
+  hp->in_cell = FALSE;
+}
+
+/* Returns TRUE if a row was ended */
+static gboolean
+end_row (struct html_parser *hp, struct paste_state *ps)
+{
+  gint c;
+
+  end_cell (hp, ps);
+
+  if (!hp->row_open)
+    return FALSE;
+
+  for (c = 0; c < hp->spans->len; ++c)
+    if (g_array_index (hp->spans, guint, c) > 0)
+      g_array_index (hp->spans, guint, c)--;
+
+  ps->row++;
+  hp->col = 0;
+  hp->row_open = FALSE;
+
+  return TRUE;
+}
+
+/* Parse the LEN bytes of HTML at DATA, which must have room for a
+   terminating byte at DATA[LEN], pasting the cells of its tables.
+   Parsing stops after MAX_ROWS rows.  The number of bytes consumed is
+   returned, so that parsing may be resumed from that point.  A cell
+   is never left open between calls.  */
+static gsize
+parse_html (struct html_parser *hp, gchar *data, gsize len,
+            struct paste_state *ps, gint max_rows)
+{
+  gchar *p = data;
+  gchar *const end = data + len;
+  gint rows = 0;
+
+  while (p < end && rows < max_rows)
     {
-      GString *str = g_string_new_len (text, text_len);
-      ssw_sheet_paste_insert_datum (str->str, str->len, state);
-      g_string_free (str, TRUE);
+      struct tag tag;
+
+      if (hp->in_cell)
+        {
+          p = cell_text (hp, p, end);
+          if (p >= end)
+            break;
+        }
+      else
+        {
+          p = memchr (p, '<', end - p);
+          if (p == NULL)
+            {
+              p = end;
+              break;
+            }
+        }
+
+      gchar *next = (gchar *) parse_tag (p, end, &tag);
+      if (next == NULL)
+        {
+          /* A '<' which does not begin a tag is text */
+          if (hp->in_cell)
+            {
+              if (hp->w > hp->cell && (hp->space || hp->newline))
+                *hp->w++ = hp->newline ? '\n' : ' ';
+              hp->space = hp->newline = FALSE;
+              *hp->w++ = '<';
+            }
+          p++;
+          continue;
+        }
+      p = next;
+
+      if (tag.id == TAG_RAW && !tag.closing)
+        {
+          p = (gchar *) skip_raw_text (p, end, tag.name, tag.name_len);
+          continue;
+        }
+
+      if (tag.id == TAG_TABLE)
+        {
+          if (!tag.closing)
+            {
+              if (hp->depth++ == 0)
+                {
+                  ps->row = 0;
+                  hp->col = 0;
+                  hp->row_open = FALSE;
+                  g_array_set_size (hp->spans, 0);
+                }
+              else
+                hp->newline = TRUE;
+            }
+          else if (hp->depth > 0)
+            {
+              if (hp->depth == 1)
+                rows += end_row (hp, ps);
+              else
+                hp->newline = TRUE;
+              hp->depth--;
+            }
+          continue;
+        }
+
+      if (hp->depth == 0)
+        continue;
+
+      if (hp->depth > 1)
+        {
+          /* The cells of a nested table are text of the outer cell */
+          if (tag.id == TAG_ROW)
+            hp->newline = TRUE;
+          else if (tag.id == TAG_CELL)
+            hp->space = TRUE;
+          continue;
+        }
+
+      switch (tag.id)
+        {
+        case TAG_ROW:
+          rows += end_row (hp, ps);
+          if (!tag.closing)
+            hp->row_open = TRUE;
+          break;
+        case TAG_CELL:
+          end_cell (hp, ps);
+          if (!tag.closing)
+            {
+              hp->row_open = TRUE;
+              start_cell (hp, &tag, p);
+            }
+          break;
+        case TAG_BREAK:
+        case TAG_BLOCK:
+          hp->newline = TRUE;
+          break;
+        default:
+          break;
+        }
     }
+
+  if (p < end)
+    return p - data;
+
+  /* Close anything left open by truncated markup */
+  if (hp->depth > 0)
+    end_row (hp, ps);
+
+  return len;
 }
 
-static const GMarkupParser my_parser =
-  {
-   start_element,
-   end_element,
-   text_i,
-   NULL, NULL
-  };
+/* The number of rows of a table pasted at each step */
+#define HTML_STEP_ROWS 1000
 
+static void
+html_step (struct paste_state *ps)
+{
+  ps->offset += parse_html (ps->parser, ps->data + ps->offset,
+                            ps->len - ps->offset, ps, HTML_STEP_ROWS);
+}
 
 /* A GtkClipboardReceived callback function, which parses
    the selection data SD as HTML, and sets PASTE_STATE accordingly.  */
@@ -103,20 +649,11 @@ void
 ssw_html_parse (GtkClipboard *clip, GtkSelectionData *sd, gpointer paste_state)
 {
   struct paste_state *ps = paste_state;
-  SswSheet *sheet = SSW_SHEET (ps->sheet);
-  const guchar *text = gtk_selection_data_get_data (sd);
-  gint len = gtk_selection_data_get_length (sd);
-
-  if (len < 0)
-    {
-      g_free (ps);
-      return;
-    }
+  struct html_parser *hp = g_new0 (struct html_parser, 1);
 
-  ps->cell_element = FALSE;
-  GMarkupParseContext *ctx = g_markup_parse_context_new (&my_parser, 0, ps, 0);
-  g_markup_parse_context_parse (ctx, (const gchar *) text, len, 0);
-  g_markup_parse_context_unref (ctx);
+  hp->spans = g_array_new (FALSE, TRUE, sizeof (guint));
+  ps->parser = hp;
+  ps->parser_destroy = html_parser_free;
 
-  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+  ssw_sheet_paste_start_data (ps, sd, html_step);
 }
@@ -0,0 +1,1118 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <string.h>
+#include "ssw-journal.h"
+#include "ssw-data-model.h"
+
+/* Packed streams of at least this many bytes are deflated */
+#define JOURNAL_DEFLATE_BYTES 4096
+
+/* The tags which introduce each value of a packed stream */
+enum tag
+  {
+   TAG_UNSET,
+   /* The cell held nothing, and is to be cleared */
+   TAG_EMPTY,
+   /* The previous value is repeated the number of times which follows */
+   TAG_REPEAT,
+   TAG_FALSE,
+   TAG_TRUE,
+   TAG_CHAR,
+   TAG_UCHAR,
+   TAG_INT,
+   TAG_UINT,
+   TAG_LONG,
+   TAG_ULONG,
+   TAG_INT64,
+   TAG_UINT64,
+   TAG_FLOAT,
+   TAG_DOUBLE,
+   TAG_STRING,
+   TAG_NULL_STRING,
+   /* A value of any other type, held apart from the stream at the
+      index which follows */
+   TAG_OTHER
+  };
+
+/* A sequence of values, packed */
+struct packed
+{
+  guint8 *data;
+  gsize len;
+
+  /* The length of DATA before it was deflated, or zero if it was not */
+  gsize raw_len;
+
+  /* The values whose types cannot be packed */
+  GArray *others;
+};
+
+enum entry_kind
+  {
+   ENTRY_CELLS,
+   ENTRY_RESIZE
+  };
+
+struct entry
+{
+  enum entry_kind kind;
+
+  /* For ENTRY_CELLS, the block of the data model which was written,
+     the means by which it was written, and its values before and
+     after */
+  gint col0;
+  gint row0;
+  gint n_cols;
+  gint n_rows;
+  ssw_sheet_set_cells set_cells;
+  ssw_sheet_set_cell set_cell;
+  struct packed old_values;
+  struct packed new_values;
+
+  /* For ENTRY_RESIZE, the item which was resized, and its sizes
+     before and after */
+  SswSheetAxis *axis;
+  gint pos;
+  gint old_size;
+  gint new_size;
+};
+
+/* The changes which are undone together */
+struct step
+{
+  GPtrArray *entries;
+  gsize bytes;
+};
+
+struct ssw_journal
+{
+  SswSheet *sheet;
+
+  /* The steps which may be undone, and those which may be redone,
+     the most recent of each at the head */
+  GQueue undo;
+  GQueue redo;
+
+  /* The size of the history, and its limit */
+  gsize bytes;
+  gint64 limit;
+
+  /* The step being recorded, and the depth of nested calls to
+     ssw_journal_begin */
+  struct step *open;
+  gint depth;
+
+  /* TRUE if the open step has been abandoned, because it outgrew the
+     limit or overwrote a value which was not yet known */
+  gboolean overflowed;
+
+  /* TRUE if the history changed when the open step began */
+  gboolean redo_dropped;
+
+  /* TRUE whilst a step is being undone or redone, so that the changes
+     it makes are not recorded again */
+  gboolean replaying;
+};
+
+static void
+put_varint (GByteArray *b, guint64 x)
+{
+  do
+    {
+      guint8 c = x & 0x7f;
+      x >>= 7;
+      if (x)
+        c |= 0x80;
+      g_byte_array_append (b, &c, 1);
+    }
+  while (x);
+}
+
+static guint64
+get_varint (const guint8 **p)
+{
+  guint64 x = 0;
+  gint shift = 0;
+  guint8 c;
+
+  do
+    {
+      c = *(*p)++;
+      x |= (guint64) (c & 0x7f) << shift;
+      shift += 7;
+    }
+  while (c & 0x80);
+
+  return x;
+}
+
+/* Signed integers are stored such that those of small magnitude
+   occupy few bytes, whatever their sign */
+static void
+put_signed (GByteArray *b, gint64 x)
+{
+  put_varint (b, ((guint64) x << 1) ^ (guint64) (x >> 63));
+}
+
+static gint64
+get_signed (const guint8 **p)
+{
+  guint64 u = get_varint (p);
+
+  return (gint64) (u >> 1) ^ -(gint64) (u & 1);
+}
+
+static void
+put_tag (GByteArray *b, enum tag tag)
+{
+  guint8 t = tag;
+  g_byte_array_append (b, &t, 1);
+}
+
+/* Append the value V to B.  Values which cannot be packed are
+   copied into OTHERS.  */
+static void
+encode_value (GByteArray *b, const GValue *v, GArray *others)
+{
+  if (!G_IS_VALUE (v) || SSW_VALUE_HOLDS_PENDING (v))
+    {
+      put_tag (b, TAG_UNSET);
+      return;
+    }
+
+  switch (G_VALUE_TYPE (v))
+    {
+    case G_TYPE_BOOLEAN:
+      put_tag (b, g_value_get_boolean (v) ? TAG_TRUE : TAG_FALSE);
+      break;
+    case G_TYPE_CHAR:
+      put_tag (b, TAG_CHAR);
+      put_signed (b, g_value_get_schar (v));
+      break;
+    case G_TYPE_UCHAR:
+      put_tag (b, TAG_UCHAR);
+      put_varint (b, g_value_get_uchar (v));
+      break;
+    case G_TYPE_INT:
+      put_tag (b, TAG_INT);
+      put_signed (b, g_value_get_int (v));
+      break;
+    case G_TYPE_UINT:
+      put_tag (b, TAG_UINT);
+      put_varint (b, g_value_get_uint (v));
+      break;
+    case G_TYPE_LONG:
+      put_tag (b, TAG_LONG);
+      put_signed (b, g_value_get_long (v));
+      break;
+    case G_TYPE_ULONG:
+      put_tag (b, TAG_ULONG);
+      put_varint (b, g_value_get_ulong (v));
+      break;
+    case G_TYPE_INT64:
+      put_tag (b, TAG_INT64);
+      put_signed (b, g_value_get_int64 (v));
+      break;
+    case G_TYPE_UINT64:
+      put_tag (b, TAG_UINT64);
+      put_varint (b, g_value_get_uint64 (v));
+      break;
+    case G_TYPE_FLOAT:
+      {
+        gfloat x = g_value_get_float (v);
+        put_tag (b, TAG_FLOAT);
+        g_byte_array_append (b, (const guint8 *) &x, sizeof x);
+      }
+      break;
+    case G_TYPE_DOUBLE:
+      {
+        gdouble x = g_value_get_double (v);
+        put_tag (b, TAG_DOUBLE);
+        g_byte_array_append (b, (const guint8 *) &x, sizeof x);
+      }
+      break;
+    case G_TYPE_STRING:
+      {
+        const gchar *s = g_value_get_string (v);
+        if (s == NULL)
+          put_tag (b, TAG_NULL_STRING);
+        else
+          {
+            gsize len = strlen (s);
+            put_tag (b, TAG_STRING);
+            put_varint (b, len);
+            g_byte_array_append (b, (const guint8 *) s, len);
+          }
+      }
+      break;
+    default:
+      {
+        GValue copy = G_VALUE_INIT;
+        g_value_init (&copy, G_VALUE_TYPE (v));
+        g_value_copy (v, &copy);
+        put_tag (b, TAG_OTHER);
+        put_varint (b, others->len);
+        g_array_append_val (others, copy);
+      }
+      break;
+    }
+}
+
+/* Read the value with tag TAG from *P into V, which must not have
+   been initialised.  */
+static void
+decode_value (enum tag tag, const guint8 **p, const struct packed *pk,
+              GValue *v)
+{
+  switch (tag)
+    {
+    case TAG_FALSE:
+    case TAG_TRUE:
+      g_value_init (v, G_TYPE_BOOLEAN);
+      g_value_set_boolean (v, tag == TAG_TRUE);
+      break;
+    case TAG_CHAR:
+      g_value_init (v, G_TYPE_CHAR);
+      g_value_set_schar (v, get_signed (p));
+      break;
+    case TAG_UCHAR:
+      g_value_init (v, G_TYPE_UCHAR);
+      g_value_set_uchar (v, get_varint (p));
+      break;
+    case TAG_INT:
+      g_value_init (v, G_TYPE_INT);
+      g_value_set_int (v, get_signed (p));
+      break;
+    case TAG_UINT:
+      g_value_init (v, G_TYPE_UINT);
+      g_value_set_uint (v, get_varint (p));
+      break;
+    case TAG_LONG:
+      g_value_init (v, G_TYPE_LONG);
+      g_value_set_long (v, get_signed (p));
+      break;
+    case TAG_ULONG:
+      g_value_init (v, G_TYPE_ULONG);
+      g_value_set_ulong (v, get_varint (p));
+      break;
+    case TAG_INT64:
+      g_value_init (v, G_TYPE_INT64);
+      g_value_set_int64 (v, get_signed (p));
+      break;
+    case TAG_UINT64:
+      g_value_init (v, G_TYPE_UINT64);
+      g_value_set_uint64 (v, get_varint (p));
+      break;
+    case TAG_FLOAT:
+      {
+        gfloat x;
+        memcpy (&x, *p, sizeof x);
+        *p += sizeof x;
+        g_value_init (v, G_TYPE_FLOAT);
+        g_value_set_float (v, x);
+      }
+      break;
+    case TAG_DOUBLE:
+      {
+        gdouble x;
+        memcpy (&x, *p, sizeof x);
+        *p += sizeof x;
+        g_value_init (v, G_TYPE_DOUBLE);
+        g_value_set_double (v, x);
+      }
+      break;
+    case TAG_STRING:
+      {
+        gsize len = get_varint (p);
+        g_value_init (v, G_TYPE_STRING);
+        g_value_take_string (v, g_strndup ((const gchar *) *p, len));
+        *p += len;
+      }
+      break;
+    case TAG_NULL_STRING:
+      g_value_init (v, G_TYPE_STRING);
+      break;
+    case TAG_OTHER:
+      {
+        const GValue *other =
+          &g_array_index (pk->others, GValue, get_varint (p));
+        g_value_init (v, G_VALUE_TYPE (other));
+        g_value_copy (other, v);
+      }
+      break;
+    default:
+      break;
+    }
+}
+
+/* Pass the LEN bytes of SRC through C into DST, which has room for
+   SIZE bytes.  Returns FALSE if they do not fit.  */
+static gboolean
+convert_all (GConverter *c, const guint8 *src, gsize len,
+             guint8 *dst, gsize size, gsize *written)
+{
+  gsize in = 0, out = 0;
+
+  while (out < size)
+    {
+      gsize r = 0, w = 0;
+      GConverterResult result =
+        g_converter_convert (c, src + in, len - in, dst + out, size - out,
+                             G_CONVERTER_INPUT_AT_END, &r, &w, NULL);
+      in += r;
+      out += w;
+
+      if (result == G_CONVERTER_FINISHED)
+        {
+          *written = out;
+          return TRUE;
+        }
+
+      if (result == G_CONVERTER_ERROR || (r == 0 && w == 0))
+        break;
+    }
+
+  return FALSE;
+}
+
+/* Pack the N values of VALUES into PK.  If MASK is not NULL, values
+   whose counterparts in MASK have not been initialised are packed as
+   if they had not been either, and those which have not been
+   initialised themselves are packed as empty.  */
+static void
+pack (struct packed *pk, const GValue *values, gsize n, const GValue *mask)
+{
+  GByteArray *out = g_byte_array_new ();
+  GByteArray *cur = g_byte_array_new ();
+  GByteArray *prev = g_byte_array_new ();
+  guint64 run = 0;
+  gsize i;
+
+  pk->others = g_array_new (FALSE, FALSE, sizeof (GValue));
+  g_array_set_clear_func (pk->others, (GDestroyNotify) g_value_unset);
+
+  for (i = 0; i < n; ++i)
+    {
+      g_byte_array_set_size (cur, 0);
+      if (mask && !G_IS_VALUE (&mask[i]))
+        put_tag (cur, TAG_UNSET);
+      else if (mask && !G_IS_VALUE (&values[i]))
+        put_tag (cur, TAG_EMPTY);
+      else
+        encode_value (cur, &values[i], pk->others);
+
+      if (i > 0 && cur->data[0] != TAG_OTHER && cur->len == prev->len
+          && memcmp (cur->data, prev->data, cur->len) == 0)
+        {
+          run++;
+          continue;
+        }
+
+      if (run > 0)
+        {
+          put_tag (out, TAG_REPEAT);
+          put_varint (out, run);
+          run = 0;
+        }
+      g_byte_array_append (out, cur->data, cur->len);
+
+      GByteArray *tmp = prev;
+      prev = cur;
+      cur = tmp;
+    }
+
+  if (run > 0)
+    {
+      put_tag (out, TAG_REPEAT);
+      put_varint (out, run);
+    }
+
+  g_byte_array_unref (cur);
+  g_byte_array_unref (prev);
+
+  pk->raw_len = 0;
+  pk->len = out->len;
+  pk->data = g_byte_array_free (out, FALSE);
+
+  if (pk->len < JOURNAL_DEFLATE_BYTES)
+    return;
+
+  /* Keep the deflated stream only if it is smaller */
+  GConverter *c =
+    G_CONVERTER (g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW, -1));
+  guint8 *deflated = g_malloc (pk->len);
+  gsize len;
+
+  if (convert_all (c, pk->data, pk->len, deflated, pk->len, &len))
+    {
+      g_free (pk->data);
+      pk->raw_len = pk->len;
+      pk->len = len;
+      pk->data = g_realloc (deflated, len);
+    }
+  else
+    g_free (deflated);
+
+  g_object_unref (c);
+}
+
+/* Unpack the N values of PK into VALUES, which must have been
+   initialised to zero.  Those which were packed as empty are left
+   uninitialised, and flagged in EMPTY.  */
+static void
+unpack (const struct packed *pk, GValue *values, gboolean *empty, gsize n)
+{
+  const guint8 *raw = pk->data;
+  guint8 *inflated = NULL;
+  gsize i = 0;
+  gsize last = 0;
+
+  if (pk->raw_len > 0)
+    {
+      GConverter *c =
+        G_CONVERTER (g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_RAW));
+      gsize len;
+
+      inflated = g_malloc (pk->raw_len);
+      if (!convert_all (c, pk->data, pk->len, inflated, pk->raw_len, &len))
+        {
+          g_warning ("Corrupted journal entry");
+          g_object_unref (c);
+          g_free (inflated);
+          return;
+        }
+      g_object_unref (c);
+      raw = inflated;
+    }
+
+  const guint8 *p = raw;
+  while (i < n)
+    {
+      enum tag tag = *p++;
+
+      if (tag == TAG_REPEAT)
+        {
+          guint64 count = get_varint (&p);
+          for (; count > 0 && i < n; --count, ++i)
+            if (G_IS_VALUE (&values[last]))
+              {
+                g_value_init (&values[i], G_VALUE_TYPE (&values[last]));
+                g_value_copy (&values[last], &values[i]);
+              }
+            else
+              empty[i] = empty[last];
+          continue;
+        }
+
+      empty[i] = (tag == TAG_EMPTY);
+      decode_value (tag, &p, pk, &values[i]);
+      last = i++;
+    }
+
+  g_free (inflated);
+}
+
+static gsize
+packed_bytes (const struct packed *pk)
+{
+  return pk->len + pk->others->len * sizeof (GValue);
+}
+
+static void
+packed_clear (struct packed *pk)
+{
+  g_free (pk->data);
+  if (pk->others)
+    g_array_free (pk->others, TRUE);
+}
+
+static gsize
+entry_bytes (const struct entry *e)
+{
+  gsize bytes = sizeof *e;
+
+  if (e->kind == ENTRY_CELLS)
+    bytes += packed_bytes (&e->old_values) + packed_bytes (&e->new_values);
+
+  return bytes;
+}
+
+static void
+entry_free (gpointer data)
+{
+  struct entry *e = data;
+
+  if (e->kind == ENTRY_CELLS)
+    {
+      packed_clear (&e->old_values);
+      packed_clear (&e->new_values);
+    }
+  g_free (e);
+}
+
+static struct step *
+step_new (void)
+{
+  struct step *s = g_malloc (sizeof *s);
+  s->entries = g_ptr_array_new_with_free_func (entry_free);
+  s->bytes = sizeof *s;
+  return s;
+}
+
+static void
+step_free (gpointer data)
+{
+  struct step *s = data;
+
+  g_ptr_array_free (s->entries, TRUE);
+  g_free (s);
+}
+
+/* Forget the steps in Q */
+static void
+drop_steps (struct ssw_journal *j, GQueue *q)
+{
+  struct step *s;
+
+  while ((s = g_queue_pop_head (q)))
+    {
+      j->bytes -= s->bytes;
+      step_free (s);
+    }
+}
+
+/* Forget what has been recorded of the open step, and record no more
+   of it */
+static void
+abandon (struct ssw_journal *j)
+{
+  j->overflowed = TRUE;
+  j->bytes -= j->open->bytes;
+  g_ptr_array_set_size (j->open->entries, 0);
+  j->open->bytes = sizeof *j->open;
+  j->bytes += j->open->bytes;
+}
+
+/* Forget the oldest steps until the history fits its limit.  If the
+   open step alone does not fit, it is abandoned.  */
+static void
+trim (struct ssw_journal *j)
+{
+  while (j->bytes > j->limit && !g_queue_is_empty (&j->undo))
+    {
+      struct step *s = g_queue_pop_tail (&j->undo);
+      j->bytes -= s->bytes;
+      step_free (s);
+    }
+
+  if (j->bytes > j->limit && j->open && !j->overflowed)
+    abandon (j);
+}
+
+static void
+history_changed (struct ssw_journal *j)
+{
+  g_signal_emit_by_name (j->sheet, "history-changed");
+}
+
+static void
+add_entry (struct ssw_journal *j, struct entry *e)
+{
+  gsize bytes = entry_bytes (e);
+
+  g_ptr_array_add (j->open->entries, e);
+  j->open->bytes += bytes;
+  j->bytes += bytes;
+
+  trim (j);
+}
+
+struct ssw_journal *
+ssw_journal_new (SswSheet *sheet)
+{
+  struct ssw_journal *j = g_malloc0 (sizeof *j);
+
+  j->sheet = sheet;
+  g_queue_init (&j->undo);
+  g_queue_init (&j->redo);
+  j->limit = JOURNAL_DEFAULT_LIMIT;
+
+  return j;
+}
+
+void
+ssw_journal_free (struct ssw_journal *j)
+{
+  if (j == NULL)
+    return;
+
+  drop_steps (j, &j->undo);
+  drop_steps (j, &j->redo);
+  if (j->open)
+    step_free (j->open);
+  g_free (j);
+}
+
+void
+ssw_journal_set_limit (struct ssw_journal *j, gint64 limit)
+{
+  gboolean could_undo = ssw_journal_can_undo (j);
+
+  j->limit = limit;
+  trim (j);
+
+  if (could_undo != ssw_journal_can_undo (j))
+    history_changed (j);
+}
+
+void
+ssw_journal_clear (struct ssw_journal *j)
+{
+  if (!ssw_journal_can_undo (j) && !ssw_journal_can_redo (j))
+    return;
+
+  drop_steps (j, &j->undo);
+  drop_steps (j, &j->redo);
+  history_changed (j);
+}
+
+void
+ssw_journal_begin (struct ssw_journal *j)
+{
+  if (j->depth++ > 0)
+    return;
+
+  j->redo_dropped = !g_queue_is_empty (&j->redo);
+  drop_steps (j, &j->redo);
+
+  j->open = step_new ();
+  j->bytes += j->open->bytes;
+  j->overflowed = FALSE;
+}
+
+void
+ssw_journal_end (struct ssw_journal *j)
+{
+  g_return_if_fail (j->depth > 0);
+
+  if (--j->depth > 0)
+    return;
+
+  struct step *s = j->open;
+  j->open = NULL;
+
+  if (s->entries->len > 0 && !j->overflowed)
+    g_queue_push_head (&j->undo, s);
+  else
+    {
+      j->bytes -= s->bytes;
+      step_free (s);
+      if (!j->overflowed && !j->redo_dropped)
+        return;
+    }
+
+  history_changed (j);
+}
+
+void
+ssw_journal_record_cells (struct ssw_journal *j,
+                          gint col0, gint row0,
+                          gint n_cols, gint n_rows,
+                          const GValue *values,
+                          ssw_sheet_set_cells set_cells,
+                          ssw_sheet_set_cell set_cell)
+{
+  GtkTreeModel *model = j->sheet->data_model;
+  gint r;
+
+  if (j->replaying || j->limit == 0 || model == NULL
+      || n_cols <= 0 || n_rows <= 0)
+    return;
+
+  ssw_journal_begin (j);
+
+  if (!j->overflowed)
+    {
+      const gsize n = (gsize) n_cols * n_rows;
+      GValue *old = g_new0 (GValue, n);
+
+      /* Cells beyond the last column of the model hold nothing */
+      gint nc = CLAMP (gtk_tree_model_get_n_columns (model) - col0, 0, n_cols);
+      if (nc == n_cols)
+        ssw_data_model_fetch_block (model, col0, row0, n_cols, n_rows, old);
+      else if (nc > 0)
+        for (r = 0; r < n_rows; ++r)
+          ssw_data_model_fetch_block (model, col0, row0 + r, nc, 1,
+                                      old + (gsize) r * n_cols);
+
+      /* A value which has yet to arrive cannot be restored, so
+         overwriting one cannot be undone */
+      gsize i;
+      for (i = 0; i < n; ++i)
+        if (G_IS_VALUE (&values[i]) && SSW_VALUE_HOLDS_PENDING (&old[i]))
+          break;
+
+      if (i < n)
+        {
+          for (i = 0; i < n; ++i)
+            if (G_IS_VALUE (&old[i]))
+              g_value_unset (&old[i]);
+          g_free (old);
+
+          abandon (j);
+          ssw_journal_end (j);
+          return;
+        }
+
+      struct entry *e = g_malloc0 (sizeof *e);
+      e->kind = ENTRY_CELLS;
+      e->col0 = col0;
+      e->row0 = row0;
+      e->n_cols = n_cols;
+      e->n_rows = n_rows;
+      e->set_cells = set_cells;
+      e->set_cell = set_cell;
+      pack (&e->old_values, old, n, values);
+      pack (&e->new_values, values, n, NULL);
+
+      for (i = 0; i < n; ++i)
+        if (G_IS_VALUE (&old[i]))
+          g_value_unset (&old[i]);
+      g_free (old);
+
+      add_entry (j, e);
+    }
+
+  ssw_journal_end (j);
+}
+
+void
+ssw_journal_record_resize (struct ssw_journal *j, SswSheetAxis *axis,
+                           gint pos, gint old_size, gint new_size)
+{
+  if (j->replaying || j->limit == 0 || old_size == new_size)
+    return;
+
+  ssw_journal_begin (j);
+
+  if (!j->overflowed)
+    {
+      struct entry *e = g_malloc0 (sizeof *e);
+      e->kind = ENTRY_RESIZE;
+      e->axis = axis;
+      e->pos = pos;
+      e->old_size = old_size;
+      e->new_size = new_size;
+
+      add_entry (j, e);
+    }
+
+  ssw_journal_end (j);
+}
+
+/* A run of the rows of an entry, and the distance it has moved */
+struct run
+{
+  gint first;
+  gint n;
+  gint offset;
+};
+
+/* Append the rows FIRST to END - 1, moved by OFFSET, to the N_RUNS of
+   RUNS, joining them to the last if they continue it */
+static void
+add_run (struct run *runs, gint *n_runs, gint first, gint end, gint offset)
+{
+  if (end <= first)
+    return;
+
+  struct run *last = *n_runs > 0 ? &runs[*n_runs - 1] : NULL;
+  if (last && last->first + last->n == first && last->offset == offset)
+    last->n += end - first;
+  else
+    runs[(*n_runs)++] = (struct run) {first, end - first, offset};
+}
+
+/* A new entry holding the N rows of E from FIRST, moved by OFFSET */
+static struct entry *
+slice_entry (const struct entry *e, gint first, gint n, gint offset)
+{
+  const gsize len = (gsize) e->n_cols * e->n_rows;
+  GValue *old = g_new0 (GValue, len);
+  GValue *new = g_new0 (GValue, len);
+  gboolean *empty = g_new0 (gboolean, len);
+  gsize i;
+
+  unpack (&e->old_values, old, empty, len);
+  unpack (&e->new_values, new, empty, len);
+
+  struct entry *s = g_malloc0 (sizeof *s);
+  s->kind = ENTRY_CELLS;
+  s->col0 = e->col0;
+  s->row0 = first + offset;
+  s->n_cols = e->n_cols;
+  s->n_rows = n;
+  s->set_cells = e->set_cells;
+  s->set_cell = e->set_cell;
+
+  /* Packing the old values against the new ones again marks those
+     which were empty, and those which were left unchanged */
+  const gsize start = (gsize) (first - e->row0) * e->n_cols;
+  pack (&s->old_values, old + start, (gsize) n * e->n_cols, new + start);
+  pack (&s->new_values, new + start, (gsize) n * e->n_cols, NULL);
+
+  for (i = 0; i < len; ++i)
+    {
+      if (G_IS_VALUE (&old[i]))
+        g_value_unset (&old[i]);
+      if (G_IS_VALUE (&new[i]))
+        g_value_unset (&new[i]);
+    }
+  g_free (old);
+  g_free (new);
+  g_free (empty);
+
+  return s;
+}
+
+/* Move the rows of the entries of S, as ssw_journal_move_rows.
+   N_ROWS is the number of rows which the model had.  Rows beyond
+   those were not moved.  */
+static void
+move_step_rows (struct ssw_journal *j, struct step *s,
+                gint posn, gint rm, gint add, gint n_rows)
+{
+  guint i = 0;
+
+  while (i < s->entries->len)
+    {
+      struct entry *e = g_ptr_array_index (s->entries, i);
+
+      if (e->kind != ENTRY_CELLS)
+        {
+          ++i;
+          continue;
+        }
+
+      const gint first = e->row0;
+      const gint end = e->row0 + e->n_rows;
+      struct run runs[3];
+      gint n_runs = 0;
+      gint r;
+
+      add_run (runs, &n_runs, first, MIN (end, posn), 0);
+      add_run (runs, &n_runs, MAX (first, posn + rm), MIN (end, n_rows),
+               add - rm);
+      add_run (runs, &n_runs, MAX (first, n_rows), end, 0);
+
+      if (n_runs == 1 && runs[0].n == e->n_rows)
+        {
+          e->row0 += runs[0].offset;
+          ++i;
+          continue;
+        }
+
+      /* Some of the rows were removed, or the rows beyond the end of
+         the model were not moved with the others, so the entry is
+         split */
+      gsize bytes = entry_bytes (e);
+      s->bytes -= bytes;
+      j->bytes -= bytes;
+
+      for (r = 0; r < n_runs; ++r)
+        {
+          struct entry *piece =
+            slice_entry (e, runs[r].first, runs[r].n, runs[r].offset);
+          bytes = entry_bytes (piece);
+          s->bytes += bytes;
+          j->bytes += bytes;
+          g_ptr_array_insert (s->entries, i + 1 + r, piece);
+        }
+      g_ptr_array_remove_index (s->entries, i);
+      i += n_runs;
+    }
+}
+
+/* Forget the steps of Q which no longer hold anything */
+static void
+drop_empty_steps (struct ssw_journal *j, GQueue *q)
+{
+  GList *l = q->head;
+
+  while (l)
+    {
+      GList *next = l->next;
+      struct step *s = l->data;
+
+      if (s->entries->len == 0)
+        {
+          j->bytes -= s->bytes;
+          step_free (s);
+          g_queue_delete_link (q, l);
+        }
+      l = next;
+    }
+}
+
+void
+ssw_journal_move_rows (struct ssw_journal *j, gint posn, gint rm, gint add)
+{
+  GtkTreeModel *model = j->sheet->data_model;
+  GList *l;
+
+  if (model == NULL || rm == add)
+    return;
+
+  const gint n_rows =
+    gtk_tree_model_iter_n_children (model, NULL) - add + rm;
+  const gboolean could_undo = ssw_journal_can_undo (j);
+  const gboolean could_redo = ssw_journal_can_redo (j);
+
+  for (l = j->undo.head; l; l = l->next)
+    move_step_rows (j, l->data, posn, rm, add, n_rows);
+  for (l = j->redo.head; l; l = l->next)
+    move_step_rows (j, l->data, posn, rm, add, n_rows);
+  if (j->open)
+    move_step_rows (j, j->open, posn, rm, add, n_rows);
+
+  drop_empty_steps (j, &j->undo);
+  drop_empty_steps (j, &j->redo);
+  trim (j);
+
+  if (could_undo != ssw_journal_can_undo (j)
+      || could_redo != ssw_journal_can_redo (j))
+    history_changed (j);
+}
+
+gboolean
+ssw_journal_can_undo (const struct ssw_journal *j)
+{
+  return !g_queue_is_empty (&j->undo);
+}
+
+gboolean
+ssw_journal_can_redo (const struct ssw_journal *j)
+{
+  return !g_queue_is_empty (&j->redo);
+}
+
+/* Restore the old values of E if OLD is TRUE, or else its new ones */
+static void
+apply_entry (struct ssw_journal *j, const struct entry *e, gboolean old)
+{
+  GtkTreeModel *model = j->sheet->data_model;
+
+  if (e->kind == ENTRY_RESIZE)
+    {
+      ssw_sheet_axis_override_size (e->axis, e->pos,
+                                    old ? e->old_size : e->new_size);
+      return;
+    }
+
+  const gsize n = (gsize) e->n_cols * e->n_rows;
+  GValue *values = g_new0 (GValue, n);
+  gboolean *empty = g_new0 (gboolean, n);
+  gint n_columns = gtk_tree_model_get_n_columns (model);
+  gint r, c;
+  gsize i;
+
+  unpack (old ? &e->old_values : &e->new_values, values, empty, n);
+
+  /* Cells which held nothing are cleared to the default value of
+     their column */
+  for (i = 0; i < n; ++i)
+    {
+      c = e->col0 + i % e->n_cols;
+      if (empty[i] && c < n_columns)
+        g_value_init (&values[i], gtk_tree_model_get_column_type (model, c));
+    }
+
+  /* A whole block is restored with a single call, if possible */
+  if (e->set_cells)
+    e->set_cells (model, e->col0, e->row0, e->n_cols, e->n_rows, values);
+  else
+    for (r = 0; r < e->n_rows; ++r)
+      for (c = 0; c < e->n_cols; ++c)
+        {
+          GValue *v = &values[(gsize) r * e->n_cols + c];
+          if (!G_IS_VALUE (v))
+            continue;
+
+          if (e->set_cell)
+            e->set_cell (model, e->col0 + c, e->row0 + r, v);
+          else
+            g_signal_emit_by_name (j->sheet, "value-changed",
+                                   e->col0 + c, e->row0 + r, v);
+        }
+
+  for (i = 0; i < n; ++i)
+    if (G_IS_VALUE (&values[i]))
+      g_value_unset (&values[i]);
+  g_free (values);
+  g_free (empty);
+}
+
+gboolean
+ssw_journal_undo (struct ssw_journal *j)
+{
+  g_return_val_if_fail (j->depth == 0, FALSE);
+
+  struct step *s = g_queue_pop_head (&j->undo);
+  gint i;
+
+  if (s == NULL)
+    return FALSE;
+
+  j->replaying = TRUE;
+  for (i = s->entries->len - 1; i >= 0; --i)
+    apply_entry (j, g_ptr_array_index (s->entries, i), TRUE);
+  j->replaying = FALSE;
+
+  g_queue_push_head (&j->redo, s);
+
+  gtk_widget_queue_draw (GTK_WIDGET (j->sheet));
+  history_changed (j);
+
+  return TRUE;
+}
+
+gboolean
+ssw_journal_redo (struct ssw_journal *j)
+{
+  g_return_val_if_fail (j->depth == 0, FALSE);
+
+  struct step *s = g_queue_pop_head (&j->redo);
+  guint i;
+
+  if (s == NULL)
+    return FALSE;
+
+  j->replaying = TRUE;
+  for (i = 0; i < s->entries->len; ++i)
+    apply_entry (j, g_ptr_array_index (s->entries, i), FALSE);
+  j->replaying = FALSE;
+
+  g_queue_push_head (&j->undo, s);
+
+  gtk_widget_queue_draw (GTK_WIDGET (j->sheet));
+  history_changed (j);
+
+  return TRUE;
+}
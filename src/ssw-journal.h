@@ -0,0 +1,90 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The history of the changes made through a sheet, from which they
+   may be undone and redone.  Each step of the history holds the old
+   and new values of rectangular blocks of cells, and the old and new
+   sizes of rows and columns.  The values of a block are packed into a
+   compact byte stream, in which runs of equal values are stored once,
+   and large streams are deflated.  When the history exceeds its limit
+   in bytes, its oldest steps are forgotten.  */
+
+#ifndef _SSW_JOURNAL_H
+#define _SSW_JOURNAL_H
+
+#include "ssw-sheet.h"
+#include "ssw-sheet-axis.h"
+
+/* The default limit of the size of the history, in bytes */
+#define JOURNAL_DEFAULT_LIMIT (64 << 20)
+
+struct ssw_journal;
+
+struct ssw_journal *ssw_journal_new (SswSheet *sheet);
+void ssw_journal_free (struct ssw_journal *j);
+
+/* Limit the size of the history to LIMIT bytes.  Zero means that
+   nothing is recorded.  */
+void ssw_journal_set_limit (struct ssw_journal *j, gint64 limit);
+
+/* Forget the whole history */
+void ssw_journal_clear (struct ssw_journal *j);
+
+/* Everything recorded between these calls is undone as one step.
+   They may be nested.  */
+void ssw_journal_begin (struct ssw_journal *j);
+void ssw_journal_end (struct ssw_journal *j);
+
+/* Record that VALUES, which hold N_COLS * N_ROWS values in row major
+   order, are about to be written to the block of the data model whose
+   top left cell is COL0, ROW0, through SET_CELLS, or cell by cell
+   through SET_CELL if SET_CELLS is NULL.  If both are NULL, the values
+   are written by the handlers of the sheet's "value-changed" signal.
+   A value which has not been initialised means that the cell is left
+   unchanged.  The old values are read from the data model, so this
+   must be called before the values are written.  A cell which held
+   nothing is restored as the default value of its column.  If any of
+   the cells holds a value which is still pending, the step being
+   recorded is abandoned, since that value could not be restored.  */
+void ssw_journal_record_cells (struct ssw_journal *j,
+                               gint col0, gint row0,
+                               gint n_cols, gint n_rows,
+                               const GValue *values,
+                               ssw_sheet_set_cells set_cells,
+                               ssw_sheet_set_cell set_cell);
+
+/* Record that the size of the item at POS of AXIS has been changed
+   from OLD_SIZE to NEW_SIZE.  A negative size is the natural size.  */
+void ssw_journal_record_resize (struct ssw_journal *j, SswSheetAxis *axis,
+                                gint pos, gint old_size, gint new_size);
+
+/* Move the rows recorded in the history as the data model has moved
+   its own: of the rows it had, the RM at POSN have been replaced by ADD
+   new ones.  Changes to the rows which were removed are forgotten.  */
+void ssw_journal_move_rows (struct ssw_journal *j,
+                            gint posn, gint rm, gint add);
+
+gboolean ssw_journal_can_undo (const struct ssw_journal *j);
+gboolean ssw_journal_can_redo (const struct ssw_journal *j);
+
+/* Undo (redo) the most recent step which has not been undone (the
+   most recently undone step).  Returns FALSE if there is none.  */
+gboolean ssw_journal_undo (struct ssw_journal *j);
+gboolean ssw_journal_redo (struct ssw_journal *j);
+
+#endif
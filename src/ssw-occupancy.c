@@ -0,0 +1,563 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <string.h>
+#include "ssw-occupancy.h"
+#include "ssw-data-model.h"
+#include "ssw-permutation.h"
+
+#define WORD_BITS (8 * (gint) sizeof (gulong))
+
+/* The number of rows read from the data model at a time, whilst
+   building the index of a column.  Blocks are read only when a search
+   reaches them.  It must be a multiple of WORD_BITS, so that no two
+   blocks share a word.  */
+#define OCC_BLOCK_ROWS 16384
+
+/* The greatest number of columns whose index is kept */
+#define OCC_MAX_COLUMNS 64
+
+/* The deepest hierarchy needed for G_MAXINT bits */
+#define MAX_LEVELS 8
+
+/* A set of bits, with a hierarchy of summaries.  Bit I of level K + 1
+   is set if and only if word I of level K is not zero.  */
+struct bitset
+{
+  gint n_levels;
+  gsize len[MAX_LEVELS];
+  gulong *level[MAX_LEVELS];
+};
+
+/* The index of one column of the view */
+struct column_index
+{
+  /* The cells which are not empty, and those which are.  Only the
+     bits of valid blocks are meaningful.  */
+  struct bitset full;
+  struct bitset empty;
+  gint n_rows;
+
+  /* Whether each block of OCC_BLOCK_ROWS rows has been read */
+  gboolean *valid;
+  gint n_blocks;
+};
+
+/* A column being searched */
+struct column_search
+{
+  struct ssw_occupancy *occ;
+  struct column_index *ci;
+  gint col;
+};
+
+struct ssw_occupancy
+{
+  SswSheet *sheet;
+
+  /* Maps a column of the view to its struct column_index */
+  GHashTable *columns;
+};
+
+static void
+bitset_init (struct bitset *bs, gint n_bits)
+{
+  gsize len = (n_bits + WORD_BITS - 1) / WORD_BITS;
+
+  bs->n_levels = 0;
+  do
+    {
+      bs->len[bs->n_levels] = MAX (len, 1);
+      bs->level[bs->n_levels] = g_new0 (gulong, MAX (len, 1));
+      bs->n_levels++;
+      len = (len + WORD_BITS - 1) / WORD_BITS;
+    }
+  while (bs->len[bs->n_levels - 1] > 1);
+}
+
+static void
+bitset_destroy (struct bitset *bs)
+{
+  gint k;
+
+  for (k = 0; k < bs->n_levels; ++k)
+    g_free (bs->level[k]);
+}
+
+static inline void
+bitset_assign (struct bitset *bs, gint bit, gboolean value)
+{
+  gulong mask = 1UL << (bit % WORD_BITS);
+
+  if (value)
+    bs->level[0][bit / WORD_BITS] |= mask;
+  else
+    bs->level[0][bit / WORD_BITS] &= ~mask;
+}
+
+static inline gboolean
+bitset_test (const struct bitset *bs, gint bit)
+{
+  return (bs->level[0][bit / WORD_BITS] >> (bit % WORD_BITS)) & 1;
+}
+
+/* Recalculate the summaries of the words FIRST .. LAST of level 0 */
+static void
+bitset_summarise (struct bitset *bs, gsize first, gsize last)
+{
+  gint k;
+
+  for (k = 1; k < bs->n_levels; ++k)
+    {
+      gsize i;
+
+      for (i = first; i <= last; ++i)
+        {
+          gulong mask = 1UL << (i % WORD_BITS);
+          if (bs->level[k - 1][i])
+            bs->level[k][i / WORD_BITS] |= mask;
+          else
+            bs->level[k][i / WORD_BITS] &= ~mask;
+        }
+
+      first /= WORD_BITS;
+      last /= WORD_BITS;
+    }
+}
+
+/* Return the first set bit of BS at or after POS, or -1 if none */
+static gint
+bitset_next (const struct bitset *bs, gint pos)
+{
+  gint k = 0;
+  gsize i = pos;
+
+  for (;;)
+    {
+      gsize w = i / WORD_BITS;
+      if (k >= bs->n_levels || w >= bs->len[k])
+        return -1;
+
+      gint b = g_bit_nth_lsf (bs->level[k][w], (gint) (i % WORD_BITS) - 1);
+      if (b >= 0)
+        {
+          i = w * WORD_BITS + b;
+          break;
+        }
+      i = w + 1;
+      k++;
+    }
+
+  while (k-- > 0)
+    i = i * WORD_BITS + g_bit_nth_lsf (bs->level[k][i], -1);
+
+  return i;
+}
+
+/* Return the last set bit of BS at or before POS, or -1 if none */
+static gint
+bitset_prev (const struct bitset *bs, gint pos)
+{
+  gint k = 0;
+  gssize i = pos;
+
+  for (;;)
+    {
+      if (i < 0 || k >= bs->n_levels)
+        return -1;
+
+      gsize w = i / WORD_BITS;
+      gint top = i % WORD_BITS + 1;
+      gint b = g_bit_nth_msf (bs->level[k][w], top == WORD_BITS ? -1 : top);
+      if (b >= 0)
+        {
+          i = w * WORD_BITS + b;
+          break;
+        }
+      i = (gssize) w - 1;
+      k++;
+    }
+
+  while (k-- > 0)
+    i = i * WORD_BITS + g_bit_nth_msf (bs->level[k][i], -1);
+
+  return i;
+}
+
+/* Returns TRUE if V would be shown as an empty cell */
+static gboolean
+value_is_empty (const GValue *v)
+{
+  if (!G_IS_VALUE (v))
+    return TRUE;
+
+  if (SSW_VALUE_HOLDS_PENDING (v))
+    return TRUE;
+
+  if (G_VALUE_HOLDS_STRING (v))
+    {
+      const gchar *s = g_value_get_string (v);
+      return s == NULL || s[0] == '\0';
+    }
+
+  return FALSE;
+}
+
+/* Read the Bth block of rows of the view into CI, which is the index
+   of the column COL, unless it has been read already.  */
+static void
+fill_block (struct ssw_occupancy *occ, struct column_index *ci, gint col,
+            gint b)
+{
+  if (ci->valid[b])
+    return;
+
+  GtkTreeModel *model = occ->sheet->data_model;
+  gint mcol = ssw_sheet_get_model_column (occ->sheet, col);
+  gint first = b * OCC_BLOCK_ROWS;
+  gint n = MIN (OCC_BLOCK_ROWS, ci->n_rows - first);
+  gboolean rows_in_order = ssw_permutation_is_identity (occ->sheet->row_order);
+  gint i;
+
+  if (rows_in_order
+      && ssw_data_model_is_block_empty (model, mcol, first, 1, n))
+    {
+      for (i = 0; i < n; ++i)
+        {
+          bitset_assign (&ci->full, first + i, FALSE);
+          bitset_assign (&ci->empty, first + i, TRUE);
+        }
+    }
+  else
+    {
+      GValue *values = g_new0 (GValue, n);
+
+      if (rows_in_order)
+        ssw_data_model_fetch_block (model, mcol, first, 1, n, values);
+      else
+        for (i = 0; i < n; ++i)
+          ssw_data_model_fetch_block (model, mcol,
+                                      ssw_sheet_get_model_row (occ->sheet,
+                                                               first + i),
+                                      1, 1, values + i);
+
+      for (i = 0; i < n; ++i)
+        {
+          gboolean empty = value_is_empty (&values[i]);
+
+          bitset_assign (&ci->full, first + i, !empty);
+          bitset_assign (&ci->empty, first + i, empty);
+          if (G_IS_VALUE (&values[i]))
+            g_value_unset (&values[i]);
+        }
+
+      g_free (values);
+    }
+
+  gsize w0 = first / WORD_BITS;
+  gsize w1 = (first + n - 1) / WORD_BITS;
+  bitset_summarise (&ci->full, w0, w1);
+  bitset_summarise (&ci->empty, w0, w1);
+
+  ci->valid[b] = TRUE;
+}
+
+static void
+column_index_free (gpointer p)
+{
+  struct column_index *ci = p;
+
+  bitset_destroy (&ci->full);
+  bitset_destroy (&ci->empty);
+  g_free (ci->valid);
+  g_free (ci);
+}
+
+/* Return the index of the column COL of the view, creating it empty
+   if necessary, or NULL if there is no such column.  */
+static struct column_index *
+get_column (struct ssw_occupancy *occ, gint col)
+{
+  GtkTreeModel *model = occ->sheet->data_model;
+
+  if (model == NULL || col < 0 || col >= gtk_tree_model_get_n_columns (model))
+    return NULL;
+
+  struct column_index *ci =
+    g_hash_table_lookup (occ->columns, GINT_TO_POINTER (col));
+  if (ci)
+    return ci;
+
+  gint n_rows = gtk_tree_model_iter_n_children (model, NULL);
+  if (n_rows <= 0)
+    return NULL;
+
+  if (g_hash_table_size (occ->columns) >= OCC_MAX_COLUMNS)
+    g_hash_table_remove_all (occ->columns);
+
+  ci = g_malloc (sizeof *ci);
+  ci->n_rows = n_rows;
+  bitset_init (&ci->full, n_rows);
+  bitset_init (&ci->empty, n_rows);
+  ci->n_blocks = (n_rows + OCC_BLOCK_ROWS - 1) / OCC_BLOCK_ROWS;
+  ci->valid = g_new0 (gboolean, ci->n_blocks);
+
+  g_hash_table_insert (occ->columns, GINT_TO_POINTER (col), ci);
+
+  return ci;
+}
+
+struct ssw_occupancy *
+ssw_occupancy_new (SswSheet *sheet)
+{
+  struct ssw_occupancy *occ = g_malloc (sizeof *occ);
+
+  occ->sheet = sheet;
+  occ->columns = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                        NULL, column_index_free);
+
+  return occ;
+}
+
+void
+ssw_occupancy_free (struct ssw_occupancy *occ)
+{
+  if (occ == NULL)
+    return;
+
+  g_hash_table_unref (occ->columns);
+  g_free (occ);
+}
+
+void
+ssw_occupancy_invalidate (struct ssw_occupancy *occ, gint row0, gint n_rows)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (n_rows == 0)
+    return;
+
+  /* The rows changed are known only in the order of the model */
+  if (n_rows < 0 || !ssw_permutation_is_identity (occ->sheet->row_order))
+    {
+      g_hash_table_remove_all (occ->columns);
+      return;
+    }
+
+  /* The blocks holding those rows are read again when next searched */
+  g_hash_table_iter_init (&iter, occ->columns);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      struct column_index *ci = value;
+      gint end = MIN (row0 + n_rows, ci->n_rows);
+      gint b;
+
+      for (b = row0 / OCC_BLOCK_ROWS; b * OCC_BLOCK_ROWS < end; ++b)
+        ci->valid[b] = FALSE;
+    }
+}
+
+/* Return the edge of the block of data from POS in the direction DIR,
+   where N is the number of positions, and FULL, NEXT_FULL and
+   NEXT_EMPTY report the cells of the line being searched.  */
+static gint
+find_edge (gint pos, gint dir, gint n,
+           gboolean (*full) (gint, gpointer),
+           gint (*next_full) (gint, gint, gpointer),
+           gint (*next_empty) (gint, gint, gpointer),
+           gpointer aux)
+{
+  gint next = pos + dir;
+
+  if (next < 0 || next >= n)
+    return -1;
+
+  if (pos >= 0 && pos < n && full (pos, aux) && full (next, aux))
+    {
+      gint e = next_empty (next, dir, aux);
+      return (e < 0) ? (dir > 0 ? n - 1 : 0) : e - dir;
+    }
+
+  return next_full (next, dir, aux);
+}
+
+static gboolean
+column_full (gint pos, gpointer aux)
+{
+  const struct column_search *cs = aux;
+
+  fill_block (cs->occ, cs->ci, cs->col, pos / OCC_BLOCK_ROWS);
+  return bitset_test (&cs->ci->full, pos);
+}
+
+/* Return the first set bit of BS from POS in the direction DIR, or -1
+   if none.  BS is one of the bitsets of the column searched by CS.
+   Blocks are read as the search reaches them, so that a search costs
+   no more than the distance it travels.  */
+static gint
+column_next (const struct column_search *cs, const struct bitset *bs,
+             gint pos, gint dir)
+{
+  struct column_index *ci = cs->ci;
+
+  while (pos >= 0 && pos < ci->n_rows)
+    {
+      gint b = pos / OCC_BLOCK_ROWS;
+      fill_block (cs->occ, ci, cs->col, b);
+
+      gint r = (dir > 0) ? bitset_next (bs, pos) : bitset_prev (bs, pos);
+      if (r >= ci->n_rows)
+        r = -1;
+
+      /* The bits of any block which has not been read may be stale.
+         The result stands only if every block between has been read.  */
+      gint last = (r >= 0) ? r / OCC_BLOCK_ROWS
+        : (dir > 0) ? ci->n_blocks - 1 : 0;
+
+      for (b += dir; b != last + dir && ci->valid[b]; b += dir)
+        continue;
+
+      if (b == last + dir)
+        return r;
+
+      pos = (dir > 0) ? b * OCC_BLOCK_ROWS
+        : MIN ((b + 1) * OCC_BLOCK_ROWS, ci->n_rows) - 1;
+    }
+
+  return -1;
+}
+
+static gint
+column_next_full (gint pos, gint dir, gpointer aux)
+{
+  const struct column_search *cs = aux;
+  return column_next (cs, &cs->ci->full, pos, dir);
+}
+
+static gint
+column_next_empty (gint pos, gint dir, gpointer aux)
+{
+  const struct column_search *cs = aux;
+  return column_next (cs, &cs->ci->empty, pos, dir);
+}
+
+gint
+ssw_occupancy_find_row_edge (struct ssw_occupancy *occ,
+                             gint col, gint row, gint dir)
+{
+  g_return_val_if_fail (occ, -1);
+
+  struct column_index *ci = get_column (occ, col);
+  if (ci == NULL)
+    return -1;
+
+  /* Moving up from below the data goes first to its last row */
+  if (dir < 0 && row > ci->n_rows)
+    row = ci->n_rows;
+
+  struct column_search cs = {occ, ci, col};
+
+  return find_edge (row, dir, ci->n_rows,
+                    column_full, column_next_full, column_next_empty, &cs);
+}
+
+/* The cells of one row of the view, in the order of the view */
+struct row_cells
+{
+  gboolean *full;
+  gint n;
+};
+
+static gboolean
+row_full (gint pos, gpointer aux)
+{
+  const struct row_cells *rc = aux;
+  return rc->full[pos];
+}
+
+static gint
+row_next (const struct row_cells *rc, gint pos, gint dir, gboolean want)
+{
+  for (; pos >= 0 && pos < rc->n; pos += dir)
+    if (rc->full[pos] == want)
+      return pos;
+
+  return -1;
+}
+
+static gint
+row_next_full (gint pos, gint dir, gpointer aux)
+{
+  return row_next (aux, pos, dir, TRUE);
+}
+
+static gint
+row_next_empty (gint pos, gint dir, gpointer aux)
+{
+  return row_next (aux, pos, dir, FALSE);
+}
+
+gint
+ssw_occupancy_find_column_edge (struct ssw_occupancy *occ,
+                                gint col, gint row, gint dir)
+{
+  g_return_val_if_fail (occ, -1);
+
+  GtkTreeModel *model = occ->sheet->data_model;
+  if (model == NULL || row < 0)
+    return -1;
+
+  gint mrow = ssw_sheet_get_model_row (occ->sheet, row);
+  if (mrow < 0 || mrow >= gtk_tree_model_iter_n_children (model, NULL))
+    return -1;
+
+  /* Rows are short enough to be read whole, and searched directly */
+  struct row_cells rc;
+  rc.n = gtk_tree_model_get_n_columns (model);
+  if (rc.n <= 0)
+    return -1;
+
+  GValue *values = g_new0 (GValue, rc.n);
+  gint i;
+
+  ssw_data_model_fetch_block (model, 0, mrow, rc.n, 1, values);
+
+  rc.full = g_new (gboolean, rc.n);
+  for (i = 0; i < rc.n; ++i)
+    {
+      gint mcol = ssw_sheet_get_model_column (occ->sheet, i);
+      rc.full[i] = (mcol >= 0 && mcol < rc.n && !value_is_empty (&values[mcol]));
+    }
+
+  for (i = 0; i < rc.n; ++i)
+    if (G_IS_VALUE (&values[i]))
+      g_value_unset (&values[i]);
+  g_free (values);
+
+  if (dir < 0 && col > rc.n)
+    col = rc.n;
+
+  gint edge = find_edge (col, dir, rc.n,
+                         row_full, row_next_full, row_next_empty, &rc);
+
+  g_free (rc.full);
+
+  return edge;
+}
@@ -0,0 +1,56 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* An index of which cells of a sheet's columns hold data, used to find
+   the edges of contiguous blocks of data, as Ctrl+Arrow does in other
+   spreadsheets.  The index of a column records one bit for each row,
+   in the order in which the rows are shown.  It is read from the data
+   model a block of rows at a time, as searches reach those blocks.
+   Summaries of those bits, each summarising a word of the level
+   beneath, allow the next cell which is (or is not) empty to be found
+   in a time which grows with the logarithm of the number of rows.  */
+
+#ifndef _SSW_OCCUPANCY_H
+#define _SSW_OCCUPANCY_H
+
+#include "ssw-sheet.h"
+
+struct ssw_occupancy;
+
+struct ssw_occupancy *ssw_occupancy_new (SswSheet *sheet);
+void ssw_occupancy_free (struct ssw_occupancy *occ);
+
+/* Forget what is known of the rows ROW0 .. ROW0 + N_ROWS - 1 of the
+   data model, or of all rows if N_ROWS is negative.  */
+void ssw_occupancy_invalidate (struct ssw_occupancy *occ,
+                               gint row0, gint n_rows);
+
+/* Return the row to which the active cell should move from ROW of
+   column COL, when moving to the edge of a block of data in the
+   direction DIR (+1 or -1).  If it is a non-empty cell next to ROW,
+   the edge is the last non-empty cell before the next empty one.
+   Otherwise it is the next non-empty cell.  Returns -1 if there is no
+   such cell.  Rows and columns are those of the view.  */
+gint ssw_occupancy_find_row_edge (struct ssw_occupancy *occ,
+                                  gint col, gint row, gint dir);
+
+/* As ssw_occupancy_find_row_edge, but moving along ROW from COL */
+gint ssw_occupancy_find_column_edge (struct ssw_occupancy *occ,
+                                     gint col, gint row, gint dir);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include "ssw-parallel.h"
+
+struct job
+{
+  gint n_tasks;
+  gint next;
+  ssw_parallel_func func;
+  gpointer data;
+};
+
+static gpointer
+worker (gpointer p)
+{
+  struct job *job = p;
+  gint task;
+
+  while ((task = g_atomic_int_add (&job->next, 1)) < job->n_tasks)
+    job->func (task, job->data);
+
+  return NULL;
+}
+
+void
+ssw_parallel_for (gint n_tasks, ssw_parallel_func func, gpointer data)
+{
+  struct job job = {n_tasks, 0, func, data};
+  gint n_threads = MIN (n_tasks, (gint) g_get_num_processors ());
+  gint i;
+
+  if (n_threads <= 1)
+    {
+      worker (&job);
+      return;
+    }
+
+  /* The calling thread does its share of the work too */
+  GThread **threads = g_new (GThread *, n_threads - 1);
+  for (i = 0; i < n_threads - 1; ++i)
+    threads[i] = g_thread_new ("ssw-worker", worker, &job);
+
+  worker (&job);
+
+  for (i = 0; i < n_threads - 1; ++i)
+    g_thread_join (threads[i]);
+
+  g_free (threads);
+}
+
+struct ssw_pool
+{
+  GThreadPool *threads;
+  gint n_threads;
+
+  /* The loop being run, and the number of threads yet to finish it */
+  struct job job;
+  gint busy;
+  GMutex mutex;
+  GCond done;
+};
+
+static void
+pool_worker (gpointer item, gpointer p)
+{
+  struct ssw_pool *pool = p;
+
+  worker (&pool->job);
+
+  g_mutex_lock (&pool->mutex);
+  if (--pool->busy == 0)
+    g_cond_signal (&pool->done);
+  g_mutex_unlock (&pool->mutex);
+}
+
+struct ssw_pool *
+ssw_pool_new (void)
+{
+  struct ssw_pool *pool = g_malloc0 (sizeof *pool);
+
+  /* The calling thread does its share of the work too */
+  pool->n_threads = g_get_num_processors () - 1;
+  if (pool->n_threads > 0)
+    pool->threads = g_thread_pool_new (pool_worker, pool, pool->n_threads,
+                                       TRUE, NULL);
+  g_mutex_init (&pool->mutex);
+  g_cond_init (&pool->done);
+
+  return pool;
+}
+
+void
+ssw_pool_free (struct ssw_pool *pool)
+{
+  if (pool == NULL)
+    return;
+
+  if (pool->threads)
+    g_thread_pool_free (pool->threads, FALSE, TRUE);
+  g_mutex_clear (&pool->mutex);
+  g_cond_clear (&pool->done);
+  g_free (pool);
+}
+
+void
+ssw_pool_for (struct ssw_pool *pool, gint n_tasks,
+              ssw_parallel_func func, gpointer data)
+{
+  gint n_helpers = pool->threads ? MIN (n_tasks - 1, pool->n_threads) : 0;
+  gint i;
+
+  pool->job = (struct job) {n_tasks, 0, func, data};
+  pool->busy = MAX (n_helpers, 0);
+
+  for (i = 0; i < n_helpers; ++i)
+    g_thread_pool_push (pool->threads, pool, NULL);
+
+  worker (&pool->job);
+
+  g_mutex_lock (&pool->mutex);
+  while (pool->busy > 0)
+    g_cond_wait (&pool->done, &pool->mutex);
+  g_mutex_unlock (&pool->mutex);
+}
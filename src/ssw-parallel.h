@@ -0,0 +1,43 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SSW_PARALLEL_H
+#define _SSW_PARALLEL_H
+
+#include <glib.h>
+
+typedef void (*ssw_parallel_func) (gint task, gpointer data);
+
+/* Call FUNC (I, DATA) for every I in [0, N_TASKS), distributing the
+   calls over as many threads as there are processors.  Returns when
+   all of the calls have completed.  */
+void ssw_parallel_for (gint n_tasks, ssw_parallel_func func, gpointer data);
+
+/* A set of threads which is kept for a sequence of parallel loops, so
+   that each loop does not start threads of its own */
+struct ssw_pool;
+
+struct ssw_pool *ssw_pool_new (void);
+void ssw_pool_free (struct ssw_pool *pool);
+
+/* As ssw_parallel_for, but using the threads of POOL.  Calls must not
+   overlap.  */
+void ssw_pool_for (struct ssw_pool *pool, gint n_tasks,
+                   ssw_parallel_func func, gpointer data);
+
+#endif
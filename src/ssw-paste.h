@@ -22,6 +22,12 @@
 
 #include "ssw-sheet.h"
 
+struct paste_state;
+
+/* A function which processes a bounded part of the data of a paste,
+   starting at its OFFSET, and advances OFFSET accordingly.  */
+typedef void (*ssw_paste_step_func) (struct paste_state *ps);
+
 struct paste_state
 {
   gint col0;
@@ -29,13 +35,60 @@ struct paste_state
   gint col;
   gint row;
   SswSheet *sheet;
+
+  /* Exactly one of these is set */
   ssw_sheet_set_cell set_cell;
-  gboolean cell_element;
+  ssw_sheet_set_cells set_cells;
+
+  /* The reverse conversion function, resolved when the paste starts */
+  ssw_sheet_reverse_conversion_func rcf;
+
+  /* The cells which have been converted but not yet written */
+  GArray *pending;
+
+  /* The clipboard data, copied so that it can be processed a part at
+     a time, and terminated by an extra NUL byte.  */
+  gchar *data;
+  gsize len;
+  gsize offset;
+
+  ssw_paste_step_func step;
+  guint idle_id;
+
+  /* Data private to the STEP function */
+  gchar delimiter;
+  gpointer parser;
+  GDestroyNotify parser_destroy;
 };
 
 /* A function which populates the cell indicated by PS with the value
    indicated by STR and the current reverse conversion function.  */
-void ssw_sheet_paste_insert_datum (const gchar *x, size_t len, const struct paste_state *ps);
+void ssw_sheet_paste_insert_datum (const gchar *x, size_t len, struct paste_state *ps);
+
+/* Write any cells which are still pending, redraw the sheet, and
+   free PS.  Every paste must end with a call to this function.  */
+void ssw_sheet_paste_finish (struct paste_state *ps);
+
+/* Take a copy of the data in SD, and process it by calling STEP from
+   an idle callback until the whole of it has been consumed, or the
+   paste is cancelled.  The paste is then finished.  */
+void ssw_sheet_paste_start_data (struct paste_state *ps, GtkSelectionData *sd,
+                                 ssw_paste_step_func step);
+
+typedef void (*ssw_paste_field_func) (const gchar *text, size_t len,
+                                      struct paste_state *ps);
+typedef void (*ssw_paste_row_func) (struct paste_state *ps);
+
+/* Split DATA, of length LEN, into rows and fields separated by
+   DELIMITER, honouring RFC 4180 quoting.  DATA is modified in place,
+   and must have room for a terminating byte at DATA[LEN].  FIELD is
+   called with each NUL terminated field, and END_OF_ROW at the end of
+   each row.  At most MAX_ROWS rows are parsed.  Returns the number of
+   bytes consumed.  */
+gsize ssw_parse_delimited (gchar *data, gsize len, gchar delimiter,
+                           ssw_paste_field_func field,
+                           ssw_paste_row_func end_of_row,
+                           struct paste_state *ps, gint max_rows);
 
 /* A GtkClipboardReceived callback function, which parses
    the selection data SD as HTML, and sets PASTE_STATE accordingly.  */
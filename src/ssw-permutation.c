@@ -0,0 +1,298 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include "ssw-permutation.h"
+
+/* The view positions VIEW .. VIEW + LENGTH - 1 display the model
+   positions MODEL .. MODEL + LENGTH - 1 */
+struct segment
+{
+  gint view;
+  gint model;
+  gint length;
+};
+
+struct ssw_permutation
+{
+  /* The segments, in view order.  Empty if the permutation is the
+     identity */
+  GArray *segments;
+
+  /* The sum of the lengths of the segments */
+  gint length;
+};
+
+#define SEGMENT(A, I) (g_array_index ((A), struct segment, (I)))
+
+struct ssw_permutation *
+ssw_permutation_new (void)
+{
+  struct ssw_permutation *p = g_malloc (sizeof *p);
+  p->segments = g_array_new (FALSE, FALSE, sizeof (struct segment));
+  p->length = 0;
+  return p;
+}
+
+void
+ssw_permutation_free (struct ssw_permutation *p)
+{
+  if (p == NULL)
+    return;
+
+  g_array_free (p->segments, TRUE);
+  g_free (p);
+}
+
+void
+ssw_permutation_reset (struct ssw_permutation *p)
+{
+  g_array_set_size (p->segments, 0);
+  p->length = 0;
+}
+
+gboolean
+ssw_permutation_is_identity (const struct ssw_permutation *p)
+{
+  return p == NULL || p->segments->len == 0;
+}
+
+gint
+ssw_permutation_get_length (const struct ssw_permutation *p)
+{
+  return p ? p->length : 0;
+}
+
+/* Return the index of the segment which contains the view position
+   VIEW.  VIEW must be less than the length of the permutation.  */
+static guint
+find_segment (const GArray *segments, gint view)
+{
+  guint lo = 0;
+  guint hi = segments->len;
+
+  while (hi - lo > 1)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (SEGMENT (segments, mid).view <= view)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+gint
+ssw_permutation_map (const struct ssw_permutation *p, gint view)
+{
+  if (ssw_permutation_is_identity (p) || view < 0 || view >= p->length)
+    return view;
+
+  const struct segment *s = &SEGMENT (p->segments, find_segment (p->segments, view));
+
+  return s->model + (view - s->view);
+}
+
+/* Ensure that a segment starts at the view position VIEW */
+static void
+split_at (struct ssw_permutation *p, gint view)
+{
+  if (view <= 0 || view >= p->length)
+    return;
+
+  guint i = find_segment (p->segments, view);
+  struct segment *s = &SEGMENT (p->segments, i);
+  if (s->view == view)
+    return;
+
+  struct segment tail;
+  tail.view = view;
+  tail.model = s->model + (view - s->view);
+  tail.length = s->length - (view - s->view);
+  s->length = view - s->view;
+
+  g_array_insert_val (p->segments, i + 1, tail);
+}
+
+/* Recalculate the view positions of the segments, merging those which
+   have become contiguous in the model.  */
+static void
+normalise (struct ssw_permutation *p)
+{
+  GArray *segments = p->segments;
+  gint view = 0;
+  guint i, j = 0;
+
+  for (i = 0; i < segments->len; ++i)
+    {
+      struct segment s = SEGMENT (segments, i);
+
+      if (j > 0)
+        {
+          struct segment *prev = &SEGMENT (segments, j - 1);
+          if (prev->model + prev->length == s.model)
+            {
+              prev->length += s.length;
+              view += s.length;
+              continue;
+            }
+        }
+
+      s.view = view;
+      view += s.length;
+      SEGMENT (segments, j++) = s;
+    }
+  g_array_set_size (segments, j);
+
+  /* A single segment covering everything is the identity */
+  if (j == 1)
+    ssw_permutation_reset (p);
+}
+
+/* Append the segment of LENGTH model positions starting at MODEL to
+   SEGMENTS, unless it is empty */
+static void
+append_segment (GArray *segments, gint model, gint length)
+{
+  if (length > 0)
+    {
+      struct segment s = {0, model, length};
+      g_array_append_val (segments, s);
+    }
+}
+
+void
+ssw_permutation_move (struct ssw_permutation *p, gint n, gint from, gint to)
+{
+  if (n <= 0)
+    return;
+
+  if (ssw_permutation_is_identity (p))
+    {
+      struct segment all = {0, 0, n};
+      g_array_set_size (p->segments, 0);
+      g_array_append_val (p->segments, all);
+      p->length = n;
+    }
+  else if (p->length < n)
+    {
+      /* Positions beyond the end map onto themselves */
+      struct segment tail = {p->length, p->length, n - p->length};
+      g_array_append_val (p->segments, tail);
+      p->length = n;
+    }
+
+  g_return_if_fail (from >= 0 && from < p->length);
+  g_return_if_fail (to >= 0 && to <= p->length);
+
+  if (to == from || to == from + 1)
+    {
+      normalise (p);
+      return;
+    }
+
+  split_at (p, from);
+  split_at (p, from + 1);
+  split_at (p, to);
+
+  guint src = find_segment (p->segments, from);
+  guint dest = (to < p->length) ? find_segment (p->segments, to) : p->segments->len;
+
+  struct segment moved = SEGMENT (p->segments, src);
+  g_array_remove_index (p->segments, src);
+  if (dest > src)
+    dest--;
+  g_array_insert_val (p->segments, dest, moved);
+
+  normalise (p);
+}
+
+void
+ssw_permutation_shift (struct ssw_permutation *p, gint posn, gint rm, gint add)
+{
+  if (ssw_permutation_is_identity (p) || rm == add || posn > p->length)
+    return;
+
+  /* A change straddling the end of the permutation cannot be
+     followed */
+  if (posn + rm > p->length)
+    {
+      ssw_permutation_reset (p);
+      return;
+    }
+
+  GArray *old = p->segments;
+  GArray *segments = g_array_sized_new (FALSE, FALSE, sizeof (struct segment),
+                                        old->len + 2);
+  gboolean inserted = FALSE;
+  guint i;
+
+  for (i = 0; i < old->len; ++i)
+    {
+      const struct segment *s = &SEGMENT (old, i);
+      gint end = s->model + s->length;
+
+      /* The part before the change keeps its model positions */
+      append_segment (segments, s->model, MIN (end, posn) - s->model);
+
+      /* The part after it moves with the rows which follow.  The new
+         rows are displayed immediately before the row which used to
+         follow the removed ones.  */
+      gint first = MAX (s->model, posn + rm);
+      if (first == posn + rm && first < end)
+        {
+          append_segment (segments, posn, add);
+          inserted = TRUE;
+        }
+      append_segment (segments, first + add - rm, end - first);
+    }
+
+  if (!inserted)
+    append_segment (segments, posn, add);
+
+  g_array_free (old, TRUE);
+  p->segments = segments;
+  p->length += add - rm;
+
+  normalise (p);
+}
+
+gint *
+ssw_permutation_export (const struct ssw_permutation *p, gint n)
+{
+  gint *order = g_malloc_n (n, sizeof *order);
+  gint v = 0;
+
+  if (!ssw_permutation_is_identity (p))
+    {
+      guint i;
+      for (i = 0; i < p->segments->len && v < n; ++i)
+        {
+          const struct segment *s = &SEGMENT (p->segments, i);
+          gint k;
+          for (k = 0; k < s->length && v < n; ++k)
+            order[v++] = s->model + k;
+        }
+    }
+
+  for (; v < n; ++v)
+    order[v] = v;
+
+  return order;
+}
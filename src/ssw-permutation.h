@@ -0,0 +1,64 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A permutation of the integers 0 .. n - 1, mapping positions in the
+   view onto positions in the data model.  It is held as a sequence of
+   segments, each of which maps a run of consecutive view positions
+   onto a run of consecutive model positions.  Every move adds at most
+   three segments, so lookups and moves cost the same however large n
+   may be.  Positions beyond the end of the permutation map onto
+   themselves.  */
+
+#ifndef _SSW_PERMUTATION_H
+#define _SSW_PERMUTATION_H
+
+#include <glib.h>
+
+struct ssw_permutation;
+
+struct ssw_permutation *ssw_permutation_new (void);
+void ssw_permutation_free (struct ssw_permutation *p);
+
+/* Make P the identity permutation */
+void ssw_permutation_reset (struct ssw_permutation *p);
+
+gboolean ssw_permutation_is_identity (const struct ssw_permutation *p);
+
+/* The number of positions which P permutes.  Zero if P is the identity */
+gint ssw_permutation_get_length (const struct ssw_permutation *p);
+
+/* Return the model position displayed at view position VIEW */
+gint ssw_permutation_map (const struct ssw_permutation *p, gint view);
+
+/* Move the item at view position FROM, such that it is placed
+   immediately before the item currently at position TO.  N is the
+   total number of items.  */
+void ssw_permutation_move (struct ssw_permutation *p, gint n,
+                           gint from, gint to);
+
+/* Follow a change to the data model, in which the RM items at model
+   position POSN were replaced by ADD new ones.  The remaining items
+   keep their places in the view, and the new ones are displayed
+   immediately before the item which followed the removed ones.  */
+void ssw_permutation_shift (struct ssw_permutation *p, gint posn,
+                            gint rm, gint add);
+
+/* Return a newly allocated array of N model positions, in view order */
+gint *ssw_permutation_export (const struct ssw_permutation *p, gint n);
+
+#endif
@@ -0,0 +1,189 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include "ssw-render-cache.h"
+
+/* The number of cells held before the least recently used are
+   forgotten.  This is ample for the visible cells of four panes.  */
+#define RENDER_CACHE_CELLS 16384
+
+struct cell
+{
+  gint col;
+  gint row;
+  GtkCellRenderer *renderer;
+  gchar *text;
+};
+
+/* The cells are held in two generations.  Those used since the
+   current generation began are in CURRENT.  When it is full, it
+   becomes the previous generation, and whatever was in the previous
+   generation is forgotten.  */
+struct ssw_render_cache
+{
+  GHashTable *current;
+  GHashTable *previous;
+};
+
+static guint
+cell_hash (gconstpointer key)
+{
+  const struct cell *cell = key;
+
+  return (guint) cell->col * 0x9E3779B1u ^ (guint) cell->row;
+}
+
+static gboolean
+cell_equal (gconstpointer a, gconstpointer b)
+{
+  const struct cell *ca = a;
+  const struct cell *cb = b;
+
+  return ca->col == cb->col && ca->row == cb->row;
+}
+
+static void
+cell_free (gpointer data)
+{
+  struct cell *cell = data;
+
+  if (cell->renderer)
+    g_object_unref (cell->renderer);
+  g_free (cell->text);
+  g_free (cell);
+}
+
+static GHashTable *
+generation_new (void)
+{
+  return g_hash_table_new_full (cell_hash, cell_equal, cell_free, NULL);
+}
+
+struct ssw_render_cache *
+ssw_render_cache_new (void)
+{
+  struct ssw_render_cache *c = g_malloc (sizeof *c);
+
+  c->current = generation_new ();
+  c->previous = generation_new ();
+
+  return c;
+}
+
+void
+ssw_render_cache_free (struct ssw_render_cache *c)
+{
+  if (c == NULL)
+    return;
+
+  g_hash_table_destroy (c->current);
+  g_hash_table_destroy (c->previous);
+  g_free (c);
+}
+
+struct row_range
+{
+  gint row0;
+  gint n_rows;
+};
+
+static gboolean
+in_rows (gpointer key, gpointer value, gpointer data)
+{
+  const struct cell *cell = key;
+  const struct row_range *range = data;
+
+  return cell->row >= range->row0 && cell->row < range->row0 + range->n_rows;
+}
+
+void
+ssw_render_cache_invalidate (struct ssw_render_cache *c,
+                             gint row0, gint n_rows)
+{
+  if (n_rows < 0)
+    {
+      g_hash_table_remove_all (c->current);
+      g_hash_table_remove_all (c->previous);
+      return;
+    }
+
+  struct row_range range = {row0, n_rows};
+  g_hash_table_foreach_remove (c->current, in_rows, &range);
+  g_hash_table_foreach_remove (c->previous, in_rows, &range);
+}
+
+/* Start a new generation if the current one is full */
+static void
+age (struct ssw_render_cache *c)
+{
+  if (g_hash_table_size (c->current) < RENDER_CACHE_CELLS)
+    return;
+
+  GHashTable *old = c->previous;
+  c->previous = c->current;
+  c->current = old;
+  g_hash_table_remove_all (c->current);
+}
+
+gboolean
+ssw_render_cache_lookup (struct ssw_render_cache *c,
+                         gint col, gint row,
+                         GtkCellRenderer **renderer,
+                         const gchar **text)
+{
+  struct cell key = {col, row, NULL, NULL};
+  struct cell *cell = g_hash_table_lookup (c->current, &key);
+
+  if (cell == NULL)
+    {
+      /* A cell of the previous generation is still in use, so it
+         moves to the current one */
+      gpointer k;
+      if (!g_hash_table_lookup_extended (c->previous, &key, &k, NULL))
+        return FALSE;
+
+      cell = k;
+      g_hash_table_steal (c->previous, cell);
+      age (c);
+      g_hash_table_add (c->current, cell);
+    }
+
+  *renderer = cell->renderer;
+  *text = cell->text;
+
+  return TRUE;
+}
+
+void
+ssw_render_cache_insert (struct ssw_render_cache *c,
+                         gint col, gint row,
+                         GtkCellRenderer *renderer,
+                         const gchar *text)
+{
+  struct cell *cell = g_malloc (sizeof *cell);
+
+  cell->col = col;
+  cell->row = row;
+  cell->renderer = renderer ? g_object_ref (renderer) : NULL;
+  cell->text = g_strdup (text);
+
+  g_hash_table_remove (c->previous, cell);
+  age (c);
+  g_hash_table_add (c->current, cell);
+}
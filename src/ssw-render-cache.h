@@ -0,0 +1,59 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* The renderers chosen for the cells of a sheet, and the text to which
+   their data were converted, kept so that drawing a cell again costs
+   neither a read of the data model nor a conversion.  The cache
+   belongs to the sheet, so that a cell which is shown in several panes
+   of a split sheet is converted once.  Cells are identified by their
+   column and row in the data model.
+
+   The cache holds the cells used recently.  When it has filled, the
+   cells which have not been used since it last filled are forgotten.  */
+
+#ifndef _SSW_RENDER_CACHE_H
+#define _SSW_RENDER_CACHE_H
+
+#include <gtk/gtk.h>
+
+struct ssw_render_cache;
+
+struct ssw_render_cache *ssw_render_cache_new (void);
+void ssw_render_cache_free (struct ssw_render_cache *c);
+
+/* Forget the cells in the rows ROW0 .. ROW0 + N_ROWS - 1 of the data
+   model, or all cells if N_ROWS is negative.  */
+void ssw_render_cache_invalidate (struct ssw_render_cache *c,
+                                  gint row0, gint n_rows);
+
+/* If the cell COL, ROW is in the cache, store its renderer in RENDERER
+   and its text in TEXT, and return TRUE.  The renderer may be NULL,
+   meaning the default.  The text belongs to the cache, and may be
+   NULL.  It remains valid until the cache is next used.  */
+gboolean ssw_render_cache_lookup (struct ssw_render_cache *c,
+                                  gint col, gint row,
+                                  GtkCellRenderer **renderer,
+                                  const gchar **text);
+
+/* Remember RENDERER and a copy of TEXT for the cell COL, ROW */
+void ssw_render_cache_insert (struct ssw_render_cache *c,
+                              gint col, gint row,
+                              GtkCellRenderer *renderer,
+                              const gchar *text);
+
+#endif
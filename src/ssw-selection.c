@@ -0,0 +1,567 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <string.h>
+#include "ssw-selection.h"
+
+/* The positions START .. END inclusive.  OFFSET is the number of
+   positions in the preceding intervals of the same list.  */
+struct interval
+{
+  gint start;
+  gint end;
+  gint offset;
+};
+
+/* The rows START .. END inclusive, in which the selected columns are
+   the N intervals beginning at FIRST.  */
+struct band
+{
+  gint start;
+  gint end;
+  guint first;
+  guint n;
+};
+
+struct _SswSelection
+{
+  /* The ranges, as added */
+  GArray *ranges;
+
+  /* Their union */
+  GArray *bands;
+  GArray *intervals;
+
+  /* The rows and columns which they cover */
+  GArray *rows;
+  GArray *columns;
+
+  /* The same, for all the ranges but the last.  The last range is the
+     one which changes as the pointer is dragged, so only it need be
+     added afresh.  */
+  GArray *base_bands;
+  GArray *base_intervals;
+  GArray *base_rows;
+  GArray *base_columns;
+};
+
+#define RANGE(A, I) (g_array_index ((A), SswRange, (I)))
+#define BAND(A, I) (g_array_index ((A), struct band, (I)))
+#define INTERVAL(A, I) (g_array_index ((A), struct interval, (I)))
+
+SswSelection *
+ssw_selection_new (void)
+{
+  SswSelection *sel = g_malloc (sizeof *sel);
+
+  sel->ranges = g_array_new (FALSE, FALSE, sizeof (SswRange));
+  sel->bands = g_array_new (FALSE, FALSE, sizeof (struct band));
+  sel->intervals = g_array_new (FALSE, FALSE, sizeof (struct interval));
+  sel->rows = g_array_new (FALSE, FALSE, sizeof (struct interval));
+  sel->columns = g_array_new (FALSE, FALSE, sizeof (struct interval));
+  sel->base_bands = g_array_new (FALSE, FALSE, sizeof (struct band));
+  sel->base_intervals = g_array_new (FALSE, FALSE, sizeof (struct interval));
+  sel->base_rows = g_array_new (FALSE, FALSE, sizeof (struct interval));
+  sel->base_columns = g_array_new (FALSE, FALSE, sizeof (struct interval));
+
+  return sel;
+}
+
+void
+ssw_selection_free (SswSelection *sel)
+{
+  if (sel == NULL)
+    return;
+
+  g_array_free (sel->ranges, TRUE);
+  g_array_free (sel->bands, TRUE);
+  g_array_free (sel->intervals, TRUE);
+  g_array_free (sel->rows, TRUE);
+  g_array_free (sel->columns, TRUE);
+  g_array_free (sel->base_bands, TRUE);
+  g_array_free (sel->base_intervals, TRUE);
+  g_array_free (sel->base_rows, TRUE);
+  g_array_free (sel->base_columns, TRUE);
+  g_free (sel);
+}
+
+void
+ssw_selection_clear (SswSelection *sel)
+{
+  g_array_set_size (sel->ranges, 0);
+  g_array_set_size (sel->bands, 0);
+  g_array_set_size (sel->intervals, 0);
+  g_array_set_size (sel->rows, 0);
+  g_array_set_size (sel->columns, 0);
+  g_array_set_size (sel->base_bands, 0);
+  g_array_set_size (sel->base_intervals, 0);
+  g_array_set_size (sel->base_rows, 0);
+  g_array_set_size (sel->base_columns, 0);
+}
+
+/* Make DEST a copy of SRC */
+static void
+copy_array (GArray *dest, const GArray *src)
+{
+  g_array_set_size (dest, 0);
+  g_array_append_vals (dest, src->data, src->len);
+}
+
+/* Append the interval START .. END to the intervals of A from the
+   FIRSTth onwards, merging it with the last of them if they overlap
+   or abut.  It must not start before the last of them.  */
+static void
+push_interval (GArray *a, guint first, gint start, gint end)
+{
+  if (a->len > first)
+    {
+      struct interval *last = &INTERVAL (a, a->len - 1);
+      if (start <= last->end || start - 1 == last->end)
+        {
+          last->end = MAX (last->end, end);
+          return;
+        }
+    }
+
+  struct interval in = {start, end, 0};
+  g_array_append_val (a, in);
+}
+
+/* Append to A the N sorted, disjoint intervals IN, together with the
+   interval C0 .. C1 if INCLUDE is true, merging any which overlap or
+   abut.  */
+static void
+append_intervals (GArray *a, const struct interval *in, guint n,
+                  gboolean include, gint c0, gint c1)
+{
+  guint first = a->len;
+  guint i;
+
+  for (i = 0; i < n; ++i)
+    {
+      if (include && c0 < in[i].start)
+        {
+          push_interval (a, first, c0, c1);
+          include = FALSE;
+        }
+      push_interval (a, first, in[i].start, in[i].end);
+    }
+
+  if (include)
+    push_interval (a, first, c0, c1);
+}
+
+/* Number the positions of the intervals of A */
+static void
+number_intervals (GArray *a)
+{
+  gint offset = 0;
+  guint i;
+
+  for (i = 0; i < a->len; ++i)
+    {
+      INTERVAL (a, i).offset = offset;
+      offset += INTERVAL (a, i).end - INTERVAL (a, i).start + 1;
+    }
+}
+
+/* Make DEST the union of the intervals SRC and START .. END */
+static void
+add_interval (GArray *dest, const GArray *src, gint start, gint end)
+{
+  g_array_set_size (dest, 0);
+  append_intervals (dest, &INTERVAL (src, 0), src->len, TRUE, start, end);
+  number_intervals (dest);
+}
+
+/* Append to BANDS and INTERVALS a band of the rows START .. END, whose
+   columns are the N intervals IN, and C0 .. C1 if INCLUDE is true.
+   Nothing is appended if the band is empty.  */
+static void
+emit_band (GArray *bands, GArray *intervals, gint start, gint end,
+           const struct interval *in, guint n,
+           gboolean include, gint c0, gint c1)
+{
+  guint first = intervals->len;
+  guint j;
+
+  if (start > end)
+    return;
+
+  append_intervals (intervals, in, n, include, c0, c1);
+  if (intervals->len == first)
+    return;
+
+  struct band b = {start, end, first, intervals->len - first};
+
+  /* Extend the previous band instead, if it abuts this one and has
+     the same columns */
+  if (bands->len > 0)
+    {
+      struct band *prev = &BAND (bands, bands->len - 1);
+      gboolean same = (prev->end + 1 == start && prev->n == b.n);
+
+      for (j = 0; same && j < b.n; ++j)
+        same = (INTERVAL (intervals, prev->first + j).start
+                == INTERVAL (intervals, first + j).start
+                && INTERVAL (intervals, prev->first + j).end
+                == INTERVAL (intervals, first + j).end);
+
+      if (same)
+        {
+          prev->end = end;
+          g_array_set_size (intervals, first);
+          return;
+        }
+    }
+
+  g_array_append_val (bands, b);
+}
+
+/* Make BANDS and INTERVALS the union of the range R with the set
+   held in SRC_BANDS and SRC_INTERVALS.  This is done in a single pass
+   over the source bands.  */
+static void
+add_range (GArray *bands, GArray *intervals,
+           const GArray *src_bands, const GArray *src_intervals,
+           const SswRange *r)
+{
+  const gint r0 = r->start_y;
+  const gint r1 = r->end_y;
+  const gint c0 = r->start_x;
+  const gint c1 = r->end_x;
+
+  /* The rows of R before FROM have been emitted */
+  gint from = r0;
+  gboolean covered = FALSE;
+  guint i;
+
+  g_array_set_size (bands, 0);
+  g_array_set_size (intervals, 0);
+
+  for (i = 0; i < src_bands->len; ++i)
+    {
+      const struct band *b = &BAND (src_bands, i);
+      const struct interval *in = &INTERVAL (src_intervals, b->first);
+
+      /* Rows of R which no band covers */
+      if (!covered && b->start > from)
+        emit_band (bands, intervals, from, MIN (b->start - 1, r1),
+                   NULL, 0, TRUE, c0, c1);
+
+      if (b->start < r0)
+        emit_band (bands, intervals, b->start, MIN (b->end, r0 - 1),
+                   in, b->n, FALSE, 0, 0);
+
+      emit_band (bands, intervals, MAX (b->start, r0), MIN (b->end, r1),
+                 in, b->n, TRUE, c0, c1);
+
+      if (b->end > r1)
+        emit_band (bands, intervals, MAX (b->start, r1 + 1), b->end,
+                   in, b->n, FALSE, 0, 0);
+
+      if (b->end >= r1)
+        covered = TRUE;
+      else
+        from = MAX (from, b->end + 1);
+    }
+
+  if (!covered)
+    emit_band (bands, intervals, from, r1, NULL, 0, TRUE, c0, c1);
+}
+
+/* Recalculate the union of the ranges of SEL from the union of all
+   but the last of them */
+static void
+update (SswSelection *sel)
+{
+  if (sel->ranges->len == 0)
+    {
+      ssw_selection_clear (sel);
+      return;
+    }
+
+  const SswRange *r = &RANGE (sel->ranges, sel->ranges->len - 1);
+
+  add_range (sel->bands, sel->intervals,
+             sel->base_bands, sel->base_intervals, r);
+  add_interval (sel->rows, sel->base_rows, r->start_y, r->end_y);
+  add_interval (sel->columns, sel->base_columns, r->start_x, r->end_x);
+}
+
+/* Recalculate the union of all but the last range of SEL, one range
+   at a time */
+static void
+rebuild_base (SswSelection *sel)
+{
+  guint i;
+
+  g_array_set_size (sel->base_bands, 0);
+  g_array_set_size (sel->base_intervals, 0);
+  g_array_set_size (sel->base_rows, 0);
+  g_array_set_size (sel->base_columns, 0);
+
+  for (i = 0; i + 1 < sel->ranges->len; ++i)
+    {
+      const SswRange *r = &RANGE (sel->ranges, i);
+
+      add_range (sel->bands, sel->intervals,
+                 sel->base_bands, sel->base_intervals, r);
+      add_interval (sel->rows, sel->base_rows, r->start_y, r->end_y);
+      add_interval (sel->columns, sel->base_columns, r->start_x, r->end_x);
+
+      copy_array (sel->base_bands, sel->bands);
+      copy_array (sel->base_intervals, sel->intervals);
+      copy_array (sel->base_rows, sel->rows);
+      copy_array (sel->base_columns, sel->columns);
+    }
+}
+
+SswSelection *
+ssw_selection_copy (const SswSelection *sel)
+{
+  SswSelection *copy = ssw_selection_new ();
+
+  copy_array (copy->ranges, sel->ranges);
+  copy_array (copy->bands, sel->bands);
+  copy_array (copy->intervals, sel->intervals);
+  copy_array (copy->rows, sel->rows);
+  copy_array (copy->columns, sel->columns);
+  copy_array (copy->base_bands, sel->base_bands);
+  copy_array (copy->base_intervals, sel->base_intervals);
+  copy_array (copy->base_rows, sel->base_rows);
+  copy_array (copy->base_columns, sel->base_columns);
+
+  return copy;
+}
+
+static void
+normalise (const SswRange *in, SswRange *out)
+{
+  out->start_x = MIN (in->start_x, in->end_x);
+  out->end_x = MAX (in->start_x, in->end_x);
+  out->start_y = MIN (in->start_y, in->end_y);
+  out->end_y = MAX (in->start_y, in->end_y);
+}
+
+void
+ssw_selection_set_range (SswSelection *sel, gint i, const SswRange *r)
+{
+  SswRange n;
+
+  g_return_if_fail (i >= 0 && i <= sel->ranges->len);
+
+  normalise (r, &n);
+
+  if (i == sel->ranges->len)
+    {
+      /* The union so far becomes the base for the new range */
+      copy_array (sel->base_bands, sel->bands);
+      copy_array (sel->base_intervals, sel->intervals);
+      copy_array (sel->base_rows, sel->rows);
+      copy_array (sel->base_columns, sel->columns);
+      g_array_append_val (sel->ranges, n);
+    }
+  else if (0 == memcmp (&RANGE (sel->ranges, i), &n, sizeof n))
+    return;
+  else
+    {
+      RANGE (sel->ranges, i) = n;
+      if (i + 1 < sel->ranges->len)
+        rebuild_base (sel);
+    }
+
+  update (sel);
+}
+
+void
+ssw_selection_add (SswSelection *sel, const SswRange *r)
+{
+  ssw_selection_set_range (sel, sel->ranges->len, r);
+}
+
+gint
+ssw_selection_get_n_ranges (const SswSelection *sel)
+{
+  return sel->ranges->len;
+}
+
+void
+ssw_selection_get_range (const SswSelection *sel, gint i, SswRange *r)
+{
+  g_return_if_fail (i >= 0 && i < sel->ranges->len);
+
+  *r = RANGE (sel->ranges, i);
+}
+
+gboolean
+ssw_selection_is_empty (const SswSelection *sel)
+{
+  return sel->bands->len == 0;
+}
+
+/* Return the index of the first band of SEL which ends at or after
+   ROW, or the number of bands if there is none.  */
+static guint
+find_band (const SswSelection *sel, gint row)
+{
+  guint lo = 0;
+  guint hi = sel->bands->len;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (BAND (sel->bands, mid).end < row)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+/* Return the index of the first of the N intervals of A beginning at
+   FIRST which ends at or after POS, or FIRST + N if there is none.  */
+static guint
+find_interval (const GArray *a, guint first, guint n, gint pos)
+{
+  guint lo = first;
+  guint hi = first + n;
+
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (INTERVAL (a, mid).end < pos)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  return lo;
+}
+
+gboolean
+ssw_selection_contains (const SswSelection *sel, gint col, gint row)
+{
+  guint b = find_band (sel, row);
+  if (b >= sel->bands->len || BAND (sel->bands, b).start > row)
+    return FALSE;
+
+  const struct band *band = &BAND (sel->bands, b);
+  guint i = find_interval (sel->intervals, band->first, band->n, col);
+
+  return (i < band->first + band->n
+          && INTERVAL (sel->intervals, i).start <= col);
+}
+
+void
+ssw_selection_foreach (const SswSelection *sel, const SswRange *within,
+                       SswRangeFunc func, gpointer data)
+{
+  SswRange w = {G_MININT, G_MAXINT, G_MININT, G_MAXINT};
+  guint b, i;
+
+  if (within)
+    normalise (within, &w);
+
+  for (b = find_band (sel, w.start_y); b < sel->bands->len; ++b)
+    {
+      const struct band *band = &BAND (sel->bands, b);
+      if (band->start > w.end_y)
+        break;
+
+      for (i = find_interval (sel->intervals, band->first, band->n, w.start_x);
+           i < band->first + band->n; ++i)
+        {
+          const struct interval *in = &INTERVAL (sel->intervals, i);
+          if (in->start > w.end_x)
+            break;
+
+          SswRange r;
+          r.start_x = MAX (in->start, w.start_x);
+          r.end_x = MIN (in->end, w.end_x);
+          r.start_y = MAX (band->start, w.start_y);
+          r.end_y = MIN (band->end, w.end_y);
+          func (&r, data);
+        }
+    }
+}
+
+static gint
+count (const GArray *a)
+{
+  if (a->len == 0)
+    return 0;
+
+  const struct interval *last = &INTERVAL (a, a->len - 1);
+  return last->offset + last->end - last->start + 1;
+}
+
+/* Return the Nth position of the intervals A, or -1 if there is none */
+static gint
+nth (const GArray *a, gint n)
+{
+  guint lo = 0;
+  guint hi = a->len;
+
+  if (n < 0)
+    return -1;
+
+  /* Find the last interval whose offset does not exceed N */
+  while (hi - lo > 1)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      if (INTERVAL (a, mid).offset <= n)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  if (lo >= a->len)
+    return -1;
+
+  const struct interval *in = &INTERVAL (a, lo);
+  gint pos = in->start + n - in->offset;
+
+  return (pos <= in->end) ? pos : -1;
+}
+
+gint
+ssw_selection_get_n_rows (const SswSelection *sel)
+{
+  return count (sel->rows);
+}
+
+gint
+ssw_selection_get_n_columns (const SswSelection *sel)
+{
+  return count (sel->columns);
+}
+
+gint
+ssw_selection_nth_row (const SswSelection *sel, gint n)
+{
+  return nth (sel->rows, n);
+}
+
+gint
+ssw_selection_nth_column (const SswSelection *sel, gint n)
+{
+  return nth (sel->columns, n);
+}
@@ -0,0 +1,73 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* A set of selected cells, being the union of any number of
+   rectangular ranges.  The union is held as a sequence of disjoint
+   bands of rows, each with a sorted list of merged column intervals.
+   Hence its size depends only upon the number of ranges, not upon
+   the number of cells, and membership is tested by two binary
+   searches.  */
+
+#ifndef _SSW_SELECTION_H
+#define _SSW_SELECTION_H
+
+#include "ssw-sheet.h"
+
+SswSelection *ssw_selection_new (void);
+SswSelection *ssw_selection_copy (const SswSelection *sel);
+void ssw_selection_free (SswSelection *sel);
+
+/* Remove all ranges from SEL */
+void ssw_selection_clear (SswSelection *sel);
+
+/* Add the range R to SEL.  Its corners may be given in any order */
+void ssw_selection_add (SswSelection *sel, const SswRange *r);
+
+/* Replace the Ith range of SEL with R.  If I is the number of ranges,
+   then R is added.  Adding a range, or replacing the last, takes time
+   proportional to the size of the union; replacing any other range
+   recalculates the union from the start.  */
+void ssw_selection_set_range (SswSelection *sel, gint i, const SswRange *r);
+
+/* The ranges in the order in which they were added, with their
+   corners normalised.  Ranges may overlap.  */
+gint ssw_selection_get_n_ranges (const SswSelection *sel);
+void ssw_selection_get_range (const SswSelection *sel, gint i, SswRange *r);
+
+gboolean ssw_selection_is_empty (const SswSelection *sel);
+
+gboolean ssw_selection_contains (const SswSelection *sel, gint col, gint row);
+
+typedef void (*SswRangeFunc) (const SswRange *r, gpointer data);
+
+/* Call FUNC for each of a set of disjoint ranges, whose union is the
+   part of SEL within WITHIN, or the whole of SEL if WITHIN is NULL.
+   The ranges are visited from top to bottom, and from left to right.  */
+void ssw_selection_foreach (const SswSelection *sel, const SswRange *within,
+                            SswRangeFunc func, gpointer data);
+
+/* The number of rows (columns) which contain at least one selected
+   cell, and the Nth of them.  Together they describe the table which
+   results from removing every row and column which contains no
+   selected cell.  */
+gint ssw_selection_get_n_rows (const SswSelection *sel);
+gint ssw_selection_get_n_columns (const SswSelection *sel);
+gint ssw_selection_nth_row (const SswSelection *sel, gint n);
+gint ssw_selection_nth_column (const SswSelection *sel, gint n);
+
+#endif
@@ -0,0 +1,295 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <string.h>
+#include "ssw-serializer.h"
+
+/* The number of cells sampled by ssw_serialize_estimate */
+#define N_SAMPLES 64
+
+static void
+csv_escape (GString *out, const gchar *text, gsize len)
+{
+  gsize i;
+
+  if (len == 0 || strcspn (text, ",\"\r\n") >= len)
+    {
+      g_string_append_len (out, text, len);
+      return;
+    }
+
+  g_string_append_c (out, '"');
+  for (i = 0; i < len; ++i)
+    {
+      if (text[i] == '"')
+        g_string_append_c (out, '"');
+      g_string_append_c (out, text[i]);
+    }
+  g_string_append_c (out, '"');
+}
+
+static void
+html_escape (GString *out, const gchar *text, gsize len)
+{
+  gsize i;
+
+  for (i = 0; i < len; ++i)
+    {
+      switch (text[i])
+        {
+        case '&':
+          g_string_append (out, "&amp;");
+          break;
+        case '<':
+          g_string_append (out, "&lt;");
+          break;
+        case '>':
+          g_string_append (out, "&gt;");
+          break;
+        case '"':
+          g_string_append (out, "&quot;");
+          break;
+        default:
+          g_string_append_c (out, text[i]);
+          break;
+        }
+    }
+}
+
+static void
+snapshot_escape (GString *out, const gchar *text, gsize len)
+{
+  gsize i;
+
+  for (i = 0; i < len; ++i)
+    {
+      switch (text[i])
+        {
+        case '\\':
+          g_string_append (out, "\\\\");
+          break;
+        case '\t':
+          g_string_append (out, "\\t");
+          break;
+        case '\n':
+          g_string_append (out, "\\n");
+          break;
+        default:
+          g_string_append_c (out, text[i]);
+          break;
+        }
+    }
+}
+
+const struct ssw_format ssw_format_tsv =
+  {
+   "", "",
+   "", "", "\n",
+   "", "", "\t",
+   NULL
+  };
+
+const struct ssw_format ssw_format_csv =
+  {
+   "", "",
+   "", "", "\r\n",
+   "", "", ",",
+   csv_escape
+  };
+
+const struct ssw_format ssw_format_html =
+  {
+   "<body>\n<table>\n", "</table>\n</body>\n",
+   "<tr>\n", "</tr>\n", "",
+   "<td>", "</td>\n", "",
+   html_escape
+  };
+
+const struct ssw_format ssw_format_snapshot =
+  {
+   "", "",
+   "", "", "\n",
+   "", "", "\t",
+   snapshot_escape
+  };
+
+/* Append S to OUT, unless it is empty */
+static inline void
+append_part (GString *out, const gchar *s)
+{
+  if (*s)
+    g_string_append (out, s);
+}
+
+void
+ssw_serialize (const struct ssw_format *fmt,
+               const struct ssw_cell_source *src,
+               gint first_row, gint last_row, GString *out)
+{
+  const SswRange *r = &src->range;
+  GString *scratch = fmt->escape ? g_string_sized_new (64) : NULL;
+  gint row, col;
+
+  if (first_row == r->start_y)
+    append_part (out, fmt->table_start);
+
+  for (row = first_row; row <= last_row; ++row)
+    {
+      GtkTreeIter iter;
+      const gboolean populated = src->fetch_row (src->data, r, row, &iter);
+
+      append_part (out, fmt->row_start);
+      for (col = r->start_x; col <= r->end_x; ++col)
+        {
+          append_part (out, fmt->cell_start);
+          if (populated)
+            {
+              if (scratch)
+                {
+                  g_string_truncate (scratch, 0);
+                  src->cell_text (src->data, &iter, col, row, scratch);
+                  fmt->escape (out, scratch->str, scratch->len);
+                }
+              else
+                src->cell_text (src->data, &iter, col, row, out);
+            }
+          append_part (out, fmt->cell_end);
+
+          if (col < r->end_x)
+            append_part (out, fmt->cell_separator);
+        }
+      append_part (out, fmt->row_end);
+
+      if (row < r->end_y)
+        append_part (out, fmt->row_separator);
+    }
+
+  if (last_row == r->end_y)
+    append_part (out, fmt->table_end);
+
+  if (scratch)
+    g_string_free (scratch, TRUE);
+}
+
+gint64
+ssw_serialize_estimate (const struct ssw_format *fmt,
+                        const struct ssw_cell_source *src)
+{
+  const SswRange *r = &src->range;
+  const gint64 n_rows = r->end_y - r->start_y + 1;
+  const gint64 n_cols = r->end_x - r->start_x + 1;
+
+  if (n_rows <= 0 || n_cols <= 0)
+    return 0;
+
+  const gint64 n_cells = n_rows * n_cols;
+  const gint n_samples = MIN (n_cells, N_SAMPLES);
+  GString *scratch = g_string_sized_new (64);
+  gint64 sampled = 0;
+  gint i;
+
+  for (i = 0; i < n_samples; ++i)
+    {
+      /* Step through the rows in order, and through the columns
+         by a stride which is coprime to most widths.  */
+      gint row = r->start_y + (i * n_rows) / n_samples;
+      gint col = r->start_x + (i * 7919) % n_cols;
+      GtkTreeIter iter;
+
+      if (!src->fetch_row (src->data, r, row, &iter))
+        continue;
+
+      g_string_truncate (scratch, 0);
+      src->cell_text (src->data, &iter, col, row, scratch);
+      sampled += scratch->len;
+    }
+  g_string_free (scratch, TRUE);
+
+  const gint64 per_cell = strlen (fmt->cell_start) + strlen (fmt->cell_end)
+    + strlen (fmt->cell_separator);
+  const gint64 per_row = strlen (fmt->row_start) + strlen (fmt->row_end)
+    + strlen (fmt->row_separator);
+
+  return (sampled * n_cells) / n_samples
+    + per_cell * n_cells + per_row * n_rows
+    + strlen (fmt->table_start) + strlen (fmt->table_end);
+}
+
+static gboolean
+snapshot_fetch_row (gpointer data, const SswRange *range, gint row,
+                    GtkTreeIter *iter)
+{
+  return TRUE;
+}
+
+/* Append the next cell of the snapshot to OUT, unescaped, and move
+   past the separator which follows it */
+static void
+snapshot_cell_text (gpointer data, GtkTreeIter *iter, gint col, gint row,
+                    GString *out)
+{
+  struct ssw_snapshot_reader *rd = data;
+  const gchar *p = rd->pos;
+
+  while (p < rd->end && *p != '\t' && *p != '\n')
+    {
+      const gchar *run = p;
+      while (p < rd->end && *p != '\t' && *p != '\n' && *p != '\\')
+        p++;
+      g_string_append_len (out, run, p - run);
+
+      if (p < rd->end && *p == '\\' && p + 1 < rd->end)
+        {
+          switch (p[1])
+            {
+            case 't':
+              g_string_append_c (out, '\t');
+              break;
+            case 'n':
+              g_string_append_c (out, '\n');
+              break;
+            default:
+              g_string_append_c (out, p[1]);
+              break;
+            }
+          p += 2;
+        }
+      else if (p < rd->end && *p == '\\')
+        p++;
+    }
+
+  rd->pos = p < rd->end ? p + 1 : p;
+}
+
+void
+ssw_snapshot_source_init (struct ssw_cell_source *src,
+                          struct ssw_snapshot_reader *rd,
+                          const GString *text,
+                          gint n_cols, gint n_rows)
+{
+  rd->pos = text->str;
+  rd->end = text->str + text->len;
+
+  src->range.start_x = src->range.start_y = 0;
+  src->range.end_x = n_cols - 1;
+  src->range.end_y = n_rows - 1;
+  src->fetch_row = snapshot_fetch_row;
+  src->cell_text = snapshot_cell_text;
+  src->data = rd;
+}
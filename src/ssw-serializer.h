@@ -0,0 +1,113 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Conversion of a rectangular range of cells to text, in one of
+   several formats.  The engine walks the range once; each format
+   supplies only the text which surrounds and separates the cells,
+   and the escaping which the cell text needs.  */
+
+#ifndef _SSW_SERIALIZER_H
+#define _SSW_SERIALIZER_H
+
+#include <gtk/gtk.h>
+#include "ssw-sheet.h"
+
+struct ssw_format
+{
+  /* Emitted before the first row and after the last */
+  const gchar *table_start;
+  const gchar *table_end;
+
+  /* Emitted around each row, and between consecutive rows */
+  const gchar *row_start;
+  const gchar *row_end;
+  const gchar *row_separator;
+
+  /* Emitted around each cell, and between consecutive cells of a row */
+  const gchar *cell_start;
+  const gchar *cell_end;
+  const gchar *cell_separator;
+
+  /* Append the LEN bytes of TEXT to OUT, escaped as the format
+     requires.  NULL if the text is to be appended verbatim.  */
+  void (*escape) (GString *out, const gchar *text, gsize len);
+};
+
+/* Tab separated values */
+extern const struct ssw_format ssw_format_tsv;
+
+/* Comma separated values, quoted as per RFC 4180 */
+extern const struct ssw_format ssw_format_csv;
+
+/* An HTML table */
+extern const struct ssw_format ssw_format_html;
+
+/* Tab separated values in which tabs, newlines and backslashes within
+   the cells are escaped, so that the cells can be read back exactly
+   through ssw_snapshot_source_init, and served in any other format */
+extern const struct ssw_format ssw_format_snapshot;
+
+/* The cells to be serialized, and how to read them */
+struct ssw_cell_source
+{
+  /* The cells, which must all exist in the model */
+  SswRange range;
+
+  /* Set ITER to the row of the model displayed at ROW.  Return FALSE
+     if no cell of that row within RANGE has anything to display.  */
+  gboolean (*fetch_row) (gpointer data, const SswRange *range,
+                         gint row, GtkTreeIter *iter);
+
+  /* Append the text of the cell displayed at COL, ROW to OUT.  ITER
+     is as set by FETCH_ROW.  */
+  void (*cell_text) (gpointer data, GtkTreeIter *iter, gint col, gint row,
+                     GString *out);
+
+  gpointer data;
+};
+
+/* Append the rows FIRST_ROW to LAST_ROW of SRC to OUT in format FMT.
+   The table's opening and closing text are included if the rows are
+   the first or last of the range respectively.  Hence a range may be
+   serialized piecewise and the pieces concatenated.  */
+void ssw_serialize (const struct ssw_format *fmt,
+                    const struct ssw_cell_source *src,
+                    gint first_row, gint last_row, GString *out);
+
+/* The position reached in a snapshot being read */
+struct ssw_snapshot_reader
+{
+  const gchar *pos;
+  const gchar *end;
+};
+
+/* Make SRC read the N_COLS by N_ROWS cells of TEXT, which was
+   serialized in ssw_format_snapshot, as the range whose top left cell
+   is 0, 0.  RD holds the position reached, so the rows must be read
+   in order, from the first.  */
+void ssw_snapshot_source_init (struct ssw_cell_source *src,
+                               struct ssw_snapshot_reader *rd,
+                               const GString *text,
+                               gint n_cols, gint n_rows);
+
+/* Estimate the number of bytes which ssw_serialize would produce for
+   the whole of SRC, by sampling some of its cells.  */
+gint64 ssw_serialize_estimate (const struct ssw_format *fmt,
+                               const struct ssw_cell_source *src);
+
+#endif
@@ -79,8 +79,9 @@ struct _SswSheetAxisPrivate
   gint (*get_q_size) (GtkAllocation *);
   gint (*get_p_size) (GtkAllocation *);
 
-  /* A table of all the items whose sizes have been manually overridden */
-  GHashTable *size_override;
+  /* The sizes of all the items whose sizes have been manually
+     overridden.  It may be shared with other axes.  */
+  SswAxisGeometry *geometry;
 
   GtkGesture *button_gest;
   gint n_press;
@@ -98,6 +99,19 @@ struct _SswSheetAxisPrivate
   gulong drag_handler_id;
   GtkTargetList *drag_target_list;
 
+  /* If not NULL, maps the position of an item onto the position in
+     the model from which it should be fetched */
+  ssw_sheet_axis_index_map index_map;
+  gpointer index_map_data;
+
+  /* The number of items at the start which do not scroll, the items
+     which show them, and their total size.  They are held in their own
+     window, which lies above the start of BIN_WINDOW.  */
+  gint n_frozen;
+  GPtrArray *frozen_widgets;
+  GdkWindow *frozen_window;
+  gint frozen_size;
+
   gboolean dispose_has_run;
 };
 
@@ -120,10 +134,13 @@ enum  {CHANGED,
        HEADER_BUTTON_PRESSED,
        HEADER_BUTTON_RELEASED,
        DRAG_N_DROP,
+       SIZE_OVERRIDDEN,
        n_SIGNALS};
 
 static guint signals [n_SIGNALS];
 
+static void on_size_changed (SswAxisGeometry *geometry, gint pos, gpointer data);
+
 static void
 zz_set_alloc_x (GtkAllocation *alloc, gint offset)
 {
@@ -197,7 +214,8 @@ enum
    PROP_0,
    PROP_ADJUSTMENT,
    PROP_ORIENTATION,
-   PROP_DRAGGABLE
+   PROP_DRAGGABLE,
+   PROP_FROZEN
   };
 
 
@@ -321,7 +339,9 @@ get_widget (SswSheetAxis *axis, guint index)
 {
   PRIV_DECL (axis);
 
-  GtkWidget *new_widget = g_list_model_get_item (priv->model, index);
+  guint item = priv->index_map
+    ? priv->index_map (index, priv->index_map_data) : index;
+  GtkWidget *new_widget = g_list_model_get_item (priv->model, item);
 
   if (priv->pool->len > 0)
     {
@@ -339,13 +359,13 @@ get_widget (SswSheetAxis *axis, guint index)
 
   /* Check if the size of this item has been specifically overridden
      by the user.  If it has set the size request accordingly. */
-  gpointer size = g_hash_table_lookup (priv->size_override, GINT_TO_POINTER (index));
-  if (size)
+  gint size = ssw_axis_geometry_get_size (priv->geometry, index);
+  if (size >= 0)
     {
       if (priv->orientation == GTK_ORIENTATION_HORIZONTAL)
-        gtk_widget_set_size_request (new_widget, GPOINTER_TO_INT (size), -1);
+        gtk_widget_set_size_request (new_widget, size, -1);
       else
-        gtk_widget_set_size_request (new_widget, -1, GPOINTER_TO_INT (size));
+        gtk_widget_set_size_request (new_widget, -1, size);
     }
 
   if (g_object_is_floating (new_widget))
@@ -401,6 +421,111 @@ free_limit (gpointer data)
   g_slice_free (SswGeometry, data);
 }
 
+/* Allocate the frozen items, which lie at the start of the axis
+   whatever its scroll position, and record their geometry */
+static void
+position_frozen (SswSheetAxis *axis)
+{
+  GtkAllocation alloc;
+  GtkAllocation child_alloc;
+  PRIV_DECL (axis);
+  const gboolean rtl = ssw_sheet_axis_rtl (axis);
+  gint offset = 0;
+  gint i;
+
+  gtk_widget_get_allocation (GTK_WIDGET (axis), &alloc);
+
+  priv->set_q_offset (&child_alloc, 0);
+  priv->set_q_size (&child_alloc, priv->get_q_size (&alloc));
+
+  g_ptr_array_set_size (axis->frozen_limits, 0);
+
+  for (i = 0; i < priv->frozen_widgets->len; ++i)
+    {
+      GtkWidget *item = g_ptr_array_index (priv->frozen_widgets, i);
+      gint size;
+
+      priv->get_preferred_p_for_q (item, priv->get_q_size (&alloc),
+                                   &size, NULL);
+
+      SswGeometry *geom = g_slice_new (SswGeometry);
+      geom->position = offset;
+      geom->size = size;
+      g_ptr_array_add (axis->frozen_limits, geom);
+
+      offset += size;
+    }
+  priv->frozen_size = offset;
+
+  /* The items are allocated within the frozen window, which lies at
+     the right of a right to left axis */
+  for (i = 0; i < priv->frozen_widgets->len; ++i)
+    {
+      GtkWidget *item = g_ptr_array_index (priv->frozen_widgets, i);
+      SswGeometry *geom = g_ptr_array_index (axis->frozen_limits, i);
+      gint p = rtl
+        ? priv->frozen_size - geom->position - geom->size
+        : geom->position;
+
+      priv->set_p_offset (&child_alloc, p);
+      priv->set_p_size (&child_alloc, geom->size);
+      gtk_widget_size_allocate (item, &child_alloc);
+
+      if (rtl)
+        geom->position = alloc.width - priv->frozen_size + p;
+    }
+
+  if (priv->frozen_window == NULL)
+    return;
+
+  if (priv->frozen_size == 0)
+    {
+      gdk_window_hide (priv->frozen_window);
+      return;
+    }
+
+  if (priv->orientation == GTK_ORIENTATION_VERTICAL)
+    gdk_window_move_resize (priv->frozen_window,
+                            0, 0, alloc.width, priv->frozen_size);
+  else
+    gdk_window_move_resize (priv->frozen_window,
+                            rtl ? alloc.width - priv->frozen_size : 0, 0,
+                            priv->frozen_size, alloc.height);
+  gdk_window_show (priv->frozen_window);
+}
+
+/* Recreate the frozen items from the model */
+static void
+load_frozen_widgets (SswSheetAxis *axis)
+{
+  PRIV_DECL (axis);
+  gint i;
+
+  if (!gtk_widget_get_realized (GTK_WIDGET (axis)))
+    return;
+
+  for (i = priv->frozen_widgets->len - 1; i >= 0; i--)
+    {
+      GtkWidget *w = g_ptr_array_index (priv->frozen_widgets, i);
+      gtk_widget_unparent (w);
+      g_object_unref (w);
+    }
+  g_ptr_array_set_size (priv->frozen_widgets, 0);
+
+  gint n = priv->model
+    ? MIN (priv->n_frozen, ssw_sheet_axis_get_size (axis)) : 0;
+
+  for (i = 0; i < n; ++i)
+    {
+      GtkWidget *w = get_widget (axis, i);
+      gtk_widget_set_parent_window (w, priv->frozen_window);
+      gtk_widget_set_parent (w, GTK_WIDGET (axis));
+      g_ptr_array_add (priv->frozen_widgets, w);
+    }
+
+  position_frozen (axis);
+}
+
 static void
 position_children (SswSheetAxis *axis)
 {
@@ -457,6 +582,8 @@ position_children (SswSheetAxis *axis)
 
   offset += size;
   EndFor;
+
+  position_frozen (axis);
 }
 
 static inline gint
@@ -852,6 +979,8 @@ items_changed_cb (GListModel *model,
   if (! gtk_widget_get_realized (GTK_WIDGET (axis)))
     return;
 
+  load_frozen_widgets (axis);
+
   /* If the change is out of our visible range anyway,
      then we don't care. */
   if (position > priv->model_to && bin_window_full (axis))
@@ -894,6 +1023,10 @@ __forall (GtkContainer *w,
   Foreach_Item
     (*callback) (item, callback_data);
   EndFor;
+
+  gint i;
+  for (i = 0; i < priv->frozen_widgets->len; ++i)
+    (*callback) (g_ptr_array_index (priv->frozen_widgets, i), callback_data);
 }
 
 /* }}} */
@@ -948,6 +1081,16 @@ __draw (GtkWidget *w, cairo_t *ct)
       gtk_container_propagate_draw (GTK_CONTAINER (axis), item, ct);
   EndFor;
 
+  if (priv->frozen_window
+      && gtk_cairo_should_draw_window (ct, priv->frozen_window))
+    {
+      gint i;
+      for (i = 0; i < priv->frozen_widgets->len; ++i)
+        gtk_container_propagate_draw (GTK_CONTAINER (axis),
+                                      g_ptr_array_index (priv->frozen_widgets, i),
+                                      ct);
+    }
+
   return GDK_EVENT_PROPAGATE;
 }
 
@@ -986,6 +1129,11 @@ __realize (GtkWidget *w)
     gtk_widget_set_parent_window (item, priv->bin_window);
   EndFor;
 
+  /* Created after the bin window, so that it lies above it */
+  priv->frozen_window =
+    gdk_window_new (window, &attributes, GDK_WA_X | GDK_WA_Y);
+  gtk_widget_register_window (w, priv->frozen_window);
+
   GdkDisplay *display = gtk_widget_get_display (w);
 
   if (priv->orientation == GTK_ORIENTATION_VERTICAL)
@@ -993,6 +1141,8 @@ __realize (GtkWidget *w)
   else
     priv->resize_cursor = gdk_cursor_new_for_display (display, GDK_SB_H_DOUBLE_ARROW);
   gtk_widget_set_realized (w, TRUE);
+
+  load_frozen_widgets (axis);
 }
 
 static void
@@ -1009,6 +1159,13 @@ __unrealize (GtkWidget *widget)
       priv->bin_window = NULL;
     }
 
+  if (priv->frozen_window != NULL)
+    {
+      gtk_widget_unregister_window (widget, priv->frozen_window);
+      gdk_window_destroy (priv->frozen_window);
+      priv->frozen_window = NULL;
+    }
+
   gtk_widget_set_realized (widget, FALSE);
 
   GTK_WIDGET_CLASS (ssw_sheet_axis_parent_class)->unrealize (widget);
@@ -1219,6 +1376,11 @@ __set_property (GObject *object,
           PRIV (object)->drag_handler_id = 0;
         }
       break;
+    case PROP_FROZEN:
+      PRIV (object)->n_frozen = g_value_get_int (value);
+      load_frozen_widgets (SSW_SHEET_AXIS (object));
+      ensure_visible_widgets (SSW_SHEET_AXIS (object), FALSE);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1240,6 +1402,9 @@ __get_property (GObject *object,
     case PROP_DRAGGABLE:
       g_value_set_boolean (value, PRIV (object)->drag_target_list != NULL);
       break;
+    case PROP_FROZEN:
+      g_value_set_int (value, PRIV (object)->n_frozen);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1274,12 +1439,14 @@ __finalize (GObject *obj)
   SswSheetAxis *axis = SSW_SHEET_AXIS (obj);
   PRIV_DECL (obj);
 
-  g_hash_table_destroy (priv->size_override);
+  g_object_unref (priv->geometry);
   g_ptr_array_free (priv->pool, TRUE);
   g_ptr_array_free (priv->widgets, TRUE);
+  g_ptr_array_free (priv->frozen_widgets, TRUE);
 
   if (axis->cell_limits)
     g_ptr_array_free (axis->cell_limits, TRUE);
+  g_ptr_array_free (axis->frozen_limits, TRUE);
 
   G_OBJECT_CLASS (ssw_sheet_axis_parent_class)->finalize (obj);
 }
@@ -1319,6 +1486,54 @@ ssw_sheet_axis_get_model (SswSheetAxis *axis)
   return PRIV (axis)->model;
 }
 
+void
+ssw_sheet_axis_set_index_map (SswSheetAxis *axis,
+                              ssw_sheet_axis_index_map map, gpointer data)
+{
+  PRIV_DECL (axis);
+
+  priv->index_map = map;
+  priv->index_map_data = data;
+
+  ssw_sheet_axis_reload (axis);
+}
+
+void
+ssw_sheet_axis_set_geometry (SswSheetAxis *axis, SswAxisGeometry *geometry)
+{
+  PRIV_DECL (axis);
+
+  g_return_if_fail (SSW_IS_AXIS_GEOMETRY (geometry));
+
+  if (geometry == priv->geometry)
+    return;
+
+  g_signal_handlers_disconnect_by_func (priv->geometry, on_size_changed, axis);
+  g_object_unref (priv->geometry);
+
+  priv->geometry = g_object_ref (geometry);
+  g_signal_connect_object (priv->geometry, "size-changed",
+                           G_CALLBACK (on_size_changed), axis, 0);
+
+  load_frozen_widgets (axis);
+  ensure_visible_widgets (axis, TRUE);
+}
+
+SswAxisGeometry *
+ssw_sheet_axis_get_geometry (SswSheetAxis *axis)
+{
+  return PRIV (axis)->geometry;
+}
+
+void
+ssw_sheet_axis_reload (SswSheetAxis *axis)
+{
+  PRIV_DECL (axis);
+
+  if (priv->model)
+    items_changed_cb (priv->model, priv->model_from, 0, 0, axis);
+}
+
 
 static void
 __direction_changed (GtkWidget *w, GtkTextDirection prev_dir)
@@ -1360,6 +1575,13 @@ ssw_sheet_axis_class_init (SswSheetAxisClass *class)
                           FALSE,
                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
 
+  GParamSpec *frozen_spec =
+    g_param_spec_int ("frozen",
+                      P_("Frozen"),
+                      P_("The number of items at the start of the axis which remain in place when it is scrolled"),
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE);
+
   object_class->set_property = __set_property;
   object_class->get_property = __get_property;
   object_class->dispose = __dispose;
@@ -1452,6 +1674,22 @@ ssw_sheet_axis_class_init (SswSheetAxisClass *class)
                   G_TYPE_INT,
                   G_TYPE_INT);
 
+  /* Emitted when the size of an item is overridden.  The arguments
+     are its position, and its sizes before and after.  A size of -1
+     is the natural size.  */
+  signals [SIZE_OVERRIDDEN] =
+    g_signal_new ("size-overridden",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  ssw_cclosure_marshal_VOID__INT_INT_INT,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_INT,
+                  G_TYPE_INT,
+                  G_TYPE_INT);
+
 
   g_object_class_install_property (object_class,
                                    PROP_ADJUSTMENT,
@@ -1461,6 +1699,10 @@ ssw_sheet_axis_class_init (SswSheetAxisClass *class)
                                    PROP_DRAGGABLE,
                                    draggable_spec);
 
+  g_object_class_install_property (object_class,
+                                   PROP_FROZEN,
+                                   frozen_spec);
+
   g_object_class_override_property (object_class, PROP_ORIENTATION,
                                     "orientation");
 }
@@ -1595,11 +1837,19 @@ ssw_sheet_axis_init (SswSheetAxis *axis)
   priv->bin_start_diff = 0;
   priv->dispose_has_run = FALSE;
 
-  priv->size_override = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->geometry = ssw_axis_geometry_new ();
+  g_signal_connect_object (priv->geometry, "size-changed",
+                           G_CALLBACK (on_size_changed), axis, 0);
 
   gtk_style_context_add_class (context, "list");
   axis->cell_limits = NULL;
 
+  priv->n_frozen = 0;
+  priv->frozen_widgets = g_ptr_array_new ();
+  priv->frozen_window = NULL;
+  priv->frozen_size = 0;
+  axis->frozen_limits = g_ptr_array_new_with_free_func (free_limit);
+
   priv->resize_gest = gtk_gesture_drag_new (GTK_WIDGET (axis));
   priv->button_gest = gtk_gesture_multi_press_new (GTK_WIDGET (axis));
   priv->drag_gest = gtk_gesture_long_press_new (GTK_WIDGET (axis));
@@ -1636,6 +1886,8 @@ ssw_sheet_axis_init (SswSheetAxis *axis)
 
   priv->drag_handler_id = 0;
   priv->drag_target_list = NULL;
+  priv->index_map = NULL;
+  priv->index_map_data = NULL;
   g_signal_connect (axis, "drag-drop", G_CALLBACK (on_drag_drop), NULL);
 }
 
@@ -1645,7 +1897,8 @@ static void ssw_sheet_axis_jump_end_with_offset (SswSheetAxis *axis, gint wheret
 
 
 /* Request a specific size for item POS.  Overriding the natural
-   size for the item. */
+   size for the item.  If SIZE is negative, the natural size is
+   restored. */
 void
 ssw_sheet_axis_override_size (SswSheetAxis *axis, gint pos, gint size)
 {
@@ -1655,24 +1908,53 @@ ssw_sheet_axis_override_size (SswSheetAxis *axis, gint pos, gint size)
   GType t = G_OBJECT_TYPE (model);
   gboolean done_resize = FALSE;
   guint sig = g_signal_lookup ("resize-item", t);
-  if (sig != 0)
+
+  gint old_size = ssw_axis_geometry_get_size (priv->geometry, pos);
+  if (old_size < 0 && sig != 0)
+    ssw_sheet_axis_find_boundary (axis, pos, NULL, &old_size);
+
+  if (sig != 0 && size >= 0)
     g_signal_emit (model, sig, 0, pos, size, &done_resize);
 
   if (done_resize)
-    return;
+    {
+      g_signal_emit (axis, signals [SIZE_OVERRIDDEN], 0, pos, old_size, size);
+      return;
+    }
 
-  g_hash_table_insert (priv->size_override,
-                       GINT_TO_POINTER (pos),
-                       GINT_TO_POINTER (size));
+  g_signal_emit (axis, signals [SIZE_OVERRIDDEN], 0, pos, old_size, size);
+
+  /* Every axis which shares the geometry, this one included, is laid
+     out again by on_size_changed */
+  ssw_axis_geometry_set_size (priv->geometry, pos, size);
+}
+
+/* Lay out the items again, when the size of the item at POS has been
+   changed through this axis or through any other which shares its
+   geometry */
+static void
+on_size_changed (SswAxisGeometry *geometry, gint pos, gpointer data)
+{
+  SswSheetAxis *axis = SSW_SHEET_AXIS (data);
+  PRIV_DECL (axis);
+
+  /* An axis which is not shown is laid out when it is next mapped */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (axis)))
+    {
+      load_frozen_widgets (axis);
+      return;
+    }
 
   guint width = gtk_widget_get_allocated_width (GTK_WIDGET (axis));
 
+  /* The first item which scrolls is kept in place */
   gint loc;
   gint start_cell =
     ssw_sheet_axis_find_cell (axis,
-                              ssw_sheet_axis_rtl (axis) ? width : 0,
+                              ssw_sheet_axis_rtl (axis) ? width : priv->frozen_size,
                               &loc, NULL);
 
+  load_frozen_widgets (axis);
   ensure_visible_widgets (axis, TRUE);
 
   if (ssw_sheet_axis_rtl (axis))
@@ -1693,10 +1975,24 @@ ssw_sheet_axis_find_cell (SswSheetAxis *axis,  gdouble pos, gint *location, gint
   gint x = ssw_sheet_axis_rtl (axis) ? axis->first_cell - 1: axis->last_cell;
   gint prev = G_MAXINT;
 
+  /* The frozen items lie above any others */
+  gint i;
+  for (i = 0; i < axis->frozen_limits->len; ++i)
+    {
+      const SswGeometry *geom = g_ptr_array_index (axis->frozen_limits, i);
+      if (pos >= geom->position && pos < geom->position + geom->size)
+        {
+          if (location)
+            *location = geom->position;
+          if (size)
+            *size = geom->size;
+          return i;
+        }
+    }
+
   if (axis->cell_limits->len == 0)
     return -1;
 
-  int i;
   const int step = ssw_sheet_axis_rtl (axis) ? -1 : +1;
   for (i = axis->cell_limits->len - 1; i >= 0; --i)
     {
@@ -1735,6 +2031,18 @@ gint
 ssw_sheet_axis_find_boundary (SswSheetAxis *axis,  gint pos,
                               gint *location, gint *size)
 {
+  if (pos >= 0 && pos < axis->frozen_limits->len)
+    {
+      const SswGeometry *geom = g_ptr_array_index (axis->frozen_limits, pos);
+
+      if (location)
+        *location = geom->position;
+      if (size)
+        *size = geom->size;
+
+      return 0;
+    }
+
   if (pos >= axis->last_cell)
     return +1;
 
@@ -1802,13 +2110,22 @@ ssw_sheet_axis_get_extent (SswSheetAxis *axis)
 }
 
 
-/* Return the number of the first cell which is *fully* visible */
+/* Return the number of the first cell which scrolls and which is
+   *fully* visible, beyond the frozen cells */
 gint
 ssw_sheet_axis_get_first (SswSheetAxis *axis)
 {
   PRIV_DECL (axis);
   gint widget_size = priv->get_allocated_p_size (GTK_WIDGET (axis));
-  const gint extremity = ssw_sheet_axis_rtl (axis) ? widget_size : 0;
+  gint frozen_start, frozen_size;
+  ssw_sheet_axis_get_frozen_region (axis, &frozen_start, &frozen_size);
+
+  /* Right to left, the frozen cells begin at FROZEN_START, so the
+     cells which scroll end just before it */
+  gint extremity = frozen_size;
+  if (ssw_sheet_axis_rtl (axis))
+    extremity = (frozen_size > 0) ? frozen_start - 1 : widget_size;
+
   gint position, size;
   gint cell = ssw_sheet_axis_find_cell (axis, extremity, &position, &size);
 
@@ -1817,12 +2134,12 @@ ssw_sheet_axis_get_first (SswSheetAxis *axis)
 
   if (ssw_sheet_axis_rtl (axis))
     {
-      if (position + size > widget_size)
+      if (position + size > frozen_start)
         cell++;
     }
   else
     {
-      if (position < 0)
+      if (position < frozen_size)
         cell++;
     }
 
@@ -2015,11 +2332,17 @@ ssw_sheet_axis_jump_center (SswSheetAxis *axis, gint whereto)
 }
 
 
-/* Scroll the axis such that WHERETO is at the start */
+/* Scroll the axis such that WHERETO is at the start, just beyond any
+   frozen items */
 void
 ssw_sheet_axis_jump_start (SswSheetAxis *axis, gint whereto)
 {
-  ssw_sheet_axis_jump_start_with_offset (axis, whereto, 0);
+  PRIV_DECL (axis);
+
+  ssw_sheet_axis_jump_start_with_offset (axis, whereto,
+                                         ssw_sheet_axis_rtl (axis)
+                                         ? -priv->frozen_size
+                                         : priv->frozen_size);
 }
 
 
@@ -2029,3 +2352,20 @@ ssw_sheet_axis_jump_end (SswSheetAxis *axis, gint whereto)
 {
   ssw_sheet_axis_jump_end_with_offset (axis, whereto, 0);
 }
+
+gint
+ssw_sheet_axis_get_n_frozen (SswSheetAxis *axis)
+{
+  return axis->frozen_limits->len;
+}
+
+void
+ssw_sheet_axis_get_frozen_region (SswSheetAxis *axis, gint *start, gint *size)
+{
+  PRIV_DECL (axis);
+
+  *size = priv->frozen_size;
+  *start = ssw_sheet_axis_rtl (axis)
+    ? priv->get_allocated_p_size (GTK_WIDGET (axis)) - priv->frozen_size
+    : 0;
+}
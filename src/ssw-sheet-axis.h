@@ -20,6 +20,7 @@
 #define _SSW_SHEET_AXIS_H
 
 #include <gtk/gtk.h>
+#include "ssw-axis-geometry.h"
 
 typedef struct
 {
@@ -34,6 +35,9 @@ struct _SswSheetAxis
   gint last_cell;
   gint first_cell;
   GPtrArray *cell_limits;
+
+  /* The geometry of the frozen items, which are items 0 .. len - 1 */
+  GPtrArray *frozen_limits;
 };
 
 struct _SswSheetAxisClass
@@ -51,6 +55,22 @@ void ssw_sheet_axis_set_model (SswSheetAxis *box, GListModel *model);
 
 GListModel *ssw_sheet_axis_get_model (SswSheetAxis *box);
 
+/* A function returning the position in the model of the item which
+   is to be displayed at position INDEX */
+typedef guint (*ssw_sheet_axis_index_map) (guint index, gpointer data);
+
+void ssw_sheet_axis_set_index_map (SswSheetAxis *axis,
+                                   ssw_sheet_axis_index_map map, gpointer data);
+
+/* Use GEOMETRY for the sizes of the items, sharing them with any
+   other axis which uses it */
+void ssw_sheet_axis_set_geometry (SswSheetAxis *axis,
+                                  SswAxisGeometry *geometry);
+SswAxisGeometry *ssw_sheet_axis_get_geometry (SswSheetAxis *axis);
+
+/* Recreate the visible items from the model */
+void ssw_sheet_axis_reload (SswSheetAxis *axis);
+
 gint ssw_sheet_axis_find_cell (SswSheetAxis *axis,  gdouble pos, gint *offset, gint *size);
 
 gint ssw_sheet_axis_find_boundary (SswSheetAxis *axis,  gint pos, gint *offset, gint *size);
@@ -69,6 +89,13 @@ void ssw_sheet_axis_jump_center (SswSheetAxis *axis, gint whereto);
 gint ssw_sheet_axis_get_last (SswSheetAxis *axis);
 gint ssw_sheet_axis_get_first (SswSheetAxis *axis);
 
+/* The number of items which are frozen at the start of the axis, and
+   the position and size of the region which they occupy.  The other
+   items scroll beneath it.  */
+gint ssw_sheet_axis_get_n_frozen (SswSheetAxis *axis);
+void ssw_sheet_axis_get_frozen_region (SswSheetAxis *axis,
+                                       gint *start, gint *size);
+
 
 void ssw_sheet_axis_info (SswSheetAxis *axis);
 
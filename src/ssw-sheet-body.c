@@ -22,6 +22,14 @@
 #include "ssw-sheet.h"
 #include "ssw-sheet-body.h"
 #include "ssw-constraint.h"
+#include "ssw-data-model.h"
+#include "ssw-permutation.h"
+#include "ssw-selection.h"
+#include "ssw-occupancy.h"
+#include "ssw-find.h"
+#include "ssw-render-cache.h"
+#include "ssw-parallel.h"
+#include "ssw-serializer.h"
 #include "ssw-marshaller.h"
 
 #define P_(X) (X)
@@ -40,9 +48,6 @@ struct _SswSheetBodyPrivate
   GtkWidget *editor;
   GtkWidget *active_cell_holder;
 
-  /* A string of the form "%d:%d" describing the current cell */
-  gchar path[512];
-
   gboolean show_gridlines;
   gboolean editable;
 
@@ -73,6 +78,16 @@ struct _SswSheetBodyPrivate
 
   ssw_sheet_forward_conversion_func cf;
   ssw_sheet_reverse_conversion_func revf;
+
+  /* The large copies being serialized from this body */
+  GSList *clip_tasks;
+
+  /* The cell to which the keyboard has moved the active cell, but
+     which is not made active until the next frame.  MOVE_TICK is the
+     id of the tick callback which will do so, or zero if none.  */
+  guint move_tick;
+  gint pending_col;
+  gint pending_row;
 };
 
 typedef struct _SswSheetBodyPrivate SswSheetBodyPrivate;
@@ -87,6 +102,171 @@ G_DEFINE_TYPE_WITH_CODE (SswSheetBody, ssw_sheet_body,
 
 static void start_editing (SswSheetBody *body, GdkEvent *e);
 
+/* The row of the data model which is displayed at ROW */
+static gint
+model_row (SswSheetBody *body, gint row)
+{
+  PRIV_DECL (body);
+  return priv->sheet ? ssw_sheet_get_model_row (priv->sheet, row) : row;
+}
+
+/* The column of the data model which is displayed at COL */
+static gint
+model_col (SswSheetBody *body, gint col)
+{
+  PRIV_DECL (body);
+  return priv->sheet ? ssw_sheet_get_model_column (priv->sheet, col) : col;
+}
+
+/* TRUE if the visible columns are in the same order as the model's */
+static gboolean
+columns_in_model_order (SswSheetBody *body)
+{
+  PRIV_DECL (body);
+  return priv->sheet == NULL ||
+    ssw_permutation_is_identity (priv->sheet->column_order);
+}
+
+/* N consecutive items of an axis, starting at FIRST.  The geometry of
+   item FIRST + I is element OFFSET + I of LIMITS.  */
+struct span
+{
+  gint first;
+  gint n;
+  const GPtrArray *limits;
+  gint offset;
+};
+
+static inline const SswGeometry *
+span_geometry (const struct span *s, gint i)
+{
+  return g_ptr_array_index (s->limits, s->offset + i);
+}
+
+/* The visible cells are drawn in up to four blocks: those which
+   scroll, those in the frozen rows, those in the frozen columns, and
+   those in both.  Each block is clipped to its own part of the body,
+   so that the cells which scroll beneath the frozen ones are hidden.
+   Without frozen rows or columns, there is only the first.  */
+#define N_BLOCKS 4
+
+struct block
+{
+  struct span rows;
+  struct span cols;
+  GdkRectangle clip;
+};
+
+/* Store in SCROLLED the visible items of AXIS which scroll, other than
+   those beneath the frozen items, and in FROZEN the frozen items.
+   Store in START and SIZE the parts of the axis, of length EXTENT, in
+   which each is drawn.  */
+static void
+get_spans (SswSheetAxis *axis, gint extent,
+           struct span *scrolled, struct span *frozen,
+           gint start[2], gint size[2])
+{
+  gint frozen_start, frozen_size;
+  ssw_sheet_axis_get_frozen_region (axis, &frozen_start, &frozen_size);
+
+  frozen->first = 0;
+  frozen->n = ssw_sheet_axis_get_n_frozen (axis);
+  frozen->limits = axis->frozen_limits;
+  frozen->offset = 0;
+
+  const gint first_visible = axis->last_cell - axis->cell_limits->len;
+  scrolled->first = MAX (first_visible, frozen->n);
+  scrolled->n = MAX (0, axis->last_cell - scrolled->first);
+  scrolled->limits = axis->cell_limits;
+  scrolled->offset = scrolled->first - first_visible;
+
+  /* The frozen items lie at the start of the axis, which is its end if
+     it runs from right to left */
+  start[1] = frozen_start;
+  size[1] = frozen_size;
+  if (frozen_start == 0)
+    {
+      start[0] = frozen_size;
+      size[0] = MAX (0, extent - frozen_size);
+    }
+  else
+    {
+      start[0] = 0;
+      size[0] = MAX (0, frozen_start);
+    }
+}
+
+/* Fill BLOCKS with those blocks of BODY which have any cells, in the
+   order in which they are to be drawn, and return their number */
+static gint
+get_blocks (SswSheetBody *body, struct block *blocks)
+{
+  PRIV_DECL (body);
+  struct span rows[2], cols[2];
+  gint y[2], height[2], x[2], width[2];
+  gint n = 0;
+  gint r, c;
+
+  get_spans (priv->vaxis, gtk_widget_get_allocated_height (GTK_WIDGET (body)),
+             &rows[0], &rows[1], y, height);
+  get_spans (priv->haxis, gtk_widget_get_allocated_width (GTK_WIDGET (body)),
+             &cols[0], &cols[1], x, width);
+
+  for (r = 0; r < 2; ++r)
+    for (c = 0; c < 2; ++c)
+      {
+        if (rows[r].n == 0 || cols[c].n == 0)
+          continue;
+
+        blocks[n].rows = rows[r];
+        blocks[n].cols = cols[c];
+        blocks[n].clip.x = x[c];
+        blocks[n].clip.y = y[r];
+        blocks[n].clip.width = width[c];
+        blocks[n].clip.height = height[r];
+        n++;
+      }
+
+  return n;
+}
+
+static inline void
+clip_to_block (cairo_t *cr, const struct block *b)
+{
+  gdk_cairo_rectangle (cr, &b->clip);
+  cairo_clip (cr);
+}
+
+/* TRUE if the cell COL, ROW lies at least partly beneath the frozen
+   rows or columns, over which its editor must not be shown */
+static gboolean
+cell_obscured (SswSheetBody *body, gint col, gint row)
+{
+  PRIV_DECL (body);
+  SswSheetAxis *axes[2] = {priv->haxis, priv->vaxis};
+  gint items[2] = {col, row};
+  gint i;
+
+  for (i = 0; i < 2; ++i)
+    {
+      gint start, size, location, extent;
+
+      if (items[i] < ssw_sheet_axis_get_n_frozen (axes[i]))
+        continue;
+
+      ssw_sheet_axis_get_frozen_region (axes[i], &start, &size);
+      if (size == 0
+          || 0 != ssw_sheet_axis_find_boundary (axes[i], items[i],
+                                                &location, &extent))
+        continue;
+
+      if (location < start + size && location + extent > start)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 static void
 limit_selection (SswSheetBody *body)
 {
@@ -116,15 +296,16 @@ get_active_cell (SswSheetBody *body, gint *col, gint *row)
 {
   PRIV_DECL (body);
 
-  SswSheetBody *active_body = NULL;
+  if (priv->sheet == NULL)
+    return FALSE;
 
-  sscanf (priv->path, "r%dc%ds%p", row, col, &active_body);
+  const SswCursor *cursor = &priv->sheet->cursor;
 
-  if (active_body == NULL) /* There is no active cell! */
+  if (cursor->body != GTK_WIDGET (body)) /* This body is not active */
     return FALSE;
 
-  if (active_body != body) /* This body is not active */
-    return FALSE;
+  *col = cursor->col;
+  *row = cursor->row;
 
   if (*col < 0 || *row < 0)
     return FALSE;
@@ -132,6 +313,51 @@ get_active_cell (SswSheetBody *body, gint *col, gint *row)
   return TRUE;
 }
 
+/* Set the cursor of the sheet, and announce any change */
+static void
+move_cursor (SswSheetBody *body, gint col, gint row, gboolean editing)
+{
+  PRIV_DECL (body);
+
+  SswCursor *cursor = &priv->sheet->cursor;
+
+  if (cursor->col == col && cursor->row == row
+      && cursor->body == GTK_WIDGET (body) && cursor->editing == editing)
+    return;
+
+  cursor->col = col;
+  cursor->row = row;
+  cursor->body = GTK_WIDGET (body);
+  cursor->editing = editing;
+
+  g_signal_emit_by_name (priv->sheet, "cursor-changed", cursor);
+}
+
+/* Set the editing state of the cursor, if it lies in BODY */
+static void
+set_cursor_editing (SswSheetBody *body, gboolean editing)
+{
+  PRIV_DECL (body);
+
+  const SswCursor *cursor = &priv->sheet->cursor;
+
+  if (cursor->body == GTK_WIDGET (body))
+    move_cursor (body, cursor->col, cursor->row, editing);
+}
+
+/* Write to PATH the string which identifies the active cell of BODY
+   to a GtkCellRenderer.  It is parsed by text_editing_started.  */
+static void
+format_path (SswSheetBody *body, gchar *path, gsize len)
+{
+  gint row = -1, col = -1;
+  get_active_cell (body, &col, &row);
+
+  snprintf (path, len, "r%dc%ds%p", row, col, body);
+}
+
+static void sync_selection_set (SswSheetBody *body);
+
 static inline
 void set_active_cell (SswSheetBody *body, gint col, gint row)
 {
@@ -149,7 +375,9 @@ void set_active_cell (SswSheetBody *body, gint col, gint row)
   if (old_start_x < col)
     priv->selection->end_x = col;
 
-  snprintf (priv->path, 512, "r%dc%ds%p", row, col, body);
+  sync_selection_set (body);
+
+  move_cursor (body, col, row, priv->sheet->cursor.editing);
 }
 
 static void
@@ -174,7 +402,8 @@ scroll_vertically (SswSheetBody *body)
       gtk_layout_move (GTK_LAYOUT (body), priv->active_cell_holder,
                        hlocation, vlocation + 1);
 
-      gtk_widget_set_visible (priv->active_cell_holder, (visible == 0));
+      gtk_widget_set_visible (priv->active_cell_holder,
+                              (visible == 0) && !cell_obscured (body, col, row));
     }
 
   gtk_widget_queue_draw (GTK_WIDGET (body));
@@ -199,7 +428,8 @@ scroll_horizontally (SswSheetBody *body)
       gtk_container_child_get (GTK_CONTAINER (body), priv->active_cell_holder, "y", &vlocation, NULL);
 
       gtk_layout_move (GTK_LAYOUT (body), priv->active_cell_holder, hlocation + 1, vlocation);
-      gtk_widget_set_visible (priv->active_cell_holder, visible == 0);
+      gtk_widget_set_visible (priv->active_cell_holder,
+                              visible == 0 && !cell_obscured (body, col, row));
     }
 
   gtk_widget_queue_draw (GTK_WIDGET (body));
@@ -234,12 +464,81 @@ normalise_selection (const SswRange *in, SswRange *out)
     }
 }
 
+/* Make the last of the sheet's selected ranges agree with the range
+   being defined.  This is done wherever the range is changed, so that
+   drawing and copying need only read the set.  */
+static void
+sync_selection_set (SswSheetBody *body)
+{
+  PRIV_DECL (body);
+
+  if (priv->sheet == NULL)
+    return;
+
+  SswSelection *set = priv->sheet->selection_set;
+  gint n = ssw_selection_get_n_ranges (set);
+
+  if (priv->selection->start_x < 0 || priv->selection->start_y < 0)
+    ssw_selection_clear (set);
+  else
+    ssw_selection_set_range (set, MAX (n - 1, 0), priv->selection);
+}
+
+/* Prepare to define a new range of the selection.  If ADD, the ranges
+   selected hitherto are kept, otherwise they are discarded.  */
+static void
+begin_range (SswSheetBody *body, gboolean add)
+{
+  PRIV_DECL (body);
+
+  if (priv->sheet == NULL)
+    return;
+
+  SswSelection *set = priv->sheet->selection_set;
+
+  if (!add)
+    ssw_selection_clear (set);
+  else if (priv->selection->start_x >= 0 && priv->selection->start_y >= 0)
+    {
+      /* The current range is already the last of the set, so keep it
+         as it is, and add one which will become the new range once it
+         is defined.  */
+      if (ssw_selection_get_n_ranges (set) == 0)
+        ssw_selection_add (set, priv->selection);
+      ssw_selection_add (set, priv->selection);
+    }
+}
+
+struct paint_selection
+{
+  SswSheetBodyPrivate *priv;
+  GtkStyleContext *sc;
+  cairo_t *cr;
+};
+
 static void
-draw_selection (SswSheetBody *body, cairo_t *cr)
+paint_selected_range (const SswRange *r, gpointer data)
+{
+  struct paint_selection *ps = data;
+  gint xpos_start, ypos_start, xpos_end, ypos_end, xextent, yextent;
+
+  /* R lies within the visible cells, so all its boundaries are known */
+  ssw_sheet_axis_find_boundary (ps->priv->haxis, r->start_x, &xpos_start, NULL);
+  ssw_sheet_axis_find_boundary (ps->priv->vaxis, r->start_y, &ypos_start, NULL);
+  ssw_sheet_axis_find_boundary (ps->priv->haxis, r->end_x, &xpos_end, &xextent);
+  ssw_sheet_axis_find_boundary (ps->priv->vaxis, r->end_y, &ypos_end, &yextent);
+
+  gtk_render_background (ps->sc, ps->cr,
+                         xpos_start, ypos_start,
+                         xpos_end - xpos_start + xextent,
+                         ypos_end - ypos_start + yextent);
+}
+
+static void
+draw_selection (SswSheetBody *body, cairo_t *cr,
+                const struct block *blocks, gint n_blocks)
 {
   GtkWidget *w = GTK_WIDGET (body);
-  guint width = gtk_widget_get_allocated_width (w);
-  guint height = gtk_widget_get_allocated_height (w);
   PRIV_DECL (body);
 
   GdkRGBA *color;
@@ -260,47 +559,32 @@ draw_selection (SswSheetBody *body, cairo_t *cr)
   gtk_style_context_add_provider (sc, GTK_STYLE_PROVIDER (cp),
                                   GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
 
-  /* Draw the selection */
-  if ((priv->selection->start_x != priv->selection->end_x)
-      ||
-      (priv->selection->start_y != priv->selection->end_y))
+  /* Paint the visible part of the union of the selected ranges.  A
+     lone range of one cell is indicated by the active cell alone.  */
+  const SswSelection *set = priv->sheet ? priv->sheet->selection_set : NULL;
+  if (set && !ssw_selection_is_empty (set)
+      && (ssw_selection_get_n_ranges (set) > 1
+          || priv->selection->start_x != priv->selection->end_x
+          || priv->selection->start_y != priv->selection->end_y))
     {
-      SswRange mySelect;
-      normalise_selection (priv->selection, &mySelect);
-      gint xpos_start = 0;
-      gint ypos_start = 0;
-      if (0 < ssw_sheet_axis_find_boundary (priv->haxis, mySelect.start_x,
-                                            &xpos_start,  NULL))
-        goto done;
-
-      if (0 < ssw_sheet_axis_find_boundary (priv->vaxis, mySelect.start_y,
-                                            &ypos_start,  NULL))
-        goto done;
-
-      gint xpos_end, ypos_end, yextent, xextent;
-      gint xrel = ssw_sheet_axis_find_boundary (priv->haxis,
-                                                mySelect.end_x, &xpos_end,
-                                                &xextent);
-      if (xrel < 0)
-        goto done;
+      struct paint_selection ps = {priv, sc, cr};
+      gint b;
 
-      gint xsize = (xrel == 0) ? xpos_end - xpos_start + xextent : width;
-
-
-      gint yrel = ssw_sheet_axis_find_boundary (priv->vaxis,
-                                                mySelect.end_y, &ypos_end,
-                                                &yextent);
-      if (yrel < 0)
-        goto done;
-
-      gint ysize = (yrel == 0) ? ypos_end - ypos_start + yextent : height;
-
-      gtk_render_background (sc, cr,
-                             xpos_start, ypos_start,
-                             xsize, ysize);
+      for (b = 0; b < n_blocks; ++b)
+        {
+          SswRange visible;
+          visible.start_x = blocks[b].cols.first;
+          visible.end_x = blocks[b].cols.first + blocks[b].cols.n - 1;
+          visible.start_y = blocks[b].rows.first;
+          visible.end_y = blocks[b].rows.first + blocks[b].rows.n - 1;
+
+          cairo_save (cr);
+          clip_to_block (cr, &blocks[b]);
+          ssw_selection_foreach (set, &visible, paint_selected_range, &ps);
+          cairo_restore (cr);
+        }
     }
 
- done:
   gtk_style_context_remove_provider (sc, GTK_STYLE_PROVIDER (cp));
   g_free (css);
   g_object_unref (cp);
@@ -385,56 +669,109 @@ static const gchar *focused_border = "* {\n"
   " border-style: solid;\n"
   "}";
 
-static gboolean
-__draw (GtkWidget *widget, cairo_t *cr)
+/* Draw a placeholder in RECT, for a cell whose datum is not yet available */
+static void
+draw_pending_cell (cairo_t *cr, const GdkRectangle *rect)
+{
+  cairo_save (cr);
+  cairo_set_source_rgba (cr, 0.5, 0.5, 0.5, 0.15);
+  cairo_rectangle (cr, rect->x + 2, rect->y + 2,
+                   rect->width - 4, rect->height - 4);
+  cairo_fill (cr);
+  cairo_restore (cr);
+}
+
+/* Highlight the cells of block B which match the sheet's search */
+static void
+draw_block_matches (SswSheetBody *body, cairo_t *cr, const struct block *b)
 {
-  SswSheetBody *body = SSW_SHEET_BODY (widget);
   PRIV_DECL (body);
 
-  if (!priv->haxis || !priv->vaxis)
-    return TRUE;
+  const gint first_col = b->cols.first;
+  const gint last_col = b->cols.first + b->cols.n - 1;
+  const gint last_row = b->rows.first + b->rows.n - 1;
+  gint n = ssw_finder_get_n_matches (priv->sheet->finder);
+  gint i;
 
-  gint active_row = -1, active_col = -1;
-  get_active_cell (body, &active_col, &active_row);
+  cairo_save (cr);
+  clip_to_block (cr, b);
+  cairo_set_source_rgba (cr, 1.0, 0.8, 0.0, 0.35);
 
-  guint width = gtk_widget_get_allocated_width (widget);
-  guint height = gtk_widget_get_allocated_height (widget);
+  for (i = ssw_finder_lookup (priv->sheet->finder, first_col,
+                              b->rows.first);
+       i < n; ++i)
+    {
+      gint col, row;
+      gint xpos, xsize, ypos, ysize;
 
-  GtkStyleContext *sc = gtk_widget_get_style_context (widget);
+      ssw_finder_get_match (priv->sheet->finder, i, &col, &row);
+      if (row > last_row)
+        break;
 
-  GtkCssProvider *cp = gtk_css_provider_new ();
+      if (col < first_col || col > last_col)
+        continue;
 
-  GtkBorder border;
-  if (priv->editable)
-    {
-      gint yy = ssw_sheet_axis_find_boundary (priv->vaxis, active_row, NULL, NULL);
-      gint xx = ssw_sheet_axis_find_boundary (priv->haxis, active_col, NULL, NULL);
+      if (0 != ssw_sheet_axis_find_boundary (priv->haxis, col, &xpos, &xsize)
+          || 0 != ssw_sheet_axis_find_boundary (priv->vaxis, row, &ypos, &ysize))
+        continue;
 
-      if (yy == 0 && xx == 0 && priv->editor == NULL)
-        start_editing (body, NULL);
+      cairo_rectangle (cr, xpos, ypos, xsize, ysize);
+    }
 
-      if ((gtk_widget_is_focus (widget) ||
-           (priv->editor && gtk_widget_is_focus (priv->editor))))
-        gtk_css_provider_load_from_data (cp, focused_border, strlen (focused_border), 0);
-      else
-        gtk_css_provider_load_from_data (cp, unfocused_border,
-                                         strlen (unfocused_border), 0);
+  cairo_fill (cr);
+  cairo_restore (cr);
+}
 
-      gtk_style_context_add_provider (sc, GTK_STYLE_PROVIDER (cp),
-                                      GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+/* Highlight the visible cells which match the sheet's search */
+static void
+draw_matches (SswSheetBody *body, cairo_t *cr,
+              const struct block *blocks, gint n_blocks)
+{
+  PRIV_DECL (body);
+  gint b;
 
-      gtk_style_context_get_border (sc,
-                                    gtk_widget_get_state_flags (widget),
-                                    &border);
-    }
+  if (priv->sheet == NULL
+      || ssw_finder_get_n_matches (priv->sheet->finder) == 0)
+    return;
+
+  for (b = 0; b < n_blocks; ++b)
+    draw_block_matches (body, cr, &blocks[b]);
+}
 
-  int row = priv->vaxis->last_cell;
+/* Draw the cells of block B, and their gridlines and the frame of the
+   active cell.  BORDER is the border of the frame.  */
+static void
+draw_block_cells (SswSheetBody *body, cairo_t *cr, GtkStyleContext *sc,
+                  const GtkBorder *border, const struct block *b,
+                  gint active_col, gint active_row)
+{
+  GtkWidget *widget = GTK_WIDGET (body);
+  PRIV_DECL (body);
+
+  guint width = gtk_widget_get_allocated_width (widget);
+  guint height = gtk_widget_get_allocated_height (widget);
+
+  /* The columns of the block, and whether the block has anything at
+     all to display.  Blocks can be tested only whilst they are
+     contiguous in the model.  */
+  const gint n_visible_cols = b->cols.n;
+  const gint first_visible_col = b->cols.first;
+  const gboolean model_order = columns_in_model_order (body);
+  const gboolean all_empty = priv->data_model && model_order &&
+    (priv->sheet == NULL || ssw_permutation_is_identity (priv->sheet->row_order)) &&
+    ssw_data_model_is_block_empty (priv->data_model,
+                                   first_visible_col,
+                                   b->rows.first,
+                                   n_visible_cols,
+                                   b->rows.n);
+
+  int row = b->rows.first + b->rows.n;
   gint y;
-  for (y = priv->vaxis->cell_limits->len - 1;
+  for (y = b->rows.n - 1;
        y >= 0;
        --y)
     {
-      const SswGeometry *vgeom = g_ptr_array_index (priv->vaxis->cell_limits, y);
+      const SswGeometry *vgeom = span_geometry (&b->rows, y);
 
 
       if (priv->show_gridlines)
@@ -447,16 +784,22 @@ __draw (GtkWidget *widget, cairo_t *cr)
         }
 
       --row;
+      const gint mrow = model_row (body, row);
       GtkTreeIter iter;
       if (priv->data_model)
-        gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row);
-      int col = priv->haxis->last_cell;
+        gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, mrow);
+
+      const gboolean row_empty = all_empty ||
+        (priv->data_model && model_order &&
+         ssw_data_model_is_block_empty (priv->data_model, first_visible_col,
+                                        mrow, n_visible_cols, 1));
+      int col = b->cols.first + b->cols.n;
       gint x;
-      for (x = priv->haxis->cell_limits->len - 1;
+      for (x = b->cols.n - 1;
            x >= 0;
            --x)
         {
-          const SswGeometry *hgeom = g_ptr_array_index (priv->haxis->cell_limits, x);
+          const SswGeometry *hgeom = span_geometry (&b->cols, x);
 
           GdkRectangle rect;
           rect.x = hgeom->position;
@@ -470,44 +813,48 @@ __draw (GtkWidget *widget, cairo_t *cr)
             {
               /* Draw frame */
               gtk_render_frame (sc, cr,
-                                rect.x - border.left,
-                                rect.y - border.top,
-                                rect.width + border.left + border.right + 1,
-                                rect.height + border.top + border.bottom + 1);
+                                rect.x - border->left,
+                                rect.y - border->top,
+                                rect.width + border->left + border->right + 1,
+                                rect.height + border->top + border->bottom + 1);
             }
-          if (priv->data_model
+          if (priv->data_model && !row_empty
               && row < gtk_tree_model_iter_n_children (priv->data_model, NULL)
               && col < gtk_tree_model_get_n_columns (priv->data_model))
             {
-              GtkCellRenderer *renderer = choose_renderer (body, col, row);
+              GtkCellRenderer *renderer;
+              char *cell_text;
+              gboolean pending = !resolve_cell (body, model_col (body, col),
+                                                mrow, &iter,
+                                                &renderer, &cell_text);
 
               if (GTK_IS_CELL_RENDERER_TEXT (renderer))
                 {
-                  char *cell_text = NULL;
-
-                  if (col != active_col || row != active_row ||
-                      ! priv->editable ||
-                      (priv->sheet->selected_body != GTK_WIDGET (body)))
+                  if (col == active_col && row == active_row &&
+                      priv->editable &&
+                      (priv->sheet->selected_body == GTK_WIDGET (body)) &&
+                      !cell_obscured (body, col, row))
                     {
                       /* Don't render the active cell.
                          It is already rendered by the cell_editable widget
                          and rendering twice looks unaesthetic */
-                      GValue value = G_VALUE_INIT;
-                      gtk_tree_model_get_value (priv->data_model, &iter, col, &value);
-                      cell_text = priv->cf (priv->sheet, priv->data_model, col, row, &value);
-                      g_value_unset (&value);
+                      g_free (cell_text);
+                      cell_text = NULL;
+                      pending = FALSE;
                     }
 
                   g_object_set (renderer,
                                 "text", cell_text,
                                 NULL);
-
-                  g_free (cell_text);
                 }
 
+              g_free (cell_text);
 
-              gtk_cell_renderer_render (renderer, cr, widget,
-                                        &rect, &rect, 0);
+              if (pending)
+                draw_pending_cell (cr, &rect);
+              else
+                gtk_cell_renderer_render (renderer, cr, widget,
+                                          &rect, &rect, 0);
             }
 
           if (priv->show_gridlines)
@@ -519,6 +866,65 @@ __draw (GtkWidget *widget, cairo_t *cr)
             }
         }
     }
+}
+
+static gboolean
+__draw (GtkWidget *widget, cairo_t *cr)
+{
+  SswSheetBody *body = SSW_SHEET_BODY (widget);
+  PRIV_DECL (body);
+
+  if (!priv->haxis || !priv->vaxis)
+    return TRUE;
+
+  gint active_row = -1, active_col = -1;
+  get_active_cell (body, &active_col, &active_row);
+
+  guint width = gtk_widget_get_allocated_width (widget);
+  guint height = gtk_widget_get_allocated_height (widget);
+
+  GtkStyleContext *sc = gtk_widget_get_style_context (widget);
+
+  GtkCssProvider *cp = gtk_css_provider_new ();
+
+  GtkBorder border;
+  if (priv->editable)
+    {
+      gint yy = ssw_sheet_axis_find_boundary (priv->vaxis, active_row, NULL, NULL);
+      gint xx = ssw_sheet_axis_find_boundary (priv->haxis, active_col, NULL, NULL);
+
+      if (yy == 0 && xx == 0 && priv->editor == NULL)
+        start_editing (body, NULL);
+
+      if ((gtk_widget_is_focus (widget) ||
+           (priv->editor && gtk_widget_is_focus (priv->editor))))
+        gtk_css_provider_load_from_data (cp, focused_border, strlen (focused_border), 0);
+      else
+        gtk_css_provider_load_from_data (cp, unfocused_border,
+                                         strlen (unfocused_border), 0);
+
+      gtk_style_context_add_provider (sc, GTK_STYLE_PROVIDER (cp),
+                                      GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+
+      gtk_style_context_get_border (sc,
+                                    gtk_widget_get_state_flags (widget),
+                                    &border);
+    }
+
+  /* The cells which scroll are drawn first, and the frozen ones
+     above them */
+  struct block blocks[N_BLOCKS];
+  const gint n_blocks = get_blocks (body, blocks);
+  gint b;
+
+  for (b = 0; b < n_blocks; ++b)
+    {
+      cairo_save (cr);
+      clip_to_block (cr, &blocks[b]);
+      draw_block_cells (body, cr, sc, &border, &blocks[b],
+                        active_col, active_row);
+      cairo_restore (cr);
+    }
 
   if (gtk_gesture_is_active (priv->horizontal_resize_gesture))
     {
@@ -540,7 +946,8 @@ __draw (GtkWidget *widget, cairo_t *cr)
       gtk_render_line (sc, cr, 0, start_y + offsety, width, start_y + offsety);
     }
 
-  draw_selection (body, cr);
+  draw_matches (body, cr, blocks, n_blocks);
+  draw_selection (body, cr, blocks, n_blocks);
 
   gtk_style_context_remove_provider (sc, GTK_STYLE_PROVIDER (cp));
 
@@ -572,6 +979,17 @@ __dispose (GObject *object)
   if (priv->data_model)
     g_object_unref (priv->data_model);
 
+  if (priv->sheet && priv->sheet->cursor.body == GTK_WIDGET (body))
+    priv->sheet->cursor.body = NULL;
+
+  if (priv->move_tick)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (body), priv->move_tick);
+      priv->move_tick = 0;
+    }
+
+  ssw_sheet_body_cancel_clip (body);
+
   priv->dispose_has_run = TRUE;
 
   G_OBJECT_CLASS (ssw_sheet_body_parent_class)->dispose (object);
@@ -605,6 +1023,7 @@ announce_selection (SswSheetBody *body)
 
   PRIV_DECL (body);
 
+  sync_selection_set (body);
   g_signal_emit (body, signals [SELECTION_CHANGED], 0, priv->selection);
 
   GtkClipboard *primary =
@@ -619,6 +1038,8 @@ set_selection (SswSheetBody *body, gint start_x, gint start_y, gint end_x, gint
 {
   PRIV_DECL (body);
 
+  begin_range (body, FALSE);
+
   priv->selection->start_x = start_x;
   priv->selection->start_y = start_y;
 
@@ -714,22 +1135,37 @@ start_editing (SswSheetBody *body, GdkEvent *e)
   /* There seems to be a bug in GtkCellRendererSpinButton, where
      its GtkAdjustment spins at wierd moments.  Blocking the handler
      here seems to work around the problem. */
-  if (priv->editor && GTK_IS_SPIN_BUTTON (priv->editor))
-    g_signal_handlers_block_by_func (priv->editor, finish_editing, NULL);
+  GtkWidget *old = priv->editor;
+  if (old && GTK_IS_SPIN_BUTTON (old))
+    {
+      g_object_ref (old);
+      g_signal_handlers_block_by_func (old, finish_editing, NULL);
+    }
 
   if (GTK_WIDGET (body) == priv->sheet->selected_body)
     {
       GtkCellRenderer *renderer = choose_renderer (body, col, row);
+      gchar path[64];
+
+      format_path (body, path, sizeof path);
+
       GtkCellEditable *ce =
         gtk_cell_renderer_start_editing (renderer, e, GTK_WIDGET (body),
-                                         priv->path, NULL, NULL,
+                                         path, NULL, NULL,
                                          GTK_CELL_RENDERER_SELECTED);
 
       /* We use this property with a slightly different nuance:
          It is rather a "not-started" flag than a canceled flag. That is
          to say, it is TRUE  by default and becomes FALSE, once an
          edit has commenced */
-      g_object_set (ce, "editing-canceled", TRUE, NULL);
+      if (ce)
+        g_object_set (ce, "editing-canceled", TRUE, NULL);
+    }
+
+  if (old && GTK_IS_SPIN_BUTTON (old))
+    {
+      g_signal_handlers_unblock_by_func (old, finish_editing, NULL);
+      g_object_unref (old);
     }
 }
 
@@ -756,6 +1192,13 @@ __button_press_event (GtkWidget *w, GdkEventButton *e)
   if (trim_to_model_limits (body, old_col, old_row, &col, &row))
     return FALSE;
 
+  /* The click overrides any movement by the keyboard */
+  if (priv->move_tick)
+    {
+      gtk_widget_remove_tick_callback (w, priv->move_tick);
+      priv->move_tick = 0;
+    }
+
   if (priv->editor)
     on_editing_done (GTK_CELL_EDITABLE (priv->editor), body);
 
@@ -795,6 +1238,32 @@ is_printable_key (gint keyval)
   return (0 != gdk_keyval_to_unicode (keyval));
 }
 
+/* Return the row at the edge of the block of data which is reached by
+   moving from COL, ROW in the direction DIR, or FALLBACK if there is
+   no such block.  */
+static gint
+row_edge (SswSheetBody *body, gint col, gint row, gint dir, gint fallback)
+{
+  PRIV_DECL (body);
+
+  gint edge = ssw_occupancy_find_row_edge (priv->sheet->occupancy,
+                                           col, row, dir);
+
+  return (edge < 0) ? fallback : edge;
+}
+
+/* As row_edge, but for the column reached by moving along ROW */
+static gint
+column_edge (SswSheetBody *body, gint col, gint row, gint dir, gint fallback)
+{
+  PRIV_DECL (body);
+
+  gint edge = ssw_occupancy_find_column_edge (priv->sheet->occupancy,
+                                              col, row, dir);
+
+  return (edge < 0) ? fallback : edge;
+}
+
 static gboolean
 __key_press_event_shifted (GtkWidget *w, GdkEventKey *e)
 {
@@ -805,25 +1274,33 @@ __key_press_event_shifted (GtkWidget *w, GdkEventKey *e)
     {
     case GDK_KEY_Left:
       if (e->state & GDK_CONTROL_MASK)
-        priv->selection->end_x = 0;
+        priv->selection->end_x =
+          column_edge (body, priv->selection->end_x, priv->selection->end_y,
+                       -1, 0);
       else
         priv->selection->end_x--;
       break;
     case GDK_KEY_Right:
       if (e->state & GDK_CONTROL_MASK)
-        priv->selection->end_x = ssw_sheet_axis_get_size (priv->haxis) - 1;
+        priv->selection->end_x =
+          column_edge (body, priv->selection->end_x, priv->selection->end_y,
+                       +1, ssw_sheet_axis_get_size (priv->haxis) - 1);
       else
         priv->selection->end_x++;
       break;
     case GDK_KEY_Up:
       if (e->state & GDK_CONTROL_MASK)
-        priv->selection->end_y = 0;
+        priv->selection->end_y =
+          row_edge (body, priv->selection->end_x, priv->selection->end_y,
+                    -1, 0);
       else
         priv->selection->end_y--;
       break;
     case GDK_KEY_Down:
       if (e->state & GDK_CONTROL_MASK)
-        priv->selection->end_y = ssw_sheet_axis_get_size (priv->vaxis) - 1;
+        priv->selection->end_y =
+          row_edge (body, priv->selection->end_x, priv->selection->end_y,
+                    +1, ssw_sheet_axis_get_size (priv->vaxis) - 1);
       else
         priv->selection->end_y++;
       break;
@@ -883,13 +1360,137 @@ ssw_sheet_body_set_active_cell (SswSheetBody *body,
     {
       set_selection (body, col, row, col, row);
     }
-}
+}
+
+/* Scroll the cell COL, ROW into view, if it is not already visible.
+   The frozen rows and columns are always visible.  */
+static void
+show_cell (SswSheetBody *body, gint col, gint row)
+{
+  PRIV_DECL (body);
+
+  if (col >= ssw_sheet_axis_get_n_frozen (priv->haxis))
+    {
+      if (col > ssw_sheet_axis_get_last (priv->haxis))
+        ssw_sheet_axis_jump_end (priv->haxis, col);
+
+      if (col < ssw_sheet_axis_get_first (priv->haxis))
+        ssw_sheet_axis_jump_start (priv->haxis, col);
+    }
+
+  if (row >= ssw_sheet_axis_get_n_frozen (priv->vaxis))
+    {
+      if (row > ssw_sheet_axis_get_last (priv->vaxis))
+        ssw_sheet_axis_jump_end (priv->vaxis, row);
+
+      if (row < ssw_sheet_axis_get_first (priv->vaxis))
+        ssw_sheet_axis_jump_start (priv->vaxis, row);
+    }
+}
+
+void
+ssw_sheet_body_goto_cell (SswSheetBody *body, gint col, gint row)
+{
+  PRIV_DECL (body);
+
+  show_cell (body, col, row);
+
+  if (priv->editable)
+    ssw_sheet_body_set_active_cell (body, col, row, NULL);
+  else
+    set_active_cell (body, col, row);
+
+  set_selection (body, col, row, col, row);
+}
+
+/* Make COL, ROW the active cell, in response to the keyboard event E
+   (which may be NULL) */
+static void
+move_to (SswSheetBody *body, gint col, gint row, GdkEvent *e)
+{
+  PRIV_DECL (body);
+
+  gint old_row = -1, old_col = -1;
+  get_active_cell (body, &old_col, &old_row);
+
+  if (priv->move_tick)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (body), priv->move_tick);
+      priv->move_tick = 0;
+    }
+
+  show_cell (body, col, row);
+
+  ssw_sheet_body_set_active_cell (body, col, row, e);
+
+  if (old_row != row || old_col != col)
+    set_selection (body, col, row, col, row);
+}
+
+static gboolean
+apply_pending_move (GtkWidget *w, GdkFrameClock *clock, gpointer ud)
+{
+  SswSheetBody *body = SSW_SHEET_BODY (w);
+  PRIV_DECL (body);
+
+  priv->move_tick = 0;
+  move_to (body, priv->pending_col, priv->pending_row, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Make COL, ROW the active cell at the next frame.  Further moves
+   before then replace this one, so that when keys repeat faster than
+   the sheet can be drawn, the cells passed over are neither scrolled
+   to, edited nor selected.  */
+static void
+queue_move (SswSheetBody *body, gint col, gint row)
+{
+  PRIV_DECL (body);
+
+  priv->pending_col = col;
+  priv->pending_row = row;
+
+  if (priv->move_tick == 0)
+    priv->move_tick = gtk_widget_add_tick_callback (GTK_WIDGET (body),
+                                                    apply_pending_move,
+                                                    NULL, NULL);
+}
+
+static gboolean
+__key_press_event (GtkWidget *w, GdkEventKey *e)
+{
+  SswSheetBody *body = SSW_SHEET_BODY (w);
+  PRIV_DECL (body);
+
+  /* Escape abandons a paste which is still in progress */
+  if (e->keyval == GDK_KEY_Escape && priv->sheet && priv->sheet->paste)
+    {
+      ssw_sheet_cancel_paste (priv->sheet);
+      return TRUE;
+    }
+
+  /* Keys which might be coalesced with a pending move */
+  gboolean coalesce = FALSE;
+  switch (e->keyval)
+    {
+    case GDK_KEY_Up:
+    case GDK_KEY_Down:
+    case GDK_KEY_Left:
+    case GDK_KEY_Right:
+    case GDK_KEY_Page_Up:
+    case GDK_KEY_Page_Down:
+    case GDK_KEY_Home:
+      coalesce = !(e->state & GDK_SHIFT_MASK) && gtk_widget_get_mapped (w);
+      break;
+    }
+
+  /* Any other key acts upon the cell to which the keyboard has moved.
+     move_to removes the tick callback, so that it cannot apply the
+     move a second time.  */
+  if (priv->move_tick && !coalesce)
+    move_to (body, priv->pending_col, priv->pending_row, NULL);
 
-static gboolean
-__key_press_event (GtkWidget *w, GdkEventKey *e)
-{
-  SswSheetBody *body = SSW_SHEET_BODY (w);
-  PRIV_DECL (body);
   /* If send_event is true, then this event has been generated by on_entry_activate*/
   if ( !e->send_event &&
        GTK_WIDGET_CLASS (ssw_sheet_body_parent_class)->key_press_event (w, e))
@@ -921,6 +1522,12 @@ __key_press_event (GtkWidget *w, GdkEventKey *e)
   gint row = -1, col = -1;
   get_active_cell (body, &col, &row);
 
+  if (priv->move_tick)
+    {
+      col = priv->pending_col;
+      row = priv->pending_row;
+    }
+
   gint page_length = ssw_sheet_axis_get_visible_size (priv->vaxis) - 1;
 
   gint hstep ;
@@ -951,13 +1558,13 @@ __key_press_event (GtkWidget *w, GdkEventKey *e)
       break;
     case GDK_KEY_Left:
       if (e->state & GDK_CONTROL_MASK)
-        col = h_start_limit;
+        col = column_edge (body, col, row, -hstep, h_start_limit);
       else
         col -= hstep;
       break;
     case GDK_KEY_Right:
       if (e->state & GDK_CONTROL_MASK)
-        col = h_end_limit;
+        col = column_edge (body, col, row, hstep, h_end_limit);
       else
         col += hstep;
       break;
@@ -969,13 +1576,13 @@ __key_press_event (GtkWidget *w, GdkEventKey *e)
       break;
     case GDK_KEY_Up:
       if (e->state & GDK_CONTROL_MASK)
-        row = 0;
+        row = row_edge (body, col, row, -1, 0);
       else
         row--;
       break;
     case GDK_KEY_Down:
       if (e->state & GDK_CONTROL_MASK)
-        row = G_MAXINT;
+        row = row_edge (body, col, row, +1, G_MAXINT);
       else
         row++;
       break;
@@ -1009,22 +1616,10 @@ __key_press_event (GtkWidget *w, GdkEventKey *e)
 
   trim_to_model_limits (body, old_col, old_row, &col, &row);
 
-  if (col > ssw_sheet_axis_get_last (priv->haxis))
-    ssw_sheet_axis_jump_end (priv->haxis, col);
-
-  if (col < ssw_sheet_axis_get_first (priv->haxis))
-    ssw_sheet_axis_jump_start (priv->haxis, col);
-
-  if (row > ssw_sheet_axis_get_last (priv->vaxis))
-    ssw_sheet_axis_jump_end (priv->vaxis, row);
-
-  if (row < ssw_sheet_axis_get_first (priv->vaxis))
-    ssw_sheet_axis_jump_start (priv->vaxis, row);
-
-  ssw_sheet_body_set_active_cell (body, col, row, (GdkEvent *) e);
-
-  if (old_row != row || old_col != col)
-    set_selection (body, col, row, col, row);
+  if (coalesce)
+    queue_move (body, col, row);
+  else
+    move_to (body, col, row, (GdkEvent *) e);
 
   /* Return true, to stop keys unfocusing the sheet */
   return TRUE;
@@ -1139,12 +1734,24 @@ select_entire_row (SswSheetBody *body, gint i, guint state, gpointer ud)
   GdkKeymap *km = gdk_keymap_get_for_display (disp);
   GdkModifierType extend_mask =
     gdk_keymap_get_modifier_mask (km, GDK_MODIFIER_INTENT_EXTEND_SELECTION);
+  GdkModifierType modify_mask =
+    gdk_keymap_get_modifier_mask (km, GDK_MODIFIER_INTENT_MODIFY_SELECTION);
 
   gint start_y = (extend_mask & state) ? priv->selection->start_y : i;
 
-  set_selection (body,
-                 0, start_y,
-                 ssw_sheet_axis_get_size (priv->haxis) - 1, i);
+  if ((modify_mask & state) && !(extend_mask & state))
+    {
+      begin_range (body, TRUE);
+      priv->selection->start_x = 0;
+      priv->selection->start_y = i;
+      priv->selection->end_x = ssw_sheet_axis_get_size (priv->haxis) - 1;
+      priv->selection->end_y = i;
+      announce_selection (body);
+    }
+  else
+    set_selection (body,
+                   0, start_y,
+                   ssw_sheet_axis_get_size (priv->haxis) - 1, i);
   start_editing (body, NULL);
 }
 
@@ -1156,12 +1763,24 @@ select_entire_column (SswSheetBody *body, gint i, guint state, gpointer ud)
   GdkKeymap *km = gdk_keymap_get_for_display (disp);
   GdkModifierType extend_mask =
     gdk_keymap_get_modifier_mask (km, GDK_MODIFIER_INTENT_EXTEND_SELECTION);
+  GdkModifierType modify_mask =
+    gdk_keymap_get_modifier_mask (km, GDK_MODIFIER_INTENT_MODIFY_SELECTION);
 
   gint start_x = (extend_mask & state) ? priv->selection->start_x : i;
 
-  set_selection (body,
-                 start_x, 0,
-                 i, ssw_sheet_axis_get_size (priv->vaxis) - 1);
+  if ((modify_mask & state) && !(extend_mask & state))
+    {
+      begin_range (body, TRUE);
+      priv->selection->start_x = i;
+      priv->selection->start_y = 0;
+      priv->selection->end_x = i;
+      priv->selection->end_y = ssw_sheet_axis_get_size (priv->vaxis) - 1;
+      announce_selection (body);
+    }
+  else
+    set_selection (body,
+                   start_x, 0,
+                   i, ssw_sheet_axis_get_size (priv->vaxis) - 1);
   start_editing (body, NULL);
 }
 
@@ -1177,6 +1796,10 @@ set_editor_widget_value (SswSheetBody *body, GValue *value, GtkEditable *editabl
   gint row = -1, col = -1;
   get_active_cell (body, &col, &row);
 
+  /* A datum which has not yet arrived is shown as an empty cell */
+  if (G_IS_VALUE (value) && SSW_VALUE_HOLDS_PENDING (value))
+    value = NULL;
+
   /* Allow the datum to be changed only if the "editable" property is set */
   gtk_editable_set_editable (editable, priv->editable);
 
@@ -1197,7 +1820,8 @@ set_editor_widget_value (SswSheetBody *body, GValue *value, GtkEditable *editabl
     {
       gchar *s = NULL;
       if (G_IS_VALUE (value))
-        s = priv->cf (priv->sheet, priv->data_model, col, row, value);
+        s = priv->cf (priv->sheet, priv->data_model,
+                      model_col (body, col), model_row (body, row), value);
       gtk_entry_set_text (GTK_ENTRY (editable), s ? s : "");
       g_free (s);
     }
@@ -1229,10 +1853,12 @@ update_editable (SswSheetBody *body)
     return;
 
   GtkTreeIter iter;
-  if (gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row))
+  if (gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL,
+                                     model_row (body, row)))
     {
       GValue value = G_VALUE_INIT;
-      gtk_tree_model_get_value (priv->data_model, &iter, col, &value);
+      gtk_tree_model_get_value (priv->data_model, &iter,
+                                model_col (body, col), &value);
 
       set_editor_widget_value (body, &value, GTK_EDITABLE (priv->editor));
       g_value_unset (&value);
@@ -1283,9 +1909,13 @@ __set_property (GObject *object,
       break;
     case PROP_RENDERER_FUNC:
       priv->renderer_func = g_value_get_pointer (value);
+      if (priv->sheet)
+        ssw_render_cache_invalidate (priv->sheet->render_cache, 0, -1);
       break;
     case PROP_CONVERT_FWD_FUNC:
       priv->cf = g_value_get_pointer (value);
+      if (priv->sheet)
+        ssw_render_cache_invalidate (priv->sheet->render_cache, 0, -1);
       gtk_widget_queue_draw (GTK_WIDGET (body));
       update_editable (body);
       break;
@@ -1296,6 +1926,7 @@ __set_property (GObject *object,
       priv->selection = g_value_get_pointer (value);
       break;
     case PROP_DATA_MODEL:
+      ssw_sheet_body_cancel_clip (body);
       g_set_object (&priv->data_model, g_value_get_object (value));
       g_signal_connect_object (priv->data_model, "items-changed",
                                G_CALLBACK (on_data_change), body, 0);
@@ -1511,13 +2142,34 @@ selection_drag_begin (GtkGesture *gesture,
 
   gtk_gesture_set_state (gesture, GTK_EVENT_SEQUENCE_CLAIMED);
 
-  ssw_sheet_body_unset_selection (body);
+  /* With the Control key, the range is selected in addition to those
+     already selected */
+  GdkModifierType state = 0;
+  const GdkEvent *e =
+    gtk_gesture_get_last_event (gesture,
+                                gtk_gesture_get_last_updated_sequence (gesture));
+  if (e)
+    gdk_event_get_state (e, &state);
+
+  GdkKeymap *km = gdk_keymap_get_for_display (gtk_widget_get_display (GTK_WIDGET (body)));
+  GdkModifierType modify_mask =
+    gdk_keymap_get_modifier_mask (km, GDK_MODIFIER_INTENT_MODIFY_SELECTION);
+
+  if (state & modify_mask)
+    begin_range (body, TRUE);
+  else
+    {
+      begin_range (body, FALSE);
+      ssw_sheet_body_unset_selection (body);
+    }
 
   priv->selection->start_x = ssw_sheet_axis_find_cell (priv->haxis, start_x, NULL, NULL);
   priv->selection->start_y = ssw_sheet_axis_find_cell (priv->vaxis, start_y, NULL, NULL);
 
   priv->selection->end_x = priv->selection->start_x;
   priv->selection->end_y = priv->selection->start_y;
+
+  sync_selection_set (body);
 }
 
 
@@ -1553,7 +2205,7 @@ selection_drag_update (GtkGestureDrag *gesture,
     priv->selection->end_y++;
 
   limit_selection (body);
-
+  sync_selection_set (body);
 
   gtk_widget_queue_draw (GTK_WIDGET (body));
 }
@@ -1667,7 +2319,8 @@ static const GtkTargetEntry targets[] =
 
 /*
   Append a string representation of the value contained in MODEL,ITER,COL
-  to the string OUTPUT.
+  to the string OUTPUT.  COL and ROW are positions in the view.  ITER must
+  refer to the model row displayed at ROW.
 */
 static void
 append_value_to_string (SswSheetBody *body,
@@ -1677,132 +2330,244 @@ append_value_to_string (SswSheetBody *body,
   PRIV_DECL (body);
   GtkTreeModel *model = priv->data_model;
   GValue value = G_VALUE_INIT;
-  GValue target_value = G_VALUE_INIT;
-  g_value_init (&target_value, G_TYPE_STRING);
+  col = model_col (body, col);
+  row = model_row (body, row);
   gtk_tree_model_get_value (model, iter, col, &value);
 
-  if (priv->cf)
+  if (SSW_VALUE_HOLDS_PENDING (&value))
     {
-      gchar *x = priv->cf (priv->sheet, model, col, row, &value);
-      g_string_append (output, x);
-      g_free (x);
+      /* The datum is not yet available.  Leave the cell empty.  */
     }
-  else if (g_value_transform (&value, &target_value))
+  else if (priv->cf)
     {
-      g_string_append (output, g_value_get_string (&target_value));
+      gchar *x = priv->cf (priv->sheet, model, col, row, &value);
+      if (x)
+        g_string_append (output, x);
+      g_free (x);
     }
   else
     {
-      g_warning ("Pasting from SswSheet failed.  "
-                 "You must register a transform function for source "
-                 "type \"%s\" to dest type \"%s\"\n",
-                 G_VALUE_TYPE_NAME (&value),
-                 g_type_name (G_TYPE_STRING));
+      GValue target_value = G_VALUE_INIT;
+      g_value_init (&target_value, G_TYPE_STRING);
+      if (g_value_transform (&value, &target_value))
+        {
+          g_string_append (output, g_value_get_string (&target_value));
+        }
+      else
+        {
+          g_warning ("Pasting from SswSheet failed.  "
+                     "You must register a transform function for source "
+                     "type \"%s\" to dest type \"%s\"\n",
+                     G_VALUE_TYPE_NAME (&value),
+                     g_type_name (G_TYPE_STRING));
+        }
+      g_value_unset (&target_value);
     }
 
   g_value_unset (&value);
-  g_value_unset (&target_value);
 }
 
 
 
-static void
-clipit_html (SswSheetBody *body, GString *output, SswRange *source_range)
+/* Returns TRUE if the model reports that ROW has nothing to display
+   within SOURCE_RANGE */
+static gboolean
+row_is_empty (SswSheetBody *body, gint row, const SswRange *source_range)
 {
   PRIV_DECL (body);
-  if (!priv->haxis || !priv->vaxis || !priv->data_model)
-    return;
+  if (!columns_in_model_order (body))
+    return FALSE;
 
-  g_string_append (output, "<body>\n");
-  g_string_append (output, "<table>\n");
+  return ssw_data_model_is_block_empty (priv->data_model,
+                                        source_range->start_x,
+                                        model_row (body, row),
+                                        source_range->end_x - source_range->start_x + 1,
+                                        1);
+}
 
-  gint row;
-  gint col;
-  for (row = source_range->start_y ; row <= source_range->end_y; ++row)
-    {
-      GtkTreeIter iter;
-      gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row);
-      g_string_append (output, "<tr>\n");
-      for (col = source_range->start_x; col <= source_range->end_x; ++col)
-        {
-          if (row < gtk_tree_model_iter_n_children (priv->data_model, NULL)
-              && col < gtk_tree_model_get_n_columns (priv->data_model))
-            {
-              g_string_append (output, "<td>");
-              append_value_to_string (body, &iter, col, row, output);
-              g_string_append (output, "</td>\n");
-            }
-        }
-      g_string_append (output, "</tr>\n");
-    }
+/* The ssw_cell_source callbacks */
+static gboolean
+clip_fetch_row (gpointer data, const SswRange *range, gint row, GtkTreeIter *iter)
+{
+  SswSheetBody *body = data;
+  PRIV_DECL (body);
+
+  if (!gtk_tree_model_iter_nth_child (priv->data_model, iter, NULL,
+                                      model_row (body, row)))
+    return FALSE;
 
-  g_string_append (output, "</table>\n");
-  g_string_append (output, "</body>\n");
+  return !row_is_empty (body, row, range);
 }
 
+static void
+clip_cell_text (gpointer data, GtkTreeIter *iter, gint col, gint row,
+                GString *out)
+{
+  append_value_to_string (SSW_SHEET_BODY (data), iter, col, row, out);
+}
+
+/* The ssw_cell_source callbacks for a copy of several ranges.  The
+   source's rows and columns are those of the selection which contain
+   a selected cell.  Unselected cells are copied as empty.  */
+struct clip_union
+{
+  SswSheetBody *body;
+  const SswSelection *sel;
+  gint n_columns;
+};
+
+static gboolean
+clip_union_fetch_row (gpointer data, const SswRange *range, gint row,
+                      GtkTreeIter *iter)
+{
+  struct clip_union *cu = data;
+  PRIV_DECL (cu->body);
+
+  return gtk_tree_model_iter_nth_child (priv->data_model, iter, NULL,
+                                        model_row (cu->body,
+                                                   ssw_selection_nth_row (cu->sel, row)));
+}
 
 static void
-clipit_ascii (SswSheetBody *body, GString *output, SswRange *source_range)
+clip_union_cell_text (gpointer data, GtkTreeIter *iter, gint col, gint row,
+                      GString *out)
 {
-  PRIV_DECL (body);
-  if (!priv->haxis || !priv->vaxis || !priv->data_model)
-    return;
+  struct clip_union *cu = data;
+  gint c = ssw_selection_nth_column (cu->sel, col);
+  gint r = ssw_selection_nth_row (cu->sel, row);
 
-  gint row;
-  gint col;
-  for (row = source_range->start_y ; row <= source_range->end_y; ++row)
-    {
-      GtkTreeIter iter;
-      gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row);
+  if (c < cu->n_columns && ssw_selection_contains (cu->sel, c, r))
+    append_value_to_string (cu->body, iter, c, r, out);
+}
 
-      for (col = source_range->start_x; col <= source_range->end_x; ++col)
-        {
-          if (priv->data_model
-              && row < gtk_tree_model_iter_n_children (priv->data_model, NULL)
-              && col < gtk_tree_model_get_n_columns (priv->data_model))
-            {
-              append_value_to_string (body, &iter, col, row, output);
+/* The number of rows serialized in each block */
+#define CLIP_CHUNK_ROWS 2048
 
-              if (col < source_range->end_x)
-                g_string_append (output, "\t");
-            }
-        }
-      if (row < source_range->end_y)
-        g_string_append (output, "\n");
+/* Copies estimated to be larger than this are serialized from an idle
+   handler, before the clipboard is claimed.  Smaller ones are
+   serialized when the data is requested.  */
+#define CLIP_INTERACTIVE_SIZE (1 << 20)
+
+/* The maximum number of row blocks serialized concurrently */
+#define CLIP_PARALLEL_BLOCKS 64
+
+/* The most space reserved for a copy before it is serialized.  The
+   estimate of its size may be far too large, so space beyond this is
+   allocated only as it is needed.  */
+#define CLIP_RESERVE_LIMIT (1 << 24)
+
+/* The key under which a clipboard holds the copy being serialized for
+   it, if any */
+#define CLIP_TASK_KEY "ssw-clip-task"
+
+struct clip_job
+{
+  const struct ssw_format *fmt;
+  const struct ssw_cell_source *src;
+  gint first_row;
+  gint last_row;
+  GString **blocks;
+};
+
+static void
+clip_block (gint task, gpointer data)
+{
+  struct clip_job *job = data;
+  gint first = job->first_row + task * CLIP_CHUNK_ROWS;
+  gint last = MIN (first + CLIP_CHUNK_ROWS - 1, job->last_row);
+
+  ssw_serialize (job->fmt, job->src, first, last, job->blocks[task]);
+}
+
+/* Serialize the rows FIRST_ROW to LAST_ROW of SRC onto OUTPUT,
+   formatting blocks of CLIP_CHUNK_ROWS rows concurrently, each into its
+   own buffer.  ROW_SIZE is the estimated size of one row.  */
+static void
+clip_parallel (const struct ssw_format *fmt, const struct ssw_cell_source *src,
+               GString *output, gint first_row, gint last_row,
+               gint64 row_size)
+{
+  struct clip_job job;
+  gint n_blocks = (last_row - first_row) / CLIP_CHUNK_ROWS + 1;
+  gint i;
+
+  job.fmt = fmt;
+  job.src = src;
+  job.first_row = first_row;
+  job.last_row = last_row;
+  job.blocks = g_malloc_n (n_blocks, sizeof *job.blocks);
+  for (i = 0; i < n_blocks; ++i)
+    job.blocks[i] = g_string_sized_new (MIN (row_size * CLIP_CHUNK_ROWS,
+                                             CLIP_RESERVE_LIMIT / n_blocks) + 1);
+
+  ssw_parallel_for (n_blocks, clip_block, &job);
+
+  for (i = 0; i < n_blocks; ++i)
+    {
+      g_string_append_len (output, job.blocks[i]->str, job.blocks[i]->len);
+      g_string_free (job.blocks[i], TRUE);
+    }
+  g_free (job.blocks);
+}
+
+/* The format in which the clipboard target INFO is served, or NULL if
+   INFO is unknown */
+static const struct ssw_format *
+target_format (guint info)
+{
+  switch (info)
+    {
+    case TARGET_TEXT_TSV:
+    case TARGET_TEXT_PLAIN:
+    case TARGET_UTF8_STRING:
+    case TARGET_STRING:
+      return &ssw_format_tsv;
+    case TARGET_TEXT_CSV:
+      return &ssw_format_csv;
+    case TARGET_HTML:
+      return &ssw_format_html;
+    default:
+      g_warning ("Request for unknown target %d\n", info);
+      return NULL;
     }
 }
 
+/* Set SRC to read RANGE of BODY, or the table of the rows and columns
+   of SEL which contain a selected cell, if SEL is not NULL.  CU holds
+   the state of the latter, and SEL must outlive SRC.  Cells beyond
+   the extent of the model are not included.  */
 static void
-clipit_utf8 (SswSheetBody *body, GString *output, SswRange *source_range)
+init_clip_source (SswSheetBody *body, const SswRange *range,
+                  const SswSelection *sel, struct ssw_cell_source *src,
+                  struct clip_union *cu)
 {
   PRIV_DECL (body);
-  if (!priv->haxis || !priv->vaxis || !priv->data_model)
-    return;
 
-  gint row;
-  gint col;
-  for (row = source_range->start_y ; row <= source_range->end_y; ++row)
-    {
-      GtkTreeIter iter;
-      gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row);
+  src->range = *range;
+  src->range.end_x = MIN (src->range.end_x,
+                          gtk_tree_model_get_n_columns (priv->data_model) - 1);
+  src->range.end_y = MIN (src->range.end_y,
+                          gtk_tree_model_iter_n_children (priv->data_model, NULL) - 1);
+  src->fetch_row = clip_fetch_row;
+  src->cell_text = clip_cell_text;
+  src->data = body;
 
-      for (col = source_range->start_x; col <= source_range->end_x; ++col)
-        {
-          if (row < gtk_tree_model_iter_n_children (priv->data_model, NULL)
-              && col < gtk_tree_model_get_n_columns (priv->data_model))
-            {
-              append_value_to_string (body, &iter, col, row, output);
+  if (sel)
+    {
+      cu->body = body;
+      cu->sel = sel;
+      cu->n_columns = gtk_tree_model_get_n_columns (priv->data_model);
 
-              if (col < source_range->end_x)
-                g_string_append_c (output, '\t');
-            }
-        }
-      if (row < source_range->end_y)
-        g_string_append (output, "\n");
+      src->range.start_x = src->range.start_y = 0;
+      src->range.end_x = ssw_selection_get_n_columns (sel) - 1;
+      src->range.end_y = ssw_selection_get_n_rows (sel) - 1;
+      src->fetch_row = clip_union_fetch_row;
+      src->cell_text = clip_union_cell_text;
+      src->data = cu;
     }
 }
 
-
+/* Serve a copy small enough to be serialized on request */
 static void
 get_func (GtkClipboard *clipboard,
           GtkSelectionData *selection_data,
@@ -1817,32 +2582,30 @@ get_func (GtkClipboard *clipboard,
       return;
     }
 
-  SswRange *source_range = g_object_get_data (G_OBJECT (clipboard), "source-range");
-  g_return_if_fail (source_range);
+  PRIV_DECL (body);
+
+  SswRange *r = g_object_get_data (G_OBJECT (clipboard), "source-range");
+  g_return_if_fail (r);
 
-  GString *stuff = g_string_new ("");
-  switch (info)
-    {
-    case TARGET_STRING:
-      clipit_ascii (body, stuff, source_range);
-      break;
-    case TARGET_UTF8_STRING:
-      clipit_utf8 (body, stuff, source_range);
-      break;
-    case TARGET_HTML:
-      clipit_html (body, stuff, source_range);
-      break;
-    default:
-      g_warning ("Request for unknown target %d\n", info);
-      return ;
-      break;
-    }
+  const SswSelection *sel = g_object_get_data (G_OBJECT (clipboard), "source-selection");
+
+  const struct ssw_format *fmt = target_format (info);
+  if (fmt == NULL || !priv->data_model)
+    return;
+
+  struct ssw_cell_source src;
+  struct clip_union cu;
+  init_clip_source (body, r, sel, &src, &cu);
+
+  GString *stuff = g_string_sized_new (1024);
+  if (src.range.end_x >= src.range.start_x
+      && src.range.end_y >= src.range.start_y)
+    ssw_serialize (fmt, &src, src.range.start_y, src.range.end_y, stuff);
 
   gtk_selection_data_set (selection_data,
                           gdk_atom_intern_static_string (targets[info].target),
                           CHAR_BIT,
                           (gpointer) stuff->str, stuff->len);
-
   g_string_free (stuff, TRUE);
 }
 
@@ -1853,6 +2616,176 @@ clear_func (GtkClipboard *clipboard,
 {
 }
 
+/* A copy which has been serialized in advance, as a snapshot from
+   which each target is served */
+struct clip_payload
+{
+  GString *snapshot;
+  gint n_cols;
+  gint n_rows;
+};
+
+static void
+payload_get_func (GtkClipboard *clipboard,
+                  GtkSelectionData *selection_data,
+                  guint info,
+                  gpointer data)
+{
+  struct clip_payload *payload = data;
+  const struct ssw_format *fmt = target_format (info);
+
+  if (fmt == NULL)
+    return;
+
+  struct ssw_cell_source src;
+  struct ssw_snapshot_reader rd;
+  ssw_snapshot_source_init (&src, &rd, payload->snapshot,
+                            payload->n_cols, payload->n_rows);
+
+  GString *stuff = g_string_sized_new (payload->snapshot->len + 1);
+  ssw_serialize (fmt, &src, 0, payload->n_rows - 1, stuff);
+  gtk_selection_data_set (selection_data,
+                          gdk_atom_intern_static_string (targets[info].target),
+                          CHAR_BIT,
+                          (gpointer) stuff->str, stuff->len);
+  g_string_free (stuff, TRUE);
+}
+
+static void
+payload_clear_func (GtkClipboard *clipboard, gpointer data)
+{
+  struct clip_payload *payload = data;
+
+  g_string_free (payload->snapshot, TRUE);
+  g_free (payload);
+}
+
+/* A large copy, being serialized a block of rows at a time from an
+   idle handler.  The clipboard is claimed once it is complete.  */
+struct clip_task
+{
+  SswSheetBody *body;
+  GtkClipboard *clip;
+  SswSelection *sel;
+  struct ssw_cell_source src;
+  struct clip_union cu;
+
+  /* The snapshot being built, and the next row to be added to it */
+  GString *snapshot;
+  gint row;
+
+  gint64 row_size;
+  gboolean parallel;
+  guint idle;
+};
+
+static void
+clip_task_free (gpointer data)
+{
+  struct clip_task *task = data;
+  PRIV_DECL (task->body);
+
+  priv->clip_tasks = g_slist_remove (priv->clip_tasks, task);
+  if (task->idle)
+    g_source_remove (task->idle);
+  if (task->snapshot)
+    g_string_free (task->snapshot, TRUE);
+  ssw_selection_free (task->sel);
+  g_free (task);
+}
+
+static gboolean
+clip_step (gpointer data)
+{
+  struct clip_task *task = data;
+  PRIV_DECL (task->body);
+  const SswRange *range = &task->src.range;
+  const gint n_rows = range->end_y - range->start_y + 1;
+  const gint step = CLIP_CHUNK_ROWS * (task->parallel ? CLIP_PARALLEL_BLOCKS : 1);
+  const gint last = MIN (task->row + step - 1, range->end_y);
+
+  if (task->parallel)
+    clip_parallel (&ssw_format_snapshot, &task->src, task->snapshot,
+                   task->row, last, task->row_size);
+  else
+    ssw_serialize (&ssw_format_snapshot, &task->src, task->row, last,
+                   task->snapshot);
+  task->row = last + 1;
+
+  if (task->row <= range->end_y)
+    {
+      g_signal_emit_by_name (priv->sheet, "clip-progress",
+                             (task->row - range->start_y) / (gdouble) n_rows);
+      return G_SOURCE_CONTINUE;
+    }
+
+  /* The copy is complete, so claim the clipboard with it */
+  GtkClipboard *clip = task->clip;
+  struct clip_payload *payload = g_malloc (sizeof *payload);
+  payload->snapshot = task->snapshot;
+  payload->n_cols = range->end_x - range->start_x + 1;
+  payload->n_rows = n_rows;
+  task->snapshot = NULL;
+  task->idle = 0;
+  g_object_set_data (G_OBJECT (clip), CLIP_TASK_KEY, NULL);
+
+  if (!gtk_clipboard_set_with_data (clip, targets, N_TARGETS,
+                                    payload_get_func, payload_clear_func,
+                                    payload))
+    {
+      g_warning ("Clip failed\n");
+      payload_clear_func (clip, payload);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Begin to serialize SRC, whose estimated size is ESTIMATE, for CLIP.
+   SEL, if not NULL, is taken by the task.  */
+static void
+start_clip_task (SswSheetBody *body, GtkClipboard *clip, SswSelection *sel,
+                 const SswRange *range, gint64 estimate)
+{
+  PRIV_DECL (body);
+  struct clip_task *task = g_malloc0 (sizeof *task);
+
+  task->body = body;
+  task->clip = clip;
+  task->sel = sel;
+  init_clip_source (body, range, sel, &task->src, &task->cu);
+
+  const gint n_rows = task->src.range.end_y - task->src.range.start_y + 1;
+  task->row = task->src.range.start_y;
+  task->row_size = estimate / n_rows;
+  task->snapshot = g_string_sized_new (MIN (estimate, CLIP_RESERVE_LIMIT) + 1);
+
+  /* If the model permits, several blocks at a time are serialized in
+     parallel */
+  task->parallel = n_rows > CLIP_CHUNK_ROWS
+    && ssw_data_model_is_thread_safe (priv->data_model)
+    && (priv->cf == ssw_sheet_default_forward_conversion
+        || priv->sheet->thread_safe_conversion);
+
+  /* A copy still being serialized for CLIP is superseded */
+  priv->clip_tasks = g_slist_prepend (priv->clip_tasks, task);
+  g_object_set_data_full (G_OBJECT (clip), CLIP_TASK_KEY, task,
+                          clip_task_free);
+
+  task->idle = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, clip_step, task, NULL);
+}
+
+void
+ssw_sheet_body_cancel_clip (SswSheetBody *body)
+{
+  PRIV_DECL (body);
+
+  while (priv->clip_tasks)
+    {
+      struct clip_task *task = priv->clip_tasks->data;
+      g_object_set_data (G_OBJECT (task->clip), CLIP_TASK_KEY, NULL);
+    }
+}
+
 void
 ssw_sheet_body_set_clip (SswSheetBody *body, GtkClipboard *clip)
 {
@@ -1868,11 +2801,59 @@ ssw_sheet_body_set_clip (SswSheetBody *body, GtkClipboard *clip)
       return;
     }
 
+  if (!priv->data_model || !priv->sheet)
+    return;
+
+  SswRange range;
+  normalise_selection (priv->selection, &range);
+
+  /* Several ranges are copied as the table of the rows and columns
+     which contain a selected cell */
+  const SswSelection *set = priv->sheet->selection_set;
+  SswSelection *sel = (set && ssw_selection_get_n_ranges (set) > 1)
+    ? ssw_selection_copy (set) : NULL;
+
+  struct ssw_cell_source src;
+  struct clip_union cu;
+  init_clip_source (body, &range, sel, &src, &cu);
+
+  gint64 estimate = 0;
+  if (src.range.end_x >= src.range.start_x
+      && src.range.end_y >= src.range.start_y)
+    estimate = ssw_serialize_estimate (&ssw_format_tsv, &src);
+
+  /* The primary selection changes with every selection made, so asking
+     the application to approve it would be intrusive.  A large one is
+     simply not offered.  */
+  SswSheet *sheet = priv->sheet;
+  if (sheet->clip_size_limit > 0 && estimate > sheet->clip_size_limit)
+    {
+      gboolean proceed = FALSE;
+      if (gtk_clipboard_get_selection (clip) != GDK_SELECTION_PRIMARY)
+        g_signal_emit_by_name (sheet, "clip-size-exceeded", estimate, &proceed);
+      if (!proceed)
+        {
+          ssw_selection_free (sel);
+          return;
+        }
+    }
+
+  if (estimate > CLIP_INTERACTIVE_SIZE)
+    {
+      start_clip_task (body, clip, sel, &range, estimate);
+      return;
+    }
+
+  /* A small copy is serialized only if it is requested */
+  g_object_set_data (G_OBJECT (clip), CLIP_TASK_KEY, NULL);
+
   SswRange *source_range = g_object_get_data (G_OBJECT (clip), "source-range");
   g_free (source_range);
   source_range = g_malloc (sizeof (*source_range));
+  *source_range = range;
   g_object_set_data (G_OBJECT (clip), "source-range", source_range);
-  normalise_selection (priv->selection, source_range);
+  g_object_set_data_full (G_OBJECT (clip), "source-selection", sel,
+                          (GDestroyNotify) ssw_selection_free);
 
   if (!gtk_clipboard_set_with_owner (clip, targets, N_TARGETS,
                                      get_func, clear_func, G_OBJECT (body)))
@@ -2057,7 +3038,6 @@ ssw_sheet_body_init (SswSheetBody *body)
   gtk_style_context_add_class (context, "cell");
 
   priv->sheet = NULL;
-  priv->path[0] = '\0';
   priv->dispose_has_run = FALSE;
 
   priv->default_renderer = gtk_cell_renderer_text_new ();
@@ -2107,6 +3087,8 @@ ssw_sheet_body_init (SswSheetBody *body)
   priv->editor = NULL;
   priv->cf = ssw_sheet_default_forward_conversion;
   priv->revf = ssw_sheet_default_reverse_conversion;
+  priv->clip_tasks = NULL;
+  priv->move_tick = 0;
 
   priv->active_cell_holder = ssw_constraint_new ();
   /* Keep the constraint widget well out of the visible range */
@@ -2119,6 +3101,7 @@ ssw_sheet_body_unset_selection (SswSheetBody *body)
   PRIV_DECL (body);
   priv->selection->start_x = priv->selection->start_y = -1;
   priv->selection->end_x = priv->selection->end_y = -1;
+  sync_selection_set (body);
 
   gtk_widget_queue_draw (GTK_WIDGET (body));
 }
@@ -2131,7 +3114,8 @@ ssw_sheet_body_value_to_string (SswSheetBody *body, gint col, gint row,
   GtkTreeIter iter;
   PRIV_DECL (body);
 
-  gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL, row);
+  gtk_tree_model_iter_nth_child (priv->data_model, &iter, NULL,
+                                 model_row (body, row));
 
   append_value_to_string (body, &iter, col, row, output);
 }
@@ -2145,19 +3129,26 @@ static void text_editing_started (GtkCellRenderer *cell,
                                   gpointer         data);
 
 
+/* The renderer which the renderer function chooses for the cell MCOL,
+   MROW of the data model, or NULL if it chooses the default */
 static GtkCellRenderer *
-choose_renderer (SswSheetBody *body, gint col, gint row)
+lookup_renderer (SswSheetBody *body, gint mcol, gint mrow)
 {
   PRIV_DECL (body);
 
-  GtkCellRenderer *r = NULL;
+  if (priv->renderer_func == NULL)
+    return NULL;
 
-  if (priv->renderer_func)
-    {
-      GType t = gtk_tree_model_get_column_type (priv->data_model, col);
-      r = priv->renderer_func (priv->sheet, col, row, t,
-                               priv->sheet->renderer_func_datum);
-    }
+  GType t = gtk_tree_model_get_column_type (priv->data_model, mcol);
+  return priv->renderer_func (priv->sheet, mcol, mrow, t,
+                              priv->sheet->renderer_func_datum);
+}
+
+/* Make R, or the default renderer if R is NULL, ready for use */
+static GtkCellRenderer *
+prepare_renderer (SswSheetBody *body, GtkCellRenderer *r)
+{
+  PRIV_DECL (body);
 
   if (r == NULL)
     r = priv->default_renderer;
@@ -2180,6 +3171,59 @@ choose_renderer (SswSheetBody *body, gint col, gint row)
   return r;
 }
 
+static GtkCellRenderer *
+choose_renderer (SswSheetBody *body, gint col, gint row)
+{
+  return prepare_renderer (body, lookup_renderer (body, model_col (body, col),
+                                                  model_row (body, row)));
+}
+
+/* Find the renderer for the cell MCOL, MROW of the data model, whose
+   row is at ITER, and the text it should display, which the caller
+   must free.  Returns FALSE if the datum is not yet available.  Both
+   are kept in the sheet's render cache, so that the panes of a split
+   sheet share them.  */
+static gboolean
+resolve_cell (SswSheetBody *body, gint mcol, gint mrow, GtkTreeIter *iter,
+              GtkCellRenderer **renderer, gchar **text)
+{
+  PRIV_DECL (body);
+  struct ssw_render_cache *cache = priv->sheet ? priv->sheet->render_cache : NULL;
+  const gchar *cached_text;
+  GtkCellRenderer *r;
+
+  if (cache && ssw_render_cache_lookup (cache, mcol, mrow, &r, &cached_text))
+    {
+      *renderer = prepare_renderer (body, r);
+      *text = g_strdup (cached_text);
+      return TRUE;
+    }
+
+  r = lookup_renderer (body, mcol, mrow);
+  *renderer = prepare_renderer (body, r);
+  *text = NULL;
+
+  if (GTK_IS_CELL_RENDERER_TEXT (*renderer))
+    {
+      GValue value = G_VALUE_INIT;
+      gtk_tree_model_get_value (priv->data_model, iter, mcol, &value);
+      if (SSW_VALUE_HOLDS_PENDING (&value))
+        {
+          /* Not cached, since the datum is still to come */
+          g_value_unset (&value);
+          return FALSE;
+        }
+
+      *text = priv->cf (priv->sheet, priv->data_model, mcol, mrow, &value);
+      g_value_unset (&value);
+    }
+
+  if (cache)
+    ssw_render_cache_insert (cache, mcol, mrow, r, *text);
+
+  return TRUE;
+}
+
 static void
 on_editing_done (GtkCellEditable *e, SswSheetBody *body)
 {
@@ -2188,6 +3232,10 @@ on_editing_done (GtkCellEditable *e, SswSheetBody *body)
   gint row = -1, col = -1;
   get_active_cell (body, &col, &row);
 
+  /* Everything from here on concerns the data model */
+  col = model_col (body, col);
+  row = model_row (body, row);
+
   gboolean cell_value_unchanged = -1;
   g_object_get (e, "editing-canceled", &cell_value_unchanged, NULL);
 
@@ -2264,6 +3312,7 @@ on_remove_widget (GtkCellEditable *e, gpointer ud)
   gtk_widget_destroy (GTK_WIDGET (e));
   priv->editor = NULL;
   gtk_widget_hide (priv->active_cell_holder);
+  set_cursor_editing (body, FALSE);
 }
 
 static void
@@ -2332,6 +3381,7 @@ text_editing_started (GtkCellRenderer *cell,
     return;
 
   priv->editor = GTK_WIDGET (editable);
+  set_cursor_editing (body, TRUE);
 
 #if GTK_CHECK_VERSION (3, 22, 20)
   /* Don't show the stupid "Insert Emoji" in the popup menu.  */
@@ -2367,10 +3417,10 @@ text_editing_started (GtkCellRenderer *cell,
   GtkTreeIter iter;
   GValue value = G_VALUE_INIT;
   if (gtk_tree_model_iter_nth_child (priv->data_model,
-                                     &iter, NULL, row))
+                                     &iter, NULL, model_row (body, row)))
     {
       gtk_tree_model_get_value (priv->data_model, &iter,
-                                col, &value);
+                                model_col (body, col), &value);
     }
 
   if (GTK_IS_ENTRY (editable))
@@ -2407,6 +3457,8 @@ text_editing_started (GtkCellRenderer *cell,
     }
 
   gtk_widget_show_all (priv->active_cell_holder);
+  if (cell_obscured (body, col, row))
+    gtk_widget_hide (priv->active_cell_holder);
 }
 
 gboolean
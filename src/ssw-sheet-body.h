@@ -38,6 +38,9 @@ GtkWidget * ssw_sheet_body_new (SswSheet *sheet);
 
 void ssw_sheet_body_set_clip (SswSheetBody *body, GtkClipboard *clip);
 
+/* Abandon the large copies which are being serialized from BODY */
+void ssw_sheet_body_cancel_clip (SswSheetBody *body);
+
 void ssw_sheet_body_unset_selection (SswSheetBody *body);
 
 void ssw_sheet_body_value_to_string (SswSheetBody *body, gint col, gint row,
@@ -46,6 +49,10 @@ void ssw_sheet_body_value_to_string (SswSheetBody *body, gint col, gint row,
 void ssw_sheet_body_set_active_cell (SswSheetBody *body,
                                      gint col, gint row, GdkEvent *e);
 
+/* Make COL, ROW the active cell and the selection, scrolling it into
+   view if necessary */
+void ssw_sheet_body_goto_cell (SswSheetBody *body, gint col, gint row);
+
 gboolean ssw_sheet_body_get_active_cell (SswSheetBody *body,
                                          gint *col, gint *row);
 
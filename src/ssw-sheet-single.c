@@ -22,6 +22,7 @@
 #include "ssw-sheet-body.h"
 #include "ssw-axis-model.h"
 #include "ssw-cell.h"
+#include "ssw-cell-cache.h"
 
 #define P_(X) (X)
 
@@ -30,16 +31,29 @@ __ref_at (AtkTable      *table,
           gint          row,
           gint          column)
 {
-  SswSheetBody *body = SSW_SHEET_BODY (SSW_SHEET_SINGLE (table)->body);
+  SswSheetSingle *single = SSW_SHEET_SINGLE (table);
+  SswSheet *sheet = SSW_SHEET (single->sheet);
+  SswSheetBody *body = SSW_SHEET_BODY (single->body);
+
+  /* The cache is keyed by the cell's place in the data model, so that
+     it survives the sorting of rows and columns */
+  gint mrow = ssw_sheet_get_model_row (sheet, row);
+  gint mcol = ssw_sheet_get_model_column (sheet, column);
+
+  AtkObject *o = ssw_cell_cache_lookup (sheet->cell_cache, mcol, mrow);
+  if (o)
+    return g_object_ref (o);
+
   GString *output = g_string_new (NULL);
 
   ssw_sheet_body_value_to_string (body, column, row, output);
 
-  AtkObject *o = g_object_new (SSW_TYPE_CELL,
-                               "content", output->str,
-                               NULL);
+  /* The cell takes the string */
+  o = g_object_new (SSW_TYPE_CELL,
+                    "content", g_string_free (output, FALSE),
+                    NULL);
 
-  g_string_free (output, FALSE);
+  ssw_cell_cache_insert (sheet->cell_cache, mcol, mrow, o);
 
   return o;
 }
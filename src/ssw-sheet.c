@@ -17,6 +17,7 @@
 */
 
 #include <config.h>
+#include <string.h>
 #include "ssw-sheet.h"
 
 #include "ssw-sheet-single.h"
@@ -26,6 +27,15 @@
 #include "ssw-marshaller.h"
 #include "ssw-xpaned.h"
 #include "ssw-paste.h"
+#include "ssw-sort-model.h"
+#include "ssw-permutation.h"
+#include "ssw-selection.h"
+#include "ssw-aggregate.h"
+#include "ssw-occupancy.h"
+#include "ssw-find.h"
+#include "ssw-journal.h"
+#include "ssw-render-cache.h"
+#include "ssw-cell-cache.h"
 
 #define P_(X) (X)
 
@@ -33,6 +43,14 @@ G_DEFINE_TYPE (SswSheet, ssw_sheet, GTK_TYPE_BIN)
 
 #define DIM 2
 
+/* The number of horizontal (and of vertical) axes which have been
+   created */
+static inline gint
+n_axes (const SswSheet *sheet)
+{
+  return sheet->n_panes > 1 ? DIM : 1;
+}
+
   enum  {ROW_HEADER_CLICKED,
          ROW_HEADER_DOUBLE_CLICKED,
          COLUMN_HEADER_CLICKED,
@@ -42,9 +60,18 @@ G_DEFINE_TYPE (SswSheet, ssw_sheet, GTK_TYPE_BIN)
          COLUMN_HEADER_PRESSED,
          COLUMN_HEADER_RELEASED,
          SELECTION_CHANGED,
+         SELECTION_SET_CHANGED,
+         AGGREGATES_READY,
+         CURSOR_CHANGED,
+         FIND_MATCHES,
+         FIND_DONE,
          VALUE_CHANGED,
          ROW_MOVED,
          COLUMN_MOVED,
+         CLIP_PROGRESS,
+         CLIP_SIZE_EXCEEDED,
+         PASTE_PROGRESS,
+         HISTORY_CHANGED,
          n_SIGNALS};
 
 static guint signals [n_SIGNALS];
@@ -97,7 +124,14 @@ enum
    PROP_RENDERER_FUNC,
    PROP_RENDERER_FUNC_DATUM,
    PROP_CONVERT_FWD_FUNC,
-   PROP_CONVERT_REV_FUNC
+   PROP_CONVERT_REV_FUNC,
+   PROP_REORDER_IN_VIEW,
+   PROP_CLIP_SIZE_LIMIT,
+   PROP_COMPUTE_AGGREGATES,
+   PROP_UNDO_LIMIT,
+   PROP_FROZEN_ROWS,
+   PROP_FROZEN_COLUMNS,
+   PROP_THREAD_SAFE_CONVERSION
   };
 
 static void
@@ -154,6 +188,23 @@ on_header_double_clicked (SswSheetAxis *axis, gint which, guint state, gpointer
     g_signal_emit (sheet, signals [COLUMN_HEADER_DOUBLE_CLICKED], 0, which);
   else
     g_signal_emit (sheet, signals [ROW_HEADER_DOUBLE_CLICKED], 0, which);
+
+  /* Sort models are sorted by the column whose header was double
+     clicked.  A second double click reverses the order.  */
+  if (o == GTK_ORIENTATION_HORIZONTAL && SSW_IS_SORT_MODEL (sheet->data_model))
+    {
+      SswSortModel *sm = SSW_SORT_MODEL (sheet->data_model);
+      gint column = ssw_sheet_get_model_column (sheet, which);
+      GtkSortType order =
+        (sm->sort_column == column && sm->sort_order == GTK_SORT_ASCENDING)
+        ? GTK_SORT_DESCENDING : GTK_SORT_ASCENDING;
+
+      ssw_sheet_wait_push (sheet);
+      /* Any rows reordered by the user are superseded by the sort */
+      ssw_permutation_reset (sheet->row_order);
+      ssw_sort_model_sort (sm, column, order);
+      ssw_sheet_wait_pop (sheet);
+    }
 }
 
 
@@ -162,7 +213,7 @@ arrange (SswSheet *sheet)
 {
   gint i;
 
-  for (i = 0; i < DIM; ++i)
+  for (i = 0; i < n_axes (sheet); ++i)
     {
       if (sheet->vmodel)
         ssw_sheet_axis_set_model (SSW_SHEET_AXIS (sheet->vertical_axis[i]),
@@ -180,6 +231,17 @@ __finalize (GObject *obj)
   SswSheet *sheet = SSW_SHEET (obj);
 
   g_free (sheet->selection);
+  ssw_selection_free (sheet->selection_set);
+  ssw_aggregator_free (sheet->aggregator);
+  ssw_occupancy_free (sheet->occupancy);
+  ssw_finder_free (sheet->finder);
+  ssw_journal_free (sheet->journal);
+  ssw_render_cache_free (sheet->render_cache);
+  ssw_cell_cache_free (sheet->cell_cache);
+  ssw_permutation_free (sheet->row_order);
+  ssw_permutation_free (sheet->column_order);
+  g_object_unref (sheet->horizontal_geometry);
+  g_object_unref (sheet->vertical_geometry);
 
   G_OBJECT_CLASS (ssw_sheet_parent_class)->finalize (obj);
 }
@@ -192,6 +254,13 @@ __dispose (GObject *object)
   if (sheet->dispose_has_run)
     return;
 
+  /* The widget is going away, so the paste is abandoned rather than
+     written to the model */
+  if (sheet->paste)
+    drop_paste (sheet->paste);
+  ssw_aggregator_cancel (sheet->aggregator);
+  ssw_finder_cancel (sheet->finder);
+
   if (sheet->vmodel)
     g_object_unref (sheet->vmodel);
 
@@ -204,6 +273,154 @@ __dispose (GObject *object)
 }
 
 
+/* Begin computing the statistics of the selection, if wanted */
+static void
+update_aggregates (SswSheet *sheet)
+{
+  if (sheet->compute_aggregates && sheet->data_model)
+    ssw_aggregator_start (sheet->aggregator, sheet->selection_set);
+  else
+    ssw_aggregator_cancel (sheet->aggregator);
+}
+
+/* Forget the statistics of cells whose values have changed */
+static void
+invalidate_aggregates (GtkTreeModel *tm, guint posn, guint rm, guint add,
+                       SswSheet *sheet)
+{
+  if (rm == add)
+    ssw_aggregator_invalidate (sheet->aggregator, posn, add);
+  else
+    ssw_aggregator_invalidate (sheet->aggregator, 0, -1);
+}
+
+/* Forget which cells held data, where their values have changed */
+static void
+invalidate_occupancy (GtkTreeModel *tm, guint posn, guint rm, guint add,
+                      SswSheet *sheet)
+{
+  ssw_occupancy_invalidate (sheet->occupancy, posn, rm == add ? add : -1);
+}
+
+/* Forget the text of cells whose values have changed */
+static void
+invalidate_render_cache (GtkTreeModel *tm, guint posn, guint rm, guint add,
+                         SswSheet *sheet)
+{
+  ssw_render_cache_invalidate (sheet->render_cache, posn, rm == add ? add : -1);
+}
+
+/* A GtkListStore, and other models without "items-changed", report
+   changes only with the signals of GtkTreeModel.  Forget the text and
+   accessible objects of a row which such a model reports has
+   changed.  */
+static void
+forget_changed_row (GtkTreeModel *tm, GtkTreePath *path, GtkTreeIter *iter,
+                    SswSheet *sheet)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+
+  ssw_render_cache_invalidate (sheet->render_cache, row, 1);
+  ssw_cell_cache_invalidate (sheet->cell_cache, row, 1);
+  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+}
+
+/* Forget the text and accessible objects of all cells, when such a
+   model reports that rows have been inserted or deleted, since the
+   rows after them move */
+static void
+forget_moved_rows (SswSheet *sheet)
+{
+  ssw_render_cache_invalidate (sheet->render_cache, 0, -1);
+  ssw_cell_cache_invalidate (sheet->cell_cache, 0, -1);
+  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+}
+
+/* Forget the accessible objects of cells whose values have changed */
+static void
+invalidate_cell_cache (GtkTreeModel *tm, guint posn, guint rm, guint add,
+                       SswSheet *sheet)
+{
+  ssw_cell_cache_invalidate (sheet->cell_cache, posn, rm == add ? add : -1);
+}
+
+/* Search again those rows whose data have changed */
+static void
+update_find (GtkTreeModel *tm, guint posn, guint rm, guint add,
+             SswSheet *sheet)
+{
+  ssw_finder_update (sheet->finder, posn, rm, add);
+}
+
+/* Keep the rows recorded in the history of changes in step with
+   those of the model, as rows are inserted and deleted */
+static void
+move_history_rows (GtkTreeModel *tm, guint posn, guint rm, guint add,
+                   SswSheet *sheet)
+{
+  ssw_journal_move_rows (sheet->journal, posn, rm, add);
+}
+
+static void
+history_row_inserted (GtkTreeModel *tm, GtkTreePath *path, GtkTreeIter *iter,
+                      SswSheet *sheet)
+{
+  ssw_journal_move_rows (sheet->journal, gtk_tree_path_get_indices (path)[0],
+                         0, 1);
+}
+
+static void
+history_row_deleted (GtkTreeModel *tm, GtkTreePath *path, SswSheet *sheet)
+{
+  ssw_journal_move_rows (sheet->journal, gtk_tree_path_get_indices (path)[0],
+                         1, 0);
+}
+
+/* Redisplay the headers and cells after a change of order */
+static void
+refresh_order (SswSheet *sheet)
+{
+  gint i;
+
+  ssw_occupancy_invalidate (sheet->occupancy, 0, -1);
+  ssw_finder_restart (sheet->finder);
+  update_aggregates (sheet);
+
+  for (i = 0; i < n_axes (sheet); ++i)
+    {
+      ssw_sheet_axis_reload (SSW_SHEET_AXIS (sheet->horizontal_axis[i]));
+      ssw_sheet_axis_reload (SSW_SHEET_AXIS (sheet->vertical_axis[i]));
+    }
+
+  for (i = 0; i < sheet->n_panes; ++i)
+    gtk_widget_queue_draw (SSW_SHEET_SINGLE (sheet->sheet[i])->body);
+}
+
+/* Carry the row order across rows inserted or deleted in the data
+   model, and forget any column order which no longer fits it */
+static void
+check_order (GtkTreeModel *tm, guint posn, guint rm, guint add, SswSheet *sheet)
+{
+  gboolean changed = FALSE;
+
+  if (rm != add && !ssw_permutation_is_identity (sheet->row_order))
+    {
+      ssw_permutation_shift (sheet->row_order, posn, rm, add);
+      changed = TRUE;
+    }
+
+  if (!ssw_permutation_is_identity (sheet->column_order) &&
+      ssw_permutation_get_length (sheet->column_order)
+      != gtk_tree_model_get_n_columns (tm))
+    {
+      ssw_permutation_reset (sheet->column_order);
+      changed = TRUE;
+    }
+
+  if (changed)
+    refresh_order (sheet);
+}
+
 static void
 resize_vmodel (GtkTreeModel *tm, guint posn, guint rm, guint add, GListModel *vmodel)
 {
@@ -242,7 +459,7 @@ __set_property (GObject *object,
         gtk_container_add (GTK_CONTAINER (sheet), splitter);
         gtk_widget_show (splitter);
 
-        for (i = 0; i < DIM * DIM ; ++i)
+        for (i = 0; i < sheet->n_panes; ++i)
           {
             gtk_container_add_with_properties (GTK_CONTAINER (splitter),
                                                sheet->sw[i],
@@ -256,7 +473,7 @@ __set_property (GObject *object,
       {
         gboolean lines = g_value_get_boolean (value);
 
-        for (i = 0; i < DIM * DIM ; ++i)
+        for (i = 0; i < sheet->n_panes; ++i)
           {
             g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body, "gridlines", lines, NULL);
           }
@@ -267,7 +484,7 @@ __set_property (GObject *object,
       {
         gboolean editable = g_value_get_boolean (value);
 
-        for (i = 0; i < DIM * DIM ; ++i)
+        for (i = 0; i < sheet->n_panes; ++i)
           {
             g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
                           "editable", editable,
@@ -278,17 +495,31 @@ __set_property (GObject *object,
       break;
 
     case PROP_HORIZONTAL_DRAGGABLE:
-      for (i = 0; i < DIM; ++i)
+      for (i = 0; i < n_axes (sheet); ++i)
         g_object_set (SSW_SHEET_AXIS (sheet->horizontal_axis[i]),
                       "draggable",  g_value_get_boolean (value), NULL);
       break;
 
     case PROP_VERTICAL_DRAGGABLE:
-      for (i = 0; i < DIM; ++i)
+      for (i = 0; i < n_axes (sheet); ++i)
         g_object_set (SSW_SHEET_AXIS (sheet->vertical_axis[i]),
                       "draggable",  g_value_get_boolean (value), NULL);
       break;
 
+    case PROP_FROZEN_ROWS:
+      sheet->frozen_rows = g_value_get_int (value);
+      for (i = 0; i < n_axes (sheet); ++i)
+        g_object_set (sheet->vertical_axis[i],
+                      "frozen", sheet->frozen_rows, NULL);
+      break;
+
+    case PROP_FROZEN_COLUMNS:
+      sheet->frozen_columns = g_value_get_int (value);
+      for (i = 0; i < n_axes (sheet); ++i)
+        g_object_set (sheet->horizontal_axis[i],
+                      "frozen", sheet->frozen_columns, NULL);
+      break;
+
     case PROP_SELECTION:
       {
         gpointer p = g_value_get_pointer (value);
@@ -297,10 +528,18 @@ __set_property (GObject *object,
             SswRange *r = p;
             *sheet->selection = *r;
 
-            for (i = 0; i < DIM * DIM ; ++i)
+            /* This replaces all the selected ranges */
+            ssw_selection_clear (sheet->selection_set);
+            if (r->start_x >= 0 && r->start_y >= 0)
+              ssw_selection_add (sheet->selection_set, r);
+
+            for (i = 0; i < sheet->n_panes; ++i)
               gtk_widget_queue_draw (SSW_SHEET_SINGLE (sheet->sheet[i])->body);
 
             g_signal_emit (sheet, signals [SELECTION_CHANGED], 0, sheet->selection);
+            g_signal_emit (sheet, signals [SELECTION_SET_CHANGED], 0,
+                           sheet->selection_set);
+            update_aggregates (sheet);
           }
       }
       break;
@@ -310,7 +549,7 @@ __set_property (GObject *object,
         gpointer p = g_value_get_pointer (value);
 
         if (p)
-          for (i = 0; i < DIM * DIM ; ++i)
+          for (i = 0; i < sheet->n_panes; ++i)
             {
               g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
                             "forward-conversion", p,
@@ -324,7 +563,7 @@ __set_property (GObject *object,
         gpointer p = g_value_get_pointer (value);
 
         if (p)
-          for (i = 0; i < DIM * DIM ; ++i)
+          for (i = 0; i < sheet->n_panes; ++i)
             {
               g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
                             "reverse-conversion", p,
@@ -337,7 +576,7 @@ __set_property (GObject *object,
       {
         gpointer select_renderer_func = g_value_get_pointer (value);
 
-        for (i = 0; i < DIM * DIM ; ++i)
+        for (i = 0; i < sheet->n_panes; ++i)
           {
             g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
                           "select-renderer-func", select_renderer_func,
@@ -349,13 +588,41 @@ __set_property (GObject *object,
 
     case PROP_RENDERER_FUNC_DATUM:
       sheet->renderer_func_datum = g_value_get_pointer (value);
+      ssw_render_cache_invalidate (sheet->render_cache, 0, -1);
+      break;
+
+    case PROP_REORDER_IN_VIEW:
+      sheet->reorder_in_view = g_value_get_boolean (value);
+      if (!sheet->reorder_in_view)
+        ssw_sheet_reset_order (sheet);
+      break;
+
+    case PROP_CLIP_SIZE_LIMIT:
+      sheet->clip_size_limit = g_value_get_int64 (value);
+      break;
+
+    case PROP_COMPUTE_AGGREGATES:
+      sheet->compute_aggregates = g_value_get_boolean (value);
+      update_aggregates (sheet);
+      break;
+
+    case PROP_THREAD_SAFE_CONVERSION:
+      sheet->thread_safe_conversion = g_value_get_boolean (value);
+      break;
+
+    case PROP_UNDO_LIMIT:
+      sheet->undo_limit = g_value_get_int64 (value);
+      ssw_journal_set_limit (sheet->journal, sheet->undo_limit);
       break;
 
     case PROP_SPLIT:
       {
         gboolean split = g_value_get_boolean (value);
 
-        for (i = 0; i < DIM * DIM ; ++i)
+        if (split)
+          create_split_panes (sheet);
+
+        for (i = 0; i < sheet->n_panes; ++i)
           {
             g_object_set (sheet->sw[i], "no-show-all", !split, NULL);
             gtk_widget_set_visible (sheet->sw[i], split);
@@ -417,12 +684,62 @@ __set_property (GObject *object,
                                    G_CALLBACK (resize_hmodel), sheet->hmodel, 0);
         }
 
+      ssw_permutation_reset (sheet->row_order);
+      ssw_permutation_reset (sheet->column_order);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (check_order), sheet, 0);
+
+      ssw_aggregator_invalidate (sheet->aggregator, 0, -1);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (invalidate_aggregates), sheet, 0);
+
+      ssw_occupancy_invalidate (sheet->occupancy, 0, -1);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (invalidate_occupancy), sheet, 0);
+
+      ssw_render_cache_invalidate (sheet->render_cache, 0, -1);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (invalidate_render_cache), sheet, 0);
+      g_signal_connect_object (sheet->data_model, "row-changed",
+                               G_CALLBACK (forget_changed_row), sheet, 0);
+      g_signal_connect_object (sheet->data_model, "row-inserted",
+                               G_CALLBACK (forget_moved_rows), sheet,
+                               G_CONNECT_SWAPPED);
+      g_signal_connect_object (sheet->data_model, "row-deleted",
+                               G_CALLBACK (forget_moved_rows), sheet,
+                               G_CONNECT_SWAPPED);
+
+      ssw_cell_cache_invalidate (sheet->cell_cache, 0, -1);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (invalidate_cell_cache), sheet, 0);
+
+      ssw_finder_cancel (sheet->finder);
+      g_signal_connect_object (sheet->data_model, "items-changed",
+                               G_CALLBACK (update_find), sheet, 0);
+
+      ssw_journal_clear (sheet->journal);
+
+      /* A model which has "items-changed" reports the insertion and
+         deletion of rows there, and perhaps also with the signals of
+         GtkTreeModel.  Moving the rows twice would be wrong.  */
+      if (g_signal_lookup ("items-changed", G_OBJECT_TYPE (sheet->data_model)))
+        g_signal_connect_object (sheet->data_model, "items-changed",
+                                 G_CALLBACK (move_history_rows), sheet, 0);
+      else
+        {
+          g_signal_connect_object (sheet->data_model, "row-inserted",
+                                   G_CALLBACK (history_row_inserted), sheet, 0);
+          g_signal_connect_object (sheet->data_model, "row-deleted",
+                                   G_CALLBACK (history_row_deleted), sheet, 0);
+        }
+
       arrange (sheet);
 
-      for (i = 0; i < DIM * DIM; ++i)
+      for (i = 0; i < sheet->n_panes; ++i)
         {
           g_object_set (sheet->sheet[i], "data-model", sheet->data_model, NULL);
         }
+      update_aggregates (sheet);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -460,6 +777,27 @@ __get_property (GObject *object,
     case PROP_RENDERER_FUNC_DATUM:
       g_value_set_pointer (value, SSW_SHEET (object)->renderer_func_datum);
       break;
+    case PROP_REORDER_IN_VIEW:
+      g_value_set_boolean (value, SSW_SHEET (object)->reorder_in_view);
+      break;
+    case PROP_CLIP_SIZE_LIMIT:
+      g_value_set_int64 (value, SSW_SHEET (object)->clip_size_limit);
+      break;
+    case PROP_COMPUTE_AGGREGATES:
+      g_value_set_boolean (value, SSW_SHEET (object)->compute_aggregates);
+      break;
+    case PROP_UNDO_LIMIT:
+      g_value_set_int64 (value, SSW_SHEET (object)->undo_limit);
+      break;
+    case PROP_FROZEN_ROWS:
+      g_value_set_int (value, SSW_SHEET (object)->frozen_rows);
+      break;
+    case PROP_FROZEN_COLUMNS:
+      g_value_set_int (value, SSW_SHEET (object)->frozen_columns);
+      break;
+    case PROP_THREAD_SAFE_CONVERSION:
+      g_value_set_boolean (value, SSW_SHEET (object)->thread_safe_conversion);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -567,6 +905,55 @@ ssw_sheet_class_init (SswSheetClass *class)
                           P_("The Datum to be passed to the \"select-renderer-func\" property"),
                           G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
 
+  GParamSpec *reorder_in_view_spec =
+    g_param_spec_boolean ("reorder-in-view",
+                          P_("Reorder in View"),
+                          P_("If TRUE, dragging rows and columns reorders them in the view only, without changing the data model"),
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *clip_size_limit_spec =
+    g_param_spec_int64 ("clip-size-limit",
+                        P_("Clip Size Limit"),
+                        P_("The size in bytes above which a copy must be approved by a handler of the \"clip-size-exceeded\" signal.  Zero means no limit"),
+                        0, G_MAXINT64, 0,
+                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *compute_aggregates_spec =
+    g_param_spec_boolean ("compute-aggregates",
+                          P_("Compute Aggregates"),
+                          P_("If TRUE, the count, sum, mean, minimum and maximum of the numbers in the selection are computed whenever it changes, and the \"aggregates-ready\" signal is emitted"),
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *undo_limit_spec =
+    g_param_spec_int64 ("undo-limit",
+                        P_("Undo Limit"),
+                        P_("The size in bytes to which the history of changes which may be undone is limited.  The oldest changes are forgotten first.  Zero means that changes are not recorded"),
+                        0, G_MAXINT64, JOURNAL_DEFAULT_LIMIT,
+                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *frozen_rows_spec =
+    g_param_spec_int ("frozen-rows",
+                      P_("Frozen Rows"),
+                      P_("The number of rows at the top of the sheet which remain in place when it is scrolled"),
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *frozen_columns_spec =
+    g_param_spec_int ("frozen-columns",
+                      P_("Frozen Columns"),
+                      P_("The number of columns at the start of the sheet which remain in place when it is scrolled"),
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
+  GParamSpec *thread_safe_conversion_spec =
+    g_param_spec_boolean ("thread-safe-conversion",
+                          P_("Thread Safe Conversion"),
+                          P_("If TRUE, the forward conversion function may be called from several threads at once, when the data model may be read by several threads"),
+                          FALSE,
+                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT);
+
   object_class->set_property = __set_property;
   object_class->get_property = __get_property;
   object_class->dispose = __dispose;
@@ -630,6 +1017,34 @@ ssw_sheet_class_init (SswSheetClass *class)
                                    PROP_VERTICAL_DRAGGABLE,
                                    vertical_draggable_spec);
 
+  g_object_class_install_property (object_class,
+                                   PROP_REORDER_IN_VIEW,
+                                   reorder_in_view_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_CLIP_SIZE_LIMIT,
+                                   clip_size_limit_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_COMPUTE_AGGREGATES,
+                                   compute_aggregates_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_UNDO_LIMIT,
+                                   undo_limit_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_FROZEN_ROWS,
+                                   frozen_rows_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_FROZEN_COLUMNS,
+                                   frozen_columns_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_THREAD_SAFE_CONVERSION,
+                                   thread_safe_conversion_spec);
+
   signals [ROW_HEADER_CLICKED] =
     g_signal_new ("row-header-clicked",
                   G_TYPE_FROM_CLASS (class),
@@ -739,6 +1154,64 @@ ssw_sheet_class_init (SswSheetClass *class)
                   1,
                   G_TYPE_POINTER);
 
+  /* Emitted when any of the selected ranges changes.  The argument
+     is the SswSelection holding all of them.  */
+  signals [SELECTION_SET_CHANGED] =
+    g_signal_new ("selection-set-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__POINTER,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_POINTER);
+
+  signals [FIND_MATCHES] =
+    g_signal_new ("find-matches",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  ssw_cclosure_marshal_VOID__INT_INT,
+                  G_TYPE_NONE,
+                  2,
+                  G_TYPE_INT,
+                  G_TYPE_INT);
+
+  signals [FIND_DONE] =
+    g_signal_new ("find-done",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__INT,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_INT);
+
+  signals [CURSOR_CHANGED] =
+    g_signal_new ("cursor-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__POINTER,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_POINTER);
+
+  signals [AGGREGATES_READY] =
+    g_signal_new ("aggregates-ready",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__POINTER,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_POINTER);
+
 
   signals [VALUE_CHANGED] =
     g_signal_new ("value-changed",
@@ -776,6 +1249,59 @@ ssw_sheet_class_init (SswSheetClass *class)
                   2,
                   G_TYPE_INT,
                   G_TYPE_INT);
+
+  /* Emitted periodically whilst a large copy is serialized, from an
+     idle handler.  The argument is the fraction completed.  The
+     clipboard is claimed only once the copy is complete, and a copy
+     may be abandoned meanwhile with ssw_sheet_cancel_clip.  */
+  signals [CLIP_PROGRESS] =
+    g_signal_new ("clip-progress",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__DOUBLE,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_DOUBLE);
+
+  /* Emitted when a copy is estimated to exceed "clip-size-limit"
+     bytes.  The argument is the estimate.  A handler returning TRUE
+     allows the copy to go ahead.  */
+  signals [CLIP_SIZE_EXCEEDED] =
+    g_signal_new ("clip-size-exceeded",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL,
+                  ssw_cclosure_marshal_BOOLEAN__INT64,
+                  G_TYPE_BOOLEAN,
+                  1,
+                  G_TYPE_INT64);
+
+  /* Emitted as pasted data is processed.  The argument is the
+     fraction completed.  */
+  signals [PASTE_PROGRESS] =
+    g_signal_new ("paste-progress",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__DOUBLE,
+                  G_TYPE_NONE,
+                  1,
+                  G_TYPE_DOUBLE);
+
+  /* Emitted when the changes which may be undone or redone change */
+  signals [HISTORY_CHANGED] =
+    g_signal_new ("history-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE,
+                  0);
 }
 
 static void
@@ -787,12 +1313,40 @@ forward_signal (SswSheet *sheet, ...)
   va_end (ap);
 }
 
+/* Record an edited cell's value, before the handlers of the sheet's
+   "value-changed" signal store it */
+static void
+record_edit (SswSheetBody *body, gint col, gint row, const GValue *value,
+             SswSheet *sheet)
+{
+  ssw_journal_record_cells (sheet->journal, col, row, 1, 1, value, NULL, NULL);
+}
+
+/* Forget the text and the accessible object of an edited cell, once
+   the handlers of the sheet's "value-changed" signal have stored its
+   value.  Not every data model reports such a change.  */
+static void
+forget_edited_cell (SswSheetBody *body, gint col, gint row,
+                    const GValue *value, SswSheet *sheet)
+{
+  ssw_render_cache_invalidate (sheet->render_cache, row, 1);
+  ssw_cell_cache_invalidate (sheet->cell_cache, row, 1);
+  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+}
+
+static void
+record_resize (SswSheetAxis *axis, gint pos, gint old_size, gint new_size,
+               SswSheet *sheet)
+{
+  ssw_journal_record_resize (sheet->journal, axis, pos, old_size, new_size);
+}
+
 static void
 forward_selection_signal (SswSheet *sheet, SswRange *sel, gpointer ud)
 {
   gint i;
 
-  for (i = 0; i < DIM * DIM ; ++i)
+  for (i = 0; i < sheet->n_panes; ++i)
     {
       GtkWidget *body = SSW_SHEET_SINGLE (sheet->sheet[i])->body;
       if (body == ud)
@@ -801,6 +1355,9 @@ forward_selection_signal (SswSheet *sheet, SswRange *sel, gpointer ud)
       gtk_widget_queue_draw (body);
     }
   g_signal_emit (sheet, signals [SELECTION_CHANGED], 0, sel);
+  g_signal_emit (sheet, signals [SELECTION_SET_CHANGED], 0,
+                 sheet->selection_set);
+  update_aggregates (sheet);
 }
 
 static void
@@ -809,107 +1366,224 @@ on_drag_n_drop (SswSheet *sheet, gint from, gint to, GtkOrientable *axis)
   if (to - from == 1 || to == from) /* This is a null move */
     return;
 
-  if (gtk_orientable_get_orientation (axis) == GTK_ORIENTATION_HORIZONTAL)
+  gboolean horizontal =
+    (gtk_orientable_get_orientation (axis) == GTK_ORIENTATION_HORIZONTAL);
+
+  if (sheet->reorder_in_view)
+    {
+      GtkWidget *axis0 = horizontal ? sheet->horizontal_axis[0] : sheet->vertical_axis[0];
+      gint n = ssw_sheet_axis_get_size (SSW_SHEET_AXIS (axis0));
+
+      ssw_permutation_move (horizontal ? sheet->column_order : sheet->row_order,
+                            n, from, to);
+      refresh_order (sheet);
+    }
+
+  if (horizontal)
     g_signal_emit (sheet, signals [COLUMN_MOVED], 0, from, to);
   else
     g_signal_emit (sheet, signals [ROW_MOVED], 0, from, to);
 }
 
-static void
-ssw_sheet_init (SswSheet *sheet)
+static guint
+map_row (guint index, gpointer data)
 {
-  gtk_widget_set_has_window (GTK_WIDGET (sheet), FALSE);
-  sheet->vmodel = g_object_new (SSW_TYPE_AXIS_MODEL, NULL);
-  sheet->hmodel = g_object_new (SSW_TYPE_AXIS_MODEL, NULL);
-
-  gint i;
-  for (i = 0; i < DIM; ++i)
-    {
-      sheet->vadj[i] = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
-      sheet->hadj[i] = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
-
-      sheet->horizontal_axis[i] =
-        ssw_sheet_axis_new (GTK_ORIENTATION_HORIZONTAL);
-
+  return ssw_sheet_get_model_row (SSW_SHEET (data), index);
+}
 
-      g_signal_connect (sheet->horizontal_axis[i], "header-clicked",
-                        G_CALLBACK (on_header_clicked), sheet);
+static guint
+map_column (guint index, gpointer data)
+{
+  return ssw_sheet_get_model_column (SSW_SHEET (data), index);
+}
 
-      g_signal_connect (sheet->horizontal_axis[i], "header-double-clicked",
-                        G_CALLBACK (on_header_double_clicked), sheet);
+/* Create the Ith horizontal and vertical axes, and their adjustments */
+static void
+create_axes (SswSheet *sheet, gint i)
+{
+  sheet->vadj[i] = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
+  sheet->hadj[i] = gtk_adjustment_new (0, 0, 0, 0, 0, 0);
 
-      g_signal_connect (sheet->horizontal_axis[i], "header-button-pressed",
-                        G_CALLBACK (on_header_button_pressed), sheet);
+  sheet->horizontal_axis[i] =
+    ssw_sheet_axis_new (GTK_ORIENTATION_HORIZONTAL);
 
-      g_signal_connect (sheet->horizontal_axis[i], "header-button-released",
-                        G_CALLBACK (on_header_button_released), sheet);
+  sheet->vertical_axis[i] =
+    ssw_sheet_axis_new (GTK_ORIENTATION_VERTICAL);
 
-      sheet->vertical_axis[i] =
-        ssw_sheet_axis_new (GTK_ORIENTATION_VERTICAL);
+  ssw_sheet_axis_set_geometry (SSW_SHEET_AXIS (sheet->horizontal_axis[i]),
+                               sheet->horizontal_geometry);
+  ssw_sheet_axis_set_geometry (SSW_SHEET_AXIS (sheet->vertical_axis[i]),
+                               sheet->vertical_geometry);
 
-      g_signal_connect (sheet->vertical_axis[i], "header-clicked",
+  GtkWidget *axes[2] = {sheet->horizontal_axis[i], sheet->vertical_axis[i]};
+  gint a;
+  for (a = 0; a < 2; ++a)
+    {
+      g_signal_connect (axes[a], "header-clicked",
                         G_CALLBACK (on_header_clicked), sheet);
 
-      g_signal_connect (sheet->vertical_axis[i], "header-double-clicked",
+      g_signal_connect (axes[a], "header-double-clicked",
                         G_CALLBACK (on_header_double_clicked), sheet);
 
-      g_signal_connect (sheet->vertical_axis[i], "header-button-pressed",
+      g_signal_connect (axes[a], "header-button-pressed",
                         G_CALLBACK (on_header_button_pressed), sheet);
 
-      g_signal_connect (sheet->vertical_axis[i], "header-button-released",
+      g_signal_connect (axes[a], "header-button-released",
                         G_CALLBACK (on_header_button_released), sheet);
-    }
-
-  sheet->selection = g_malloc (sizeof *sheet->selection);
-  sheet->selection->start_x = -1;
-  sheet->selection->start_y = -1;
-  sheet->selection->end_x = -1;
-  sheet->selection->end_y = -1;
 
-  for (i = 0; i < DIM ; ++i)
-    {
-      g_signal_connect_swapped (sheet->horizontal_axis[i], "drag-n-dropped",
-                                G_CALLBACK (on_drag_n_drop), sheet);
+      g_signal_connect (axes[a], "size-overridden",
+                        G_CALLBACK (record_resize), sheet);
 
-      g_signal_connect_swapped (sheet->vertical_axis[i], "drag-n-dropped",
+      g_signal_connect_swapped (axes[a], "drag-n-dropped",
                                 G_CALLBACK (on_drag_n_drop), sheet);
     }
 
-  for (i = 0; i < DIM * DIM ; ++i)
-    {
-      sheet->sw[i] = gtk_scrolled_window_new (sheet->hadj[i%DIM],
-                                              sheet->vadj[i/DIM]);
+  ssw_sheet_axis_set_index_map (SSW_SHEET_AXIS (sheet->horizontal_axis[i]),
+                                map_column, sheet);
+  ssw_sheet_axis_set_index_map (SSW_SHEET_AXIS (sheet->vertical_axis[i]),
+                                map_row, sheet);
+}
 
-      g_object_set (sheet->sw[i], "shadow-type", GTK_SHADOW_IN, NULL);
+/* Create the Ith pane, and the scrolled window which holds it */
+static void
+create_pane (SswSheet *sheet, gint i)
+{
+  sheet->sw[i] = gtk_scrolled_window_new (sheet->hadj[i%DIM],
+                                          sheet->vadj[i/DIM]);
 
-      sheet->sheet[i] =
-        ssw_sheet_single_new (sheet,
-                              SSW_SHEET_AXIS (sheet->horizontal_axis[i%DIM]),
-                              SSW_SHEET_AXIS (sheet->vertical_axis[i/DIM]),
-                              sheet->selection);
+  g_object_set (sheet->sw[i], "shadow-type", GTK_SHADOW_IN, NULL);
 
-      gtk_widget_show_all (sheet->sheet[i]);
+  sheet->sheet[i] =
+    ssw_sheet_single_new (sheet,
+                          SSW_SHEET_AXIS (sheet->horizontal_axis[i%DIM]),
+                          SSW_SHEET_AXIS (sheet->vertical_axis[i/DIM]),
+                          sheet->selection);
 
-      gtk_container_add (GTK_CONTAINER (sheet->sw[i]), sheet->sheet[i]);
+  gtk_widget_show_all (sheet->sheet[i]);
 
-      g_signal_connect_swapped (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
-                                "selection-changed", G_CALLBACK (forward_selection_signal), sheet);
+  gtk_container_add (GTK_CONTAINER (sheet->sw[i]), sheet->sheet[i]);
 
-      g_signal_connect_swapped (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
-                                "value-changed", G_CALLBACK (forward_signal), sheet);
-    }
+  g_signal_connect_swapped (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                            "selection-changed", G_CALLBACK (forward_selection_signal), sheet);
 
-  sheet->renderer_func_datum = NULL;
-  sheet->dispose_has_run = FALSE;
-  sheet->selected_body = SSW_SHEET_SINGLE (sheet->sheet[0])->body;
+  g_signal_connect (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                    "value-changed", G_CALLBACK (record_edit), sheet);
 
-  arrange (sheet);
+  g_signal_connect_swapped (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                            "value-changed", G_CALLBACK (forward_signal), sheet);
 
-  sheet->cursor_stack = NULL;
+  g_signal_connect (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                    "value-changed", G_CALLBACK (forget_edited_cell), sheet);
 }
 
-void
-ssw_sheet_set_clip (SswSheet *sheet, GtkClipboard *clip)
+/* Create the panes, axes and adjustments which only a split sheet
+   uses, and make them match the first pane and its axes */
+static void
+create_split_panes (SswSheet *sheet)
+{
+  gint i;
+
+  if (sheet->n_panes > 1)
+    return;
+
+  create_axes (sheet, 1);
+
+  gboolean hdrag, vdrag;
+  g_object_get (sheet->horizontal_axis[0], "draggable", &hdrag, NULL);
+  g_object_get (sheet->vertical_axis[0], "draggable", &vdrag, NULL);
+  g_object_set (sheet->horizontal_axis[1], "draggable", hdrag,
+                "frozen", sheet->frozen_columns, NULL);
+  g_object_set (sheet->vertical_axis[1], "draggable", vdrag,
+                "frozen", sheet->frozen_rows, NULL);
+
+  gpointer rf, fwd, rev;
+  g_object_get (SSW_SHEET_SINGLE (sheet->sheet[0])->body,
+                "select-renderer-func", &rf,
+                "forward-conversion", &fwd,
+                "reverse-conversion", &rev,
+                NULL);
+
+  GtkWidget *splitter = gtk_bin_get_child (GTK_BIN (sheet));
+
+  for (i = 1; i < DIM * DIM; ++i)
+    {
+      create_pane (sheet, i);
+
+      g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                    "gridlines", sheet->gridlines,
+                    "editable", sheet->editable,
+                    "select-renderer-func", rf,
+                    NULL);
+
+      /* A NULL conversion function would replace the default */
+      if (fwd)
+        g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                      "forward-conversion", fwd, NULL);
+      if (rev)
+        g_object_set (SSW_SHEET_SINGLE (sheet->sheet[i])->body,
+                      "reverse-conversion", rev, NULL);
+
+      if (sheet->data_model)
+        g_object_set (sheet->sheet[i], "data-model", sheet->data_model, NULL);
+
+      if (splitter)
+        gtk_container_add_with_properties (GTK_CONTAINER (splitter),
+                                           sheet->sw[i],
+                                           "left-attach", i%DIM,
+                                           "top-attach", i/DIM,
+                                           NULL);
+    }
+
+  sheet->n_panes = DIM * DIM;
+  arrange (sheet);
+}
+
+static void
+ssw_sheet_init (SswSheet *sheet)
+{
+  gtk_widget_set_has_window (GTK_WIDGET (sheet), FALSE);
+  sheet->vmodel = g_object_new (SSW_TYPE_AXIS_MODEL, NULL);
+  sheet->hmodel = g_object_new (SSW_TYPE_AXIS_MODEL, NULL);
+
+  sheet->row_order = ssw_permutation_new ();
+  sheet->column_order = ssw_permutation_new ();
+
+  sheet->selection = g_malloc (sizeof *sheet->selection);
+  sheet->selection->start_x = -1;
+  sheet->selection->start_y = -1;
+  sheet->selection->end_x = -1;
+  sheet->selection->end_y = -1;
+  sheet->selection_set = ssw_selection_new ();
+  sheet->aggregator = ssw_aggregator_new (sheet);
+  sheet->occupancy = ssw_occupancy_new (sheet);
+  sheet->finder = ssw_finder_new (sheet);
+  sheet->journal = ssw_journal_new (sheet);
+  sheet->render_cache = ssw_render_cache_new ();
+  sheet->cell_cache = ssw_cell_cache_new ();
+  sheet->horizontal_geometry = ssw_axis_geometry_new ();
+  sheet->vertical_geometry = ssw_axis_geometry_new ();
+
+  /* The other panes are created when the sheet is first split */
+  create_axes (sheet, 0);
+  create_pane (sheet, 0);
+  sheet->n_panes = 1;
+
+  sheet->renderer_func_datum = NULL;
+  sheet->dispose_has_run = FALSE;
+  sheet->selected_body = SSW_SHEET_SINGLE (sheet->sheet[0])->body;
+  sheet->cursor.col = -1;
+  sheet->cursor.row = -1;
+  sheet->cursor.body = NULL;
+  sheet->cursor.editing = FALSE;
+
+  arrange (sheet);
+
+  sheet->cursor_stack = NULL;
+  sheet->paste = NULL;
+}
+
+void
+ssw_sheet_set_clip (SswSheet *sheet, GtkClipboard *clip)
 {
   if (!sheet->data_model)
     return;
@@ -946,29 +1620,280 @@ ssw_sheet_get_active_cell (SswSheet *sheet,
                                          col, row);
 }
 
+
+gint
+ssw_sheet_get_model_row (SswSheet *sheet, gint row)
+{
+  return ssw_permutation_map (sheet->row_order, row);
+}
+
+gint
+ssw_sheet_get_model_column (SswSheet *sheet, gint col)
+{
+  return ssw_permutation_map (sheet->column_order, col);
+}
+
+gint *
+ssw_sheet_get_row_order (SswSheet *sheet, gint *n)
+{
+  *n = ssw_sheet_axis_get_size (SSW_SHEET_AXIS (sheet->vertical_axis[0]));
+  return ssw_permutation_export (sheet->row_order, *n);
+}
+
+gint *
+ssw_sheet_get_column_order (SswSheet *sheet, gint *n)
+{
+  *n = ssw_sheet_axis_get_size (SSW_SHEET_AXIS (sheet->horizontal_axis[0]));
+  return ssw_permutation_export (sheet->column_order, *n);
+}
+
+void
+ssw_sheet_reset_order (SswSheet *sheet)
+{
+  ssw_permutation_reset (sheet->row_order);
+  ssw_permutation_reset (sheet->column_order);
+  refresh_order (sheet);
+}
+
 
 
+/* A converted value awaiting a call to the set_cells function */
+struct pending_cell
+{
+  gint col;
+  gint row;
+  GValue value;
+};
+
+/* The number of pending cells which causes them to be written */
+#define PASTE_BATCH_CELLS 65536
+
+/* Write the N_COLS x N_ROWS block of VALUES, whose top left cell is
+   COL0, ROW0, through the set_cells function of PS, or cell by cell
+   through its set_cell function, and record it in the journal.  */
+static void
+write_block (struct paste_state *ps, gint col0, gint row0,
+             gint n_cols, gint n_rows, const GValue *values)
+{
+  SswSheet *sheet = ps->sheet;
+  gint r, c;
+
+  ssw_journal_record_cells (sheet->journal, col0, row0, n_cols, n_rows,
+                            values, ps->set_cells, ps->set_cell);
+
+  if (ps->set_cells)
+    {
+      ps->set_cells (sheet->data_model, col0, row0, n_cols, n_rows, values);
+      return;
+    }
+
+  for (r = 0; r < n_rows; ++r)
+    for (c = 0; c < n_cols; ++c)
+      {
+        const GValue *v = &values[(gsize) r * n_cols + c];
+        if (G_IS_VALUE (v))
+          ps->set_cell (sheet->data_model, col0 + c, row0 + r, v);
+      }
+}
+
+/* Write the pending cells of PS in as few calls to its set_cells
+   function as possible.  */
+static void
+flush_pending (struct paste_state *ps)
+{
+  SswSheet *sheet = ps->sheet;
+  GArray *pending = ps->pending;
+  guint i;
+
+  if (pending == NULL || pending->len == 0)
+    return;
+
+  if (!ssw_permutation_is_identity (sheet->row_order)
+      || !ssw_permutation_is_identity (sheet->column_order))
+    {
+      /* The cells are not contiguous in the model, so write them
+         individually */
+      for (i = 0; i < pending->len; ++i)
+        {
+          struct pending_cell *pc = &g_array_index (pending, struct pending_cell, i);
+          write_block (ps, pc->col, pc->row, 1, 1, &pc->value);
+          g_value_unset (&pc->value);
+        }
+      g_array_set_size (pending, 0);
+      return;
+    }
+
+  gint col0 = G_MAXINT, row0 = G_MAXINT;
+  gint col1 = -1, row1 = -1;
+  for (i = 0; i < pending->len; ++i)
+    {
+      const struct pending_cell *pc = &g_array_index (pending, struct pending_cell, i);
+      col0 = MIN (col0, pc->col);
+      row0 = MIN (row0, pc->row);
+      col1 = MAX (col1, pc->col);
+      row1 = MAX (row1, pc->row);
+    }
+
+  const gint n_cols = col1 - col0 + 1;
+  const gint n_rows = row1 - row0 + 1;
+  GValue *values = g_new0 (GValue, (gsize) n_cols * n_rows);
+
+  /* The block takes over the pending values */
+  for (i = 0; i < pending->len; ++i)
+    {
+      const struct pending_cell *pc = &g_array_index (pending, struct pending_cell, i);
+      values[(gsize) (pc->row - row0) * n_cols + pc->col - col0] = pc->value;
+    }
+  g_array_set_size (pending, 0);
+
+  write_block (ps, col0, row0, n_cols, n_rows, values);
+
+  gsize j;
+  for (j = 0; j < (gsize) n_cols * n_rows; ++j)
+    if (G_IS_VALUE (&values[j]))
+      g_value_unset (&values[j]);
+  g_free (values);
+}
+
 /* A callback function which populates the cell indicated by PS with the value
    indicated by STR and the current reverse conversion function.  */
 void
-ssw_sheet_paste_insert_datum (const gchar *str, size_t len, const struct paste_state *ps)
+ssw_sheet_paste_insert_datum (const gchar *str, size_t len, struct paste_state *ps)
 {
   SswSheet *sheet = ps->sheet;
 
   GValue value = G_VALUE_INIT;
 
-  gint col = ps->col + ps->col0;
-  gint row = ps->row + ps->row0;
+  gint col = ssw_sheet_get_model_column (sheet, ps->col + ps->col0);
+  gint row = ssw_sheet_get_model_row (sheet, ps->row + ps->row0);
 
-  ssw_sheet_reverse_conversion_func rcf;
+  if (!ps->rcf (sheet->data_model, col, row, str, &value))
+    {
+      if (G_IS_VALUE (&value))
+        g_value_unset (&value);
+      return;
+    }
 
-  g_object_get (SSW_SHEET_SINGLE (sheet->sheet[0])->body,
-                "reverse-conversion", &rcf,
-                NULL);
+  struct pending_cell pc;
+  pc.col = col;
+  pc.row = row;
+  pc.value = value;
+  g_array_append_val (ps->pending, pc);
+
+  if (ps->pending->len >= PASTE_BATCH_CELLS)
+    flush_pending (ps);
+}
+
+/* Stop the paste PS and free it, discarding any cells which have not
+   yet been written */
+static void
+drop_paste (struct paste_state *ps)
+{
+  SswSheet *sheet = ps->sheet;
+  guint i;
+
+  if (ps->idle_id)
+    g_source_remove (ps->idle_id);
+
+  if (ps->parser && ps->parser_destroy)
+    ps->parser_destroy (ps->parser);
+
+  if (ps->pending)
+    {
+      for (i = 0; i < ps->pending->len; ++i)
+        g_value_unset (&g_array_index (ps->pending, struct pending_cell, i).value);
+      g_array_free (ps->pending, TRUE);
+    }
+
+  g_free (ps->data);
+
+  if (sheet->paste == ps)
+    {
+      sheet->paste = NULL;
+      ssw_journal_end (sheet->journal);
+      ssw_sheet_wait_pop (sheet);
+    }
+
+  g_free (ps);
+}
+
+void
+ssw_sheet_paste_finish (struct paste_state *ps)
+{
+  SswSheet *sheet = ps->sheet;
+
+  flush_pending (ps);
+  drop_paste (ps);
+
+  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+}
+
+static gboolean
+paste_idle (gpointer data)
+{
+  struct paste_state *ps = data;
+
+  ps->step (ps);
+
+  if (ps->offset >= ps->len)
+    {
+      g_signal_emit (ps->sheet, signals [PASTE_PROGRESS], 0, 1.0);
+      ps->idle_id = 0;
+      ssw_sheet_paste_finish (ps);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* Show what has been pasted so far */
+  flush_pending (ps);
+  gtk_widget_queue_draw (GTK_WIDGET (ps->sheet));
+
+  g_signal_emit (ps->sheet, signals [PASTE_PROGRESS], 0,
+                 ps->offset / (gdouble) ps->len);
+
+  return G_SOURCE_CONTINUE;
+}
+
+void
+ssw_sheet_paste_start_data (struct paste_state *ps, GtkSelectionData *sd,
+                            ssw_paste_step_func step)
+{
+  SswSheet *sheet = ps->sheet;
+  gint len = gtk_selection_data_get_length (sd);
+
+  if (len < 0)
+    {
+      ssw_sheet_paste_finish (ps);
+      return;
+    }
+
+  /* Only one paste is processed at a time */
+  if (sheet->paste)
+    ssw_sheet_cancel_paste (sheet);
+
+  ps->data = g_malloc (len + 1);
+  memcpy (ps->data, gtk_selection_data_get_data (sd), len);
+  ps->data[len] = '\0';
+  ps->len = len;
+  ps->offset = 0;
+  ps->step = step;
+  ps->row = 0;
+  ps->col = 0;
+
+  /* The whole paste is undone as one step */
+  sheet->paste = ps;
+  ssw_journal_begin (sheet->journal);
+  ssw_sheet_wait_push (sheet);
+
+  ps->idle_id = g_idle_add (paste_idle, ps);
+}
+
+void
+ssw_sheet_cancel_paste (SswSheet *sheet)
+{
+  g_return_if_fail (sheet);
 
-  if (rcf (sheet->data_model, col, row, str, &value))
-    ps->set_cell (sheet->data_model, col, row, &value);
-  g_value_unset (&value);
+  if (sheet->paste)
+    ssw_sheet_paste_finish (sheet->paste);
 }
 
 static void
@@ -985,66 +1910,39 @@ end_of_row (struct paste_state *t)
   t->col = 0;
 }
 
-static void
-end_of_paste (struct paste_state *t)
-{
-  g_free (t);
-}
 
+/* The number of rows of delimited text pasted at each step */
+#define PASTE_STEP_ROWS 1000
 
 static void
-parse_delimited_data (const gchar *data, int len, const char *delim,
-                      void (*payload)(const gchar *, size_t, struct paste_state *),
-                      void (*endload)(struct paste_state *),
-                      struct paste_state * dw)
+delimited_step (struct paste_state *ps)
 {
-  while (len > 0)
-    {
-      const gchar *x = g_strstr_len (data, len, delim);
-      if (x == NULL)
-        {
-          char *f = g_strndup (data, len);
-          payload (f, len, dw);
-          g_free (f);
-          break;
-        }
-      len -= x - data + 1;
-
-      gchar *line = g_strndup (data, x - data);
-      payload (line, x - data, dw);
-      data = x + 1;
-      g_free (line);
-    }
-  if (endload)
-    endload (dw);
+  ps->offset += ssw_parse_delimited (ps->data + ps->offset,
+                                     ps->len - ps->offset,
+                                     ps->delimiter, paste_datum, end_of_row,
+                                     ps, PASTE_STEP_ROWS);
 }
 
+/* Paste the delimited text held in SD, whose fields are separated
+   by DELIMITER.  */
 static void
-parseit (const gchar *x, size_t len, struct paste_state *dw)
+delimited_parse (GtkSelectionData *sd, gchar delimiter, struct paste_state *ps)
 {
-  parse_delimited_data (x, len, "\t", paste_datum, end_of_row, dw);
+  ps->delimiter = delimiter;
+  ssw_sheet_paste_start_data (ps, sd, delimited_step);
 }
 
 static void
 utf8_tab_delimited_parse (GtkClipboard *clip, GtkSelectionData *sd,
                           gpointer user_data)
 {
-  struct paste_state *ps = user_data;
-  SswSheet *sheet = SSW_SHEET (ps->sheet);
-  const gchar *data = (const gchar *) gtk_selection_data_get_data (sd);
-  gint len = gtk_selection_data_get_length (sd);
-
-  if (len < 0)
-    {
-      g_free (ps);
-      return;
-    }
-
-  ps->row = 0;
-  ps->col = 0;
+  delimited_parse (sd, '\t', user_data);
+}
 
-  parse_delimited_data (data, len, "\n", parseit, end_of_paste, ps);
-  gtk_widget_queue_draw (GTK_WIDGET (sheet));
+static void
+csv_parse (GtkClipboard *clip, GtkSelectionData *sd, gpointer user_data)
+{
+  delimited_parse (sd, ',', user_data);
 }
 
 static void
@@ -1056,7 +1954,7 @@ target_marshaller (GtkClipboard *clip, GdkAtom *atoms, gint n_atoms,
 
   if (atoms == NULL)
     {
-      g_free (ps);
+      ssw_sheet_paste_finish (ps);
       return;
     }
 
@@ -1072,17 +1970,21 @@ target_marshaller (GtkClipboard *clip, GdkAtom *atoms, gint n_atoms,
           gtk_clipboard_request_contents (clip, atoms[i], utf8_tab_delimited_parse, ps);
           break;
         }
+      else if (atoms[i] == gdk_atom_intern_static_string ("text/csv"))
+        {
+          gtk_clipboard_request_contents (clip, atoms[i], csv_parse, ps);
+          break;
+        }
     }
 
   if (i == n_atoms)
-    g_free (ps);
+    ssw_sheet_paste_finish (ps);
 }
 
-void
-ssw_sheet_paste (SswSheet *sheet, GtkClipboard *clip, ssw_sheet_set_cell sc)
+static void
+start_paste (SswSheet *sheet, GtkClipboard *clip,
+             ssw_sheet_set_cell sc, ssw_sheet_set_cells scs)
 {
-  g_return_if_fail (sheet);
-
   gint col, row;
 
   if (ssw_sheet_body_paste_editable (SSW_SHEET_BODY (sheet->selected_body)))
@@ -1093,6 +1995,19 @@ ssw_sheet_paste (SswSheet *sheet, GtkClipboard *clip, ssw_sheet_set_cell sc)
       struct paste_state *ps = g_malloc (sizeof *ps);
       ps->sheet = sheet;
       ps->set_cell = sc;
+      ps->set_cells = scs;
+      ps->pending = g_array_new (FALSE, FALSE, sizeof (struct pending_cell));
+      ps->data = NULL;
+      ps->len = 0;
+      ps->offset = 0;
+      ps->step = NULL;
+      ps->idle_id = 0;
+      ps->parser = NULL;
+      ps->parser_destroy = NULL;
+
+      g_object_get (SSW_SHEET_SINGLE (sheet->sheet[0])->body,
+                    "reverse-conversion", &ps->rcf,
+                    NULL);
 
       ps->col0 = col;
       ps->row0 = row;
@@ -1101,6 +2016,203 @@ ssw_sheet_paste (SswSheet *sheet, GtkClipboard *clip, ssw_sheet_set_cell sc)
     }
 }
 
+void
+ssw_sheet_paste (SswSheet *sheet, GtkClipboard *clip, ssw_sheet_set_cell sc)
+{
+  g_return_if_fail (sheet);
+
+  start_paste (sheet, clip, sc, NULL);
+}
+
+void
+ssw_sheet_paste_cells (SswSheet *sheet, GtkClipboard *clip,
+                       ssw_sheet_set_cells sc)
+{
+  g_return_if_fail (sheet);
+
+  start_paste (sheet, clip, NULL, sc);
+}
+
+const SswSelection *
+ssw_sheet_get_selection_set (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, NULL);
+
+  return sheet->selection_set;
+}
+
+void
+ssw_sheet_add_selection (SswSheet *sheet, const SswRange *r)
+{
+  gint i;
+
+  g_return_if_fail (sheet);
+  g_return_if_fail (r);
+
+  ssw_selection_add (sheet->selection_set, r);
+  *sheet->selection = *r;
+
+  for (i = 0; i < sheet->n_panes; ++i)
+    gtk_widget_queue_draw (SSW_SHEET_SINGLE (sheet->sheet[i])->body);
+
+  g_signal_emit (sheet, signals [SELECTION_CHANGED], 0, sheet->selection);
+  g_signal_emit (sheet, signals [SELECTION_SET_CHANGED], 0,
+                 sheet->selection_set);
+  update_aggregates (sheet);
+}
+
+gboolean
+ssw_sheet_find (SswSheet *sheet, const gchar *text,
+                SswFindMode mode, gboolean case_sensitive)
+{
+  g_return_val_if_fail (sheet, FALSE);
+  g_return_val_if_fail (text, FALSE);
+
+  return ssw_finder_start (sheet->finder, text, mode, case_sensitive);
+}
+
+void
+ssw_sheet_find_cancel (SswSheet *sheet)
+{
+  g_return_if_fail (sheet);
+
+  ssw_finder_cancel (sheet->finder);
+}
+
+gint
+ssw_sheet_find_get_n_matches (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, 0);
+
+  return ssw_finder_get_n_matches (sheet->finder);
+}
+
+void
+ssw_sheet_find_get_match (SswSheet *sheet, gint i, gint *col, gint *row)
+{
+  g_return_if_fail (sheet);
+
+  ssw_finder_get_match (sheet->finder, i, col, row);
+}
+
+/* Move to the match after (DIR > 0) or before (DIR < 0) the active
+   cell, wrapping around at the ends */
+static gboolean
+find_step (SswSheet *sheet, gint dir)
+{
+  gint n = ssw_finder_get_n_matches (sheet->finder);
+  gint col = -1, row = -1;
+  gint mcol, mrow;
+
+  if (n == 0)
+    return FALSE;
+
+  if (!ssw_sheet_get_active_cell (sheet, &col, &row))
+    col = row = -1;
+
+  gint i = ssw_finder_lookup (sheet->finder, col, row);
+  if (dir > 0)
+    {
+      if (i < n)
+        {
+          ssw_finder_get_match (sheet->finder, i, &mcol, &mrow);
+          if (mcol == col && mrow == row)
+            i++;
+        }
+      if (i >= n)
+        i = 0;
+    }
+  else if (--i < 0)
+    i = n - 1;
+
+  ssw_finder_get_match (sheet->finder, i, &mcol, &mrow);
+  ssw_sheet_body_goto_cell (SSW_SHEET_BODY (sheet->selected_body), mcol, mrow);
+
+  return TRUE;
+}
+
+gboolean
+ssw_sheet_find_next (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  return find_step (sheet, +1);
+}
+
+gboolean
+ssw_sheet_find_previous (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  return find_step (sheet, -1);
+}
+
+gboolean
+ssw_sheet_undo (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  /* A paste in progress is stopped, and is then the change undone */
+  ssw_sheet_cancel_paste (sheet);
+
+  return ssw_journal_undo (sheet->journal);
+}
+
+gboolean
+ssw_sheet_redo (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  ssw_sheet_cancel_paste (sheet);
+
+  return ssw_journal_redo (sheet->journal);
+}
+
+gboolean
+ssw_sheet_can_undo (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  return ssw_journal_can_undo (sheet->journal);
+}
+
+gboolean
+ssw_sheet_can_redo (SswSheet *sheet)
+{
+  g_return_val_if_fail (sheet, FALSE);
+
+  return ssw_journal_can_redo (sheet->journal);
+}
+
+void
+ssw_sheet_clear_history (SswSheet *sheet)
+{
+  g_return_if_fail (sheet);
+
+  ssw_journal_clear (sheet->journal);
+}
+
+gboolean
+ssw_sheet_get_aggregates (SswSheet *sheet, SswAggregates *agg)
+{
+  g_return_val_if_fail (sheet, FALSE);
+  g_return_val_if_fail (agg, FALSE);
+
+  return ssw_aggregator_get (sheet->aggregator, agg);
+}
+
+void
+ssw_sheet_cancel_clip (SswSheet *sheet)
+{
+  gint i;
+
+  g_return_if_fail (sheet);
+
+  for (i = 0; i < sheet->n_panes; ++i)
+    ssw_sheet_body_cancel_clip
+      (SSW_SHEET_BODY (SSW_SHEET_SINGLE (sheet->sheet[i])->body));
+}
+
 gboolean
 ssw_sheet_try_cut (SswSheet *sheet)
 {
@@ -1111,27 +2223,29 @@ ssw_sheet_try_cut (SswSheet *sheet)
 
 
 
+/* Every push is matched by a pop, whether or not the sheet has a
+   window at either time.  */
 void
 ssw_sheet_wait_push (SswSheet *sheet)
 {
   GdkWindow *win = gtk_widget_get_window (GTK_WIDGET (sheet));
-  if (win == NULL)
-    return;
+  GdkCursor *cursor = win ? gdk_window_get_cursor (win) : NULL;
 
-  GdkCursor *cursor = gdk_window_get_cursor (win);
   sheet->cursor_stack = g_slist_prepend (sheet->cursor_stack, cursor);
-  gdk_window_set_cursor (win, sheet->wait_cursor);
+  if (win)
+    gdk_window_set_cursor (win, sheet->wait_cursor);
 }
 
 
 void
 ssw_sheet_wait_pop (SswSheet *sheet)
 {
-  GdkWindow *win = gtk_widget_get_window (GTK_WIDGET (sheet));
-  if (win == NULL)
-    return;
+  g_return_if_fail (sheet->cursor_stack);
 
+  GdkWindow *win = gtk_widget_get_window (GTK_WIDGET (sheet));
   GSList *cursor = sheet->cursor_stack;
-  gdk_window_set_cursor (win, cursor->data);
-  sheet->cursor_stack = sheet->cursor_stack->next;
+
+  if (win)
+    gdk_window_set_cursor (win, cursor->data);
+  sheet->cursor_stack = g_slist_delete_link (sheet->cursor_stack, cursor);
 }
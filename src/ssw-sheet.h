@@ -28,6 +28,7 @@
 #define _SSW_SHEET_H
 
 #include <gtk/gtk.h>
+#include "ssw-axis-geometry.h"
 
 typedef struct
 {
@@ -37,6 +38,53 @@ typedef struct
   gint end_y;
 } SswRange;
 
+typedef struct _SswSelection SswSelection;
+
+/* The active cell, which receives the keyboard input */
+typedef struct
+{
+  gint col;
+  gint row;
+
+  /* The body in which the cell is shown, or NULL if there is no
+     active cell */
+  GtkWidget *body;
+
+  /* TRUE whilst a widget is shown to edit the cell */
+  gboolean editing;
+} SswCursor;
+
+/* Statistics of the cells of the selection which hold numbers */
+typedef struct
+{
+  gint64 count;
+  gdouble sum;
+  gdouble mean;
+  gdouble min;
+  gdouble max;
+} SswAggregates;
+
+struct ssw_aggregator;
+struct ssw_occupancy;
+struct ssw_finder;
+struct ssw_journal;
+struct ssw_render_cache;
+struct ssw_cell_cache;
+
+/* The ways in which cells may be sought by ssw_sheet_find */
+typedef enum
+{
+  /* The text of the cell contains the string sought */
+  SSW_FIND_SUBSTRING,
+  /* The text of the cell matches the regular expression sought */
+  SSW_FIND_REGEX,
+  /* The cell holds the number sought */
+  SSW_FIND_NUMBER
+} SswFindMode;
+
+struct ssw_permutation;
+struct paste_state;
+
 struct _SswSheet
 {
   GtkBin parent_instance;
@@ -45,17 +93,35 @@ struct _SswSheet
      Its units are cells. Not pixels */
   SswRange *selection;
 
+  /* All the selected ranges.  The last of them is always the one
+     above, which is the one being defined.  */
+  SswSelection *selection_set;
+
   GtkAdjustment *vadj[2] ;
   GtkAdjustment *hadj[2] ;
 
   GtkWidget *horizontal_axis[2];
   GtkWidget *vertical_axis[2];
+
+  /* The sizes of the columns and of the rows, shared by the pairs of
+     axes above, so that the panes agree about them */
+  SswAxisGeometry *horizontal_geometry;
+  SswAxisGeometry *vertical_geometry;
   GtkWidget *sheet[2 * 2];
   GtkWidget *sw [2 * 2];
 
+  /* The number of the panes above which have been created.  It is one
+     until the view is first split, when the other three are created.  */
+  gint n_panes;
+
   /* True if the view is split 4 ways */
   gboolean split;
 
+  /* The number of rows at the top and columns at the left which remain
+     in place when the panes are scrolled */
+  gint frozen_rows;
+  gint frozen_columns;
+
   /* The data model */
   GListModel *vmodel;
   GListModel *hmodel;
@@ -67,10 +133,55 @@ struct _SswSheet
   gboolean dispose_has_run;
   GtkWidget *selected_body;
 
+  /* The active cell.  It is shared by all the panes.  */
+  SswCursor cursor;
+
   gpointer renderer_func_datum;
 
   GSList *cursor_stack;
   GdkCursor *wait_cursor;
+
+  /* If TRUE, rows and columns dragged by the user are reordered in the
+     view only.  The data model is left untouched.  */
+  gboolean reorder_in_view;
+  struct ssw_permutation *row_order;
+  struct ssw_permutation *column_order;
+
+  /* Copies estimated to exceed this many bytes must be approved by a
+     handler of the "clip-size-exceeded" signal.  Zero means no limit.  */
+  gint64 clip_size_limit;
+
+  /* If TRUE, the forward conversion function may be called from
+     several threads at once.  Otherwise it is called from the main
+     thread only, even if the data model may be read by several.  */
+  gboolean thread_safe_conversion;
+
+  /* The paste whose data is being processed, if any */
+  struct paste_state *paste;
+
+  /* If TRUE, the statistics of the selection are computed whenever
+     it changes */
+  gboolean compute_aggregates;
+  struct ssw_aggregator *aggregator;
+
+  /* Which cells hold data, for moving to the edges of blocks of data */
+  struct ssw_occupancy *occupancy;
+
+  /* The search whose matches are highlighted, if any */
+  struct ssw_finder *finder;
+
+  /* The renderers and text of the cells drawn recently, shared by all
+     the panes */
+  struct ssw_render_cache *render_cache;
+
+  /* The accessible objects of the cells asked for recently, shared by
+     all the panes */
+  struct ssw_cell_cache *cell_cache;
+
+  /* The history of the changes made through the sheet, for undo.  Its
+     size is limited to UNDO_LIMIT bytes.  */
+  gint64 undo_limit;
+  struct ssw_journal *journal;
 };
 
 struct _SswSheetClass
@@ -96,6 +207,85 @@ typedef void (*ssw_sheet_set_cell) (GtkTreeModel *store, gint col, gint row,
 
 void ssw_sheet_paste (SswSheet *sheet, GtkClipboard *clip, ssw_sheet_set_cell sc);
 
+/* A function to store a block of values in STORE.  VALUES holds
+   N_COLS * N_ROWS values in row major order, for the cells whose top
+   left cell is COL0, ROW0.  A value which has not been initialised
+   means that the cell is to be left unchanged.  */
+typedef void (*ssw_sheet_set_cells) (GtkTreeModel *store,
+                                     gint col0, gint row0,
+                                     gint n_cols, gint n_rows,
+                                     const GValue *values);
+
+/* As ssw_sheet_paste, but stores the pasted values block by block
+   through SC, rather than cell by cell.  */
+void ssw_sheet_paste_cells (SswSheet *sheet, GtkClipboard *clip,
+                            ssw_sheet_set_cells sc);
+
+/* Pasted data is processed a part at a time, whilst the main loop is
+   idle.  This stops processing the current paste.  Cells which have
+   already been pasted keep their new values.  */
+void ssw_sheet_cancel_paste (SswSheet *sheet);
+
+/* Return the set of all the selected ranges.  More than one range is
+   selected when the user holds the Control key whilst selecting.  */
+const SswSelection *ssw_sheet_get_selection_set (SswSheet *sheet);
+
+/* Select the range R, in addition to those already selected */
+void ssw_sheet_add_selection (SswSheet *sheet, const SswRange *r);
+
+/* If the statistics of the current selection have been computed, copy
+   them to AGG and return TRUE.  Otherwise the "aggregates-ready"
+   signal is emitted when they have been.  The "compute-aggregates"
+   property must be set.  */
+gboolean ssw_sheet_get_aggregates (SswSheet *sheet, SswAggregates *agg);
+
+/* Begin searching the cells of SHEET for TEXT, in the manner given by
+   MODE.  The search proceeds whilst the main loop is idle.  As matches
+   are found, they are highlighted, and the "find-matches" signal is
+   emitted with the index and number of the new matches.  When the
+   search is complete, the "find-done" signal is emitted with the
+   number of matches.  Returns FALSE if TEXT is empty, or is not a
+   valid regular expression or number as MODE requires.  */
+gboolean ssw_sheet_find (SswSheet *sheet, const gchar *text,
+                         SswFindMode mode, gboolean case_sensitive);
+
+/* Abandon the search, and remove the highlighting of its matches */
+void ssw_sheet_find_cancel (SswSheet *sheet);
+
+/* The matches found so far, in order of row and then column */
+gint ssw_sheet_find_get_n_matches (SswSheet *sheet);
+void ssw_sheet_find_get_match (SswSheet *sheet, gint i, gint *col, gint *row);
+
+/* Make the next (previous) match after (before) the active cell the
+   active cell, and scroll it into view.  Returns FALSE if there are
+   no matches.  */
+gboolean ssw_sheet_find_next (SswSheet *sheet);
+gboolean ssw_sheet_find_previous (SswSheet *sheet);
+
+/* Undo the most recent change made through SHEET, that is to say an
+   edit of a cell, a paste, or the resizing of a row or column.  The
+   values of edited cells are restored through the "value-changed"
+   signal, and those of pasted cells through the function which pasted
+   them, a block at a time.  Returns FALSE if there is nothing to undo.
+   The "history-changed" signal is emitted whenever what may be undone
+   or redone changes.  */
+gboolean ssw_sheet_undo (SswSheet *sheet);
+
+/* Redo the change most recently undone.  Returns FALSE if there is
+   nothing to redo.  */
+gboolean ssw_sheet_redo (SswSheet *sheet);
+
+gboolean ssw_sheet_can_undo (SswSheet *sheet);
+gboolean ssw_sheet_can_redo (SswSheet *sheet);
+
+/* Forget every change which might be undone or redone.  This should be
+   called if the data model is changed other than through SHEET.  */
+void ssw_sheet_clear_history (SswSheet *sheet);
+
+/* Abandon the large copies which are being serialized, if any.  The
+   clipboard is left as it was before they began.  */
+void ssw_sheet_cancel_clip (SswSheet *sheet);
+
 /* Check if an editable is focused. If yes, cut to clipboard and return TRUE */
 gboolean ssw_sheet_try_cut (SswSheet *sheet);
 
@@ -109,6 +299,23 @@ void ssw_sheet_set_active_cell (SswSheet *sheet,
 gboolean ssw_sheet_get_active_cell (SswSheet *sheet,
                                     gint *col, gint *row);
 
+/* Return the row (column) of the data model which is displayed at
+   ROW (COL) of the view.  These differ only when the "reorder-in-view"
+   property is set and the user has dragged rows or columns.  */
+gint ssw_sheet_get_model_row (SswSheet *sheet, gint row);
+gint ssw_sheet_get_model_column (SswSheet *sheet, gint col);
+
+/* Return a newly allocated array holding the rows (columns) of the
+   data model, in the order in which they are displayed.  The length
+   of the array is stored in N.  Free it with g_free.  */
+gint *ssw_sheet_get_row_order (SswSheet *sheet, gint *n);
+gint *ssw_sheet_get_column_order (SswSheet *sheet, gint *n);
+
+/* Display the rows and columns in the same order as the data model.
+   Typically called after the application has applied the orders
+   returned by the above functions to the model itself.  */
+void ssw_sheet_reset_order (SswSheet *sheet);
+
 
 typedef gboolean (*ssw_sheet_reverse_conversion_func)
 (GtkTreeModel *model, gint col, gint row, const gchar *in, GValue *out);
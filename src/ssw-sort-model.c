@@ -0,0 +1,661 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <math.h>
+#include <string.h>
+#include <gtk/gtk.h>
+#include "ssw-sort-model.h"
+#include "ssw-data-model.h"
+#include "ssw-parallel.h"
+
+#define P_(X) (X)
+
+/* The number of rows of the key column fetched at a time */
+#define FETCH_ROWS 65536
+
+/* Slices shorter than this are sorted by insertion */
+#define INSERTION_LENGTH 32
+
+/* A change to more child rows than this at once is reported as a
+   change to every row, rather than to each of them separately */
+#define CHANGED_ROWS_LIMIT 1024
+
+enum  {ITEMS_CHANGED,
+       n_SIGNALS};
+
+static guint signals [n_SIGNALS];
+
+/* A sort key, and the child row from which it came */
+struct item
+{
+  union
+  {
+    gdouble d;
+    gchar *s;
+  } key;
+  guint row;
+};
+
+struct sort_job
+{
+  struct item *items;
+  struct item *tmp;
+  gint n;
+
+  /* The threads which do the work, kept for the whole sort */
+  struct ssw_pool *pool;
+
+  /* The model and column from which the keys are extracted */
+  SswSortModel *model;
+  gint column;
+
+  gboolean numeric;
+  gboolean descending;
+
+  /* The length of the runs sorted independently */
+  gint run_length;
+
+  /* The state of the current merge pass */
+  const struct item *src;
+  struct item *dst;
+  gint width;
+};
+
+static inline gint
+compare_items (const struct sort_job *job,
+               const struct item *a, const struct item *b)
+{
+  gint r;
+
+  if (job->numeric)
+    {
+      /* NaNs sort after everything else */
+      if (isnan (a->key.d) || isnan (b->key.d))
+        r = isnan (a->key.d) - isnan (b->key.d);
+      else
+        r = (a->key.d > b->key.d) - (a->key.d < b->key.d);
+    }
+  else
+    r = strcmp (a->key.s, b->key.s);
+
+  if (job->descending)
+    r = -r;
+
+  /* Equal keys keep their original order */
+  if (r == 0)
+    r = (a->row > b->row) - (a->row < b->row);
+
+  return r;
+}
+
+static void
+insertion_sort (const struct sort_job *job, struct item *items, gint lo, gint hi)
+{
+  gint i, j;
+  for (i = lo + 1; i < hi; ++i)
+    {
+      struct item x = items[i];
+      for (j = i; j > lo && compare_items (job, &x, &items[j - 1]) < 0; --j)
+        items[j] = items[j - 1];
+      items[j] = x;
+    }
+}
+
+/* Merge the sorted slices SRC[LO, MID) and SRC[MID, HI) into DST[LO, HI) */
+static void
+merge (const struct sort_job *job, const struct item *src, struct item *dst,
+       gint lo, gint mid, gint hi)
+{
+  gint i = lo, j = mid, k = lo;
+
+  while (i < mid && j < hi)
+    dst[k++] = (compare_items (job, &src[j], &src[i]) < 0) ? src[j++] : src[i++];
+
+  while (i < mid)
+    dst[k++] = src[i++];
+
+  while (j < hi)
+    dst[k++] = src[j++];
+}
+
+/* Sort the run numbered TASK.  This is a bottom up merge sort.  */
+static void
+sort_run (gint task, gpointer data)
+{
+  const struct sort_job *job = data;
+  gint lo = task * job->run_length;
+  gint hi = MIN (lo + job->run_length, job->n);
+  struct item *src = job->items;
+  struct item *dst = job->tmp;
+  gint i, w;
+
+  for (i = lo; i < hi; i += INSERTION_LENGTH)
+    insertion_sort (job, src, i, MIN (i + INSERTION_LENGTH, hi));
+
+  for (w = INSERTION_LENGTH; w < hi - lo; w *= 2)
+    {
+      for (i = lo; i < hi; i += 2 * w)
+        merge (job, src, dst, i, MIN (i + w, hi), MIN (i + 2 * w, hi));
+
+      struct item *t = src;
+      src = dst;
+      dst = t;
+    }
+
+  if (src != job->items)
+    memcpy (job->items + lo, src + lo, (hi - lo) * sizeof *src);
+}
+
+/* Merge the pair of slices numbered TASK of the current pass */
+static void
+merge_pair (gint task, gpointer data)
+{
+  const struct sort_job *job = data;
+  gint lo = task * 2 * job->width;
+  gint mid = MIN (lo + job->width, job->n);
+  gint hi = MIN (lo + 2 * job->width, job->n);
+
+  merge (job, job->src, job->dst, lo, mid, hi);
+}
+
+/* Sort JOB->items.  The array is divided into runs which are sorted
+   concurrently, and then merged pairwise, each pass of merges also
+   being done concurrently.  */
+static void
+parallel_merge_sort (struct sort_job *job)
+{
+  gint n_runs = MAX (1, MIN (job->n / 4096, 4 * (gint) g_get_num_processors ()));
+
+  job->run_length = (job->n + n_runs - 1) / n_runs;
+  ssw_pool_for (job->pool, n_runs, sort_run, job);
+
+  job->src = job->items;
+  job->dst = job->tmp;
+  for (job->width = job->run_length; job->width < job->n; job->width *= 2)
+    {
+      gint n_pairs = (job->n + 2 * job->width - 1) / (2 * job->width);
+      ssw_pool_for (job->pool, n_pairs, merge_pair, job);
+
+      struct item *t = (struct item *) job->src;
+      job->src = job->dst;
+      job->dst = t;
+    }
+
+  if (job->src != job->items)
+    memcpy (job->items, job->src, job->n * sizeof *job->items);
+}
+
+/* Fetch the keys of the TASKth block of FETCH_ROWS rows of the child
+   model into JOB */
+static void
+extract_block (gint task, gpointer data)
+{
+  struct sort_job *job = data;
+  SswSortModel *m = job->model;
+  GValue *values = g_new0 (GValue, FETCH_ROWS);
+  const gint r0 = task * FETCH_ROWS;
+  const gint n = MIN (FETCH_ROWS, m->n_rows - r0);
+  gint i;
+
+  ssw_data_model_fetch_block (m->child, job->column, r0, 1, n, values);
+
+  for (i = 0; i < n; ++i)
+    {
+      struct item *item = job->items + r0 + i;
+      GValue *v = values + i;
+      item->row = r0 + i;
+
+      if (job->numeric)
+        {
+          if (G_VALUE_HOLDS_DOUBLE (v))
+            item->key.d = g_value_get_double (v);
+          else if (G_VALUE_HOLDS_INT (v))
+            item->key.d = g_value_get_int (v);
+          else
+            {
+              GValue dv = G_VALUE_INIT;
+              g_value_init (&dv, G_TYPE_DOUBLE);
+              item->key.d = (G_IS_VALUE (v) && g_value_transform (v, &dv))
+                ? g_value_get_double (&dv) : NAN;
+              g_value_unset (&dv);
+            }
+        }
+      else
+        {
+          GValue sv = G_VALUE_INIT;
+          g_value_init (&sv, G_TYPE_STRING);
+          const gchar *s = NULL;
+          if (G_IS_VALUE (v) && g_value_transform (v, &sv))
+            s = g_value_get_string (&sv);
+          item->key.s = g_utf8_collate_key (s ? s : "", -1);
+          g_value_unset (&sv);
+        }
+
+      if (G_IS_VALUE (v))
+        g_value_unset (v);
+    }
+
+  g_free (values);
+}
+
+/* Fetch the keys of the sort column from the child model into JOB, on
+   several threads if the child may be read by several */
+static void
+extract_keys (struct sort_job *job)
+{
+  const gint n_blocks = (job->n + FETCH_ROWS - 1) / FETCH_ROWS;
+  gint i;
+
+  if (ssw_data_model_is_thread_safe (job->model->child))
+    ssw_pool_for (job->pool, n_blocks, extract_block, job);
+  else
+    for (i = 0; i < n_blocks; ++i)
+      extract_block (i, job);
+}
+
+void
+ssw_sort_model_sort (SswSortModel *m, gint column, GtkSortType order)
+{
+  g_return_if_fail (SSW_IS_SORT_MODEL (m));
+  g_return_if_fail (column >= 0 && column < gtk_tree_model_get_n_columns (m->child));
+
+  GType t = gtk_tree_model_get_column_type (m->child, column);
+
+  struct sort_job job;
+  job.n = m->n_rows;
+  job.numeric = (t != G_TYPE_STRING && g_value_type_transformable (t, G_TYPE_DOUBLE));
+  job.descending = (order == GTK_SORT_DESCENDING);
+  job.items = g_new (struct item, job.n);
+  job.tmp = g_new (struct item, job.n);
+  job.pool = ssw_pool_new ();
+  job.model = m;
+  job.column = column;
+
+  extract_keys (&job);
+
+  parallel_merge_sort (&job);
+
+  gint i;
+  g_free (m->permutation);
+  g_free (m->inverse);
+  m->permutation = g_new (guint, job.n);
+  m->inverse = g_new (guint, job.n);
+  for (i = 0; i < job.n; ++i)
+    {
+      m->permutation[i] = job.items[i].row;
+      m->inverse[job.items[i].row] = i;
+      if (!job.numeric)
+        g_free (job.items[i].key.s);
+    }
+
+  ssw_pool_free (job.pool);
+  g_free (job.items);
+  g_free (job.tmp);
+
+  m->sort_column = column;
+  m->sort_order = order;
+
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, 0, m->n_rows, m->n_rows);
+}
+
+void
+ssw_sort_model_unsort (SswSortModel *m)
+{
+  g_return_if_fail (SSW_IS_SORT_MODEL (m));
+
+  g_clear_pointer (&m->permutation, g_free);
+  g_clear_pointer (&m->inverse, g_free);
+  m->sort_column = -1;
+
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, 0, m->n_rows, m->n_rows);
+}
+
+gint
+ssw_sort_model_get_child_row (SswSortModel *m, gint row)
+{
+  g_return_val_if_fail (SSW_IS_SORT_MODEL (m), -1);
+
+  if (m->permutation == NULL || row < 0 || row >= m->n_rows)
+    return row;
+
+  return m->permutation[row];
+}
+
+
+/* Called when rows have been inserted into or deleted from the child.
+   The permutation no longer applies, so the child's order is restored.  */
+static void
+child_resized (SswSortModel *m, guint posn, guint rm, guint add)
+{
+  m->n_rows = gtk_tree_model_iter_n_children (m->child, NULL);
+  g_clear_pointer (&m->permutation, g_free);
+  g_clear_pointer (&m->inverse, g_free);
+  m->sort_column = -1;
+
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, posn, rm, add);
+}
+
+static void
+on_child_items_changed (GtkTreeModel *child, guint posn, guint rm, guint add,
+                        gpointer ud)
+{
+  SswSortModel *m = SSW_SORT_MODEL (ud);
+  guint r;
+
+  if (rm != add)
+    {
+      child_resized (m, posn, rm, add);
+      return;
+    }
+
+  if (m->permutation == NULL)
+    {
+      g_signal_emit (m, signals [ITEMS_CHANGED], 0, posn, rm, add);
+      return;
+    }
+
+  /* The changed rows stay where they are, but they may be anywhere in
+     the sorted order, so each is reported where it is displayed */
+  if (add > CHANGED_ROWS_LIMIT)
+    {
+      g_signal_emit (m, signals [ITEMS_CHANGED], 0, 0, m->n_rows, m->n_rows);
+      return;
+    }
+
+  for (r = posn; r < posn + add && r < (guint) m->n_rows; ++r)
+    g_signal_emit (m, signals [ITEMS_CHANGED], 0, m->inverse[r], 1, 1);
+}
+
+static void
+on_child_row_changed (GtkTreeModel *child, GtkTreePath *path,
+                      GtkTreeIter *iter, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  on_child_items_changed (child, row, 1, 1, ud);
+}
+
+static void
+on_child_row_inserted (GtkTreeModel *child, GtkTreePath *path,
+                       GtkTreeIter *iter, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  child_resized (SSW_SORT_MODEL (ud), row, 0, 1);
+}
+
+static void
+on_child_row_deleted (GtkTreeModel *child, GtkTreePath *path, gpointer ud)
+{
+  gint row = gtk_tree_path_get_indices (path)[0];
+  child_resized (SSW_SORT_MODEL (ud), row, 1, 0);
+}
+
+
+static  gint
+__iter_n_children (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+  return m->n_rows;
+}
+
+static gint
+__get_n_columns  (GtkTreeModel *tree_model)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+  return gtk_tree_model_get_n_columns (m->child);
+}
+
+static gboolean
+__iter_nth_child  (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter,
+                   GtkTreeIter  *parent,
+                   gint          n)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+
+  g_assert (parent == NULL);
+
+  if (n < 0 || n >= m->n_rows)
+    return FALSE;
+
+  iter->stamp = m->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+  return TRUE;
+}
+
+static void
+__get_value (GtkTreeModel *tree_model,
+             GtkTreeIter  *iter,
+             gint          column,
+             GValue       *value)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+  g_return_if_fail (iter->stamp == m->stamp);
+
+  gint row = ssw_sort_model_get_child_row (m, GPOINTER_TO_INT (iter->user_data));
+
+  GtkTreeIter child_iter;
+  if (gtk_tree_model_iter_nth_child (m->child, &child_iter, NULL, row))
+    gtk_tree_model_get_value (m->child, &child_iter, column, value);
+  else
+    g_value_init (value, gtk_tree_model_get_column_type (m->child, column));
+}
+
+static GType
+__get_type (GtkTreeModel *tree_model,
+            gint col)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+  return gtk_tree_model_get_column_type (m->child, col);
+}
+
+static GtkTreePath *
+__get_path (GtkTreeModel *tree_model,
+            GtkTreeIter  *iter)
+{
+  SswSortModel *m = SSW_SORT_MODEL (tree_model);
+  g_return_val_if_fail (iter->stamp == m->stamp, NULL);
+  return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+}
+
+static GtkTreeModelFlags
+__get_flags (GtkTreeModel *tm)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+
+static void
+__init_iface (GtkTreeModelIface *iface)
+{
+  iface->iter_n_children = __iter_n_children;
+  iface->get_n_columns = __get_n_columns;
+  iface->iter_nth_child = __iter_nth_child;
+  iface->get_value = __get_value;
+  iface->get_column_type = __get_type;
+  iface->get_path = __get_path;
+  iface->get_flags = __get_flags;
+}
+
+G_DEFINE_TYPE_WITH_CODE (SswSortModel, ssw_sort_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL, __init_iface));
+
+
+static void
+__dispose (GObject *obj)
+{
+  SswSortModel *m = SSW_SORT_MODEL (obj);
+
+  if (m->dispose_has_run)
+    return;
+
+  m->dispose_has_run = TRUE;
+
+  g_clear_object (&m->child);
+
+  G_OBJECT_CLASS (ssw_sort_model_parent_class)->dispose (obj);
+}
+
+static void
+__finalize (GObject *obj)
+{
+  SswSortModel *m = SSW_SORT_MODEL (obj);
+
+  g_free (m->permutation);
+  g_free (m->inverse);
+
+  G_OBJECT_CLASS (ssw_sort_model_parent_class)->finalize (obj);
+}
+
+
+enum
+  {
+   PROP_0,
+   PROP_CHILD,
+   PROP_THREAD_SAFE_READ
+  };
+
+static void
+set_child (SswSortModel *m, GtkTreeModel *child)
+{
+  m->child = g_object_ref (child);
+  m->n_rows = gtk_tree_model_iter_n_children (child, NULL);
+
+  if (g_signal_lookup ("items-changed", G_OBJECT_TYPE (child)))
+    {
+      g_signal_connect_object (child, "items-changed",
+                               G_CALLBACK (on_child_items_changed), m, 0);
+    }
+  else
+    {
+      g_signal_connect_object (child, "row-inserted",
+                               G_CALLBACK (on_child_row_inserted), m, 0);
+      g_signal_connect_object (child, "row-deleted",
+                               G_CALLBACK (on_child_row_deleted), m, 0);
+      g_signal_connect_object (child, "row-changed",
+                               G_CALLBACK (on_child_row_changed), m, 0);
+    }
+}
+
+/* GObject vfuncs {{{ */
+static void
+__set_property (GObject *object,
+                guint prop_id, const GValue *value, GParamSpec * pspec)
+{
+  SswSortModel *m = SSW_SORT_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      set_child (m, g_value_get_object (value));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+__get_property (GObject * object,
+                guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  SswSortModel *m = SSW_SORT_MODEL (object);
+  switch (prop_id)
+    {
+    case PROP_CHILD:
+      g_value_set_object (value, m->child);
+      break;
+    case PROP_THREAD_SAFE_READ:
+      /* Reading never changes this model, so it is as safe as its child */
+      g_value_set_boolean (value, ssw_data_model_is_thread_safe (m->child));
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+ssw_sort_model_class_init (SswSortModelClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = __set_property;
+  object_class->get_property = __get_property;
+  object_class->dispose = __dispose;
+  object_class->finalize = __finalize;
+
+  GParamSpec *child_spec =
+    g_param_spec_object ("child-model",
+                         P_("Child Model"),
+                         P_("The model whose rows are to be sorted"),
+                         GTK_TYPE_TREE_MODEL,
+                         G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *thread_safe_read_spec =
+    g_param_spec_boolean ("thread-safe-read",
+                          P_("Thread Safe Read"),
+                          P_("True if the model may be read from several threads at once"),
+                          FALSE,
+                          G_PARAM_READABLE);
+
+  g_object_class_install_property (object_class,
+                                   PROP_CHILD,
+                                   child_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_THREAD_SAFE_READ,
+                                   thread_safe_read_spec);
+
+  signals [ITEMS_CHANGED] =
+    g_signal_new ("items-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_generic,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT);
+}
+
+static void
+ssw_sort_model_init (SswSortModel *m)
+{
+  m->child = NULL;
+  m->n_rows = 0;
+  m->permutation = NULL;
+  m->inverse = NULL;
+  m->sort_column = -1;
+  m->sort_order = GTK_SORT_ASCENDING;
+  m->stamp = g_random_int ();
+  m->dispose_has_run = FALSE;
+}
+
+
+GObject *
+ssw_sort_model_new (GtkTreeModel *child)
+{
+  return g_object_new (SSW_TYPE_SORT_MODEL,
+                       "child-model", child,
+                       NULL);
+}
@@ -0,0 +1,83 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* An implementation of GtkTreeModel which presents the rows of a
+   CHILD model in sorted order.  No cell data is copied;  the model
+   holds only a permutation of the child's row numbers.
+
+   When an SswSheet displays one of these models, double clicking a
+   column header sorts by that column, toggling between ascending and
+   descending order.  Rows reported by the sheet (for example in the
+   "value-changed" signal) are rows of this model.  Use
+   ssw_sort_model_get_child_row to find the corresponding row of the
+   child.
+
+   A row whose values change stays where it is, even if it is then out
+   of order, until the model is sorted again.  The change is reported
+   at that row only.  Rows inserted into or deleted from the child
+   restore the child's order.
+*/
+
+#ifndef _SSW_SORT_MODEL_H
+#define _SSW_SORT_MODEL_H
+
+#include <gtk/gtk.h>
+
+struct _SswSortModel
+{
+  GObject parent_instance;
+
+  GtkTreeModel *child;
+  gint n_rows;
+
+  /* The child row displayed at each row of this model, or NULL if
+     the rows are in the child's order */
+  guint *permutation;
+
+  /* The row of this model at which each child row is displayed, or
+     NULL if the rows are in the child's order */
+  guint *inverse;
+
+  /* The column by which the rows are sorted, or -1 */
+  gint sort_column;
+  GtkSortType sort_order;
+
+  guint32 stamp;
+  gboolean dispose_has_run;
+};
+
+struct _SswSortModelClass
+{
+  GObjectClass parent_class;
+};
+
+#define SSW_TYPE_SORT_MODEL ssw_sort_model_get_type ()
+
+G_DECLARE_FINAL_TYPE (SswSortModel, ssw_sort_model, SSW, SORT_MODEL, GObject)
+
+  GObject * ssw_sort_model_new (GtkTreeModel *child);
+
+/* Sort the rows by the values in COLUMN.  The sort is stable.  */
+void ssw_sort_model_sort (SswSortModel *m, gint column, GtkSortType order);
+
+/* Restore the child's order */
+void ssw_sort_model_unsort (SswSortModel *m);
+
+gint ssw_sort_model_get_child_row (SswSortModel *m, gint row);
+
+#endif
@@ -0,0 +1,594 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+#include <gtk/gtk.h>
+#include "ssw-sparse-model.h"
+#include "ssw-marshaller.h"
+
+#define P_(X) (X)
+
+/* The dimensions of a chunk */
+#define CHUNK_ROWS 64
+#define CHUNK_COLS 64
+
+enum  {ITEMS_CHANGED,
+       IS_BLOCK_EMPTY,
+       FETCH_BLOCK,
+       n_SIGNALS};
+
+static guint signals [n_SIGNALS];
+
+struct cell
+{
+  /* The position of the cell within its chunk */
+  guint16 offset;
+  GValue value;
+};
+
+struct chunk
+{
+  gint crow;
+  gint ccol;
+
+  /* The populated cells of this chunk, in order of their offset.
+     A chunk is never empty;  it is deleted when its last cell is
+     unpopulated.  */
+  GArray *cells;
+};
+
+static guint
+chunk_hash (gconstpointer p)
+{
+  const struct chunk *ch = p;
+  return ch->crow * 65599u + ch->ccol;
+}
+
+static gboolean
+chunk_equal (gconstpointer p1, gconstpointer p2)
+{
+  const struct chunk *ch1 = p1;
+  const struct chunk *ch2 = p2;
+  return ch1->crow == ch2->crow && ch1->ccol == ch2->ccol;
+}
+
+static void
+chunk_free (gpointer p)
+{
+  struct chunk *ch = p;
+  guint i;
+  for (i = 0; i < ch->cells->len; ++i)
+    g_value_unset (&g_array_index (ch->cells, struct cell, i).value);
+
+  g_array_free (ch->cells, TRUE);
+  g_free (ch);
+}
+
+static struct chunk *
+lookup_chunk (SswSparseModel *m, gint col, gint row)
+{
+  struct chunk key;
+  key.crow = row / CHUNK_ROWS;
+  key.ccol = col / CHUNK_COLS;
+
+  return g_hash_table_lookup (m->chunks, &key);
+}
+
+/* Search CH for the cell at OFFSET.  Returns TRUE if it is populated.
+   In any case, *IDX is set to the position at which it is, or
+   would be, stored.  */
+static gboolean
+find_cell (const struct chunk *ch, guint16 offset, guint *idx)
+{
+  guint lo = 0;
+  guint hi = ch->cells->len;
+
+  while (lo < hi)
+    {
+      guint mid = (lo + hi) / 2;
+      guint16 o = g_array_index (ch->cells, struct cell, mid).offset;
+      if (o == offset)
+        {
+          *idx = mid;
+          return TRUE;
+        }
+      if (o < offset)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  *idx = lo;
+  return FALSE;
+}
+
+static inline guint16
+cell_offset (gint col, gint row)
+{
+  return (row % CHUNK_ROWS) * CHUNK_COLS + col % CHUNK_COLS;
+}
+
+typedef gboolean (*chunk_func) (const struct chunk *ch,
+                                gint col0, gint row0, gint col1, gint row1,
+                                gpointer data);
+
+/* Call FUNC for every stored chunk which overlaps the block with top
+   left cell COL0, ROW0 and bottom right cell COL1 - 1, ROW1 - 1.
+   Stops and returns FALSE if FUNC returns FALSE.  */
+static gboolean
+foreach_chunk_in (SswSparseModel *m, gint col0, gint row0, gint col1, gint row1,
+                  chunk_func func, gpointer data)
+{
+  gint cr0 = row0 / CHUNK_ROWS;
+  gint cr1 = (row1 - 1) / CHUNK_ROWS;
+  gint cc0 = col0 / CHUNK_COLS;
+  gint cc1 = (col1 - 1) / CHUNK_COLS;
+
+  gint64 span = (gint64) (cr1 - cr0 + 1) * (cc1 - cc0 + 1);
+
+  /* Either probe every chunk position in the block, or examine every
+     stored chunk, whichever is fewer.  */
+  if (span <= g_hash_table_size (m->chunks))
+    {
+      struct chunk key;
+      for (key.crow = cr0; key.crow <= cr1; ++key.crow)
+        for (key.ccol = cc0; key.ccol <= cc1; ++key.ccol)
+          {
+            const struct chunk *ch = g_hash_table_lookup (m->chunks, &key);
+            if (ch && !func (ch, col0, row0, col1, row1, data))
+              return FALSE;
+          }
+    }
+  else
+    {
+      GHashTableIter iter;
+      gpointer key;
+      g_hash_table_iter_init (&iter, m->chunks);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        {
+          const struct chunk *ch = key;
+          if (ch->crow < cr0 || ch->crow > cr1)
+            continue;
+          if (ch->ccol < cc0 || ch->ccol > cc1)
+            continue;
+          if (!func (ch, col0, row0, col1, row1, data))
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Returns FALSE if any populated cell of CH lies within the block */
+static gboolean
+chunk_empty_in (const struct chunk *ch, gint col0, gint row0, gint col1, gint row1,
+                gpointer data)
+{
+  gint top = ch->crow * CHUNK_ROWS;
+  gint left = ch->ccol * CHUNK_COLS;
+
+  /* The block covers the entire chunk */
+  if (top >= row0 && top + CHUNK_ROWS <= row1
+      && left >= col0 && left + CHUNK_COLS <= col1)
+    return FALSE;
+
+  guint i;
+  for (i = 0; i < ch->cells->len; ++i)
+    {
+      guint16 o = g_array_index (ch->cells, struct cell, i).offset;
+      gint row = top + o / CHUNK_COLS;
+      gint col = left + o % CHUNK_COLS;
+      if (row >= row0 && row < row1 && col >= col0 && col < col1)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+struct block
+{
+  gint col0;
+  gint row0;
+  gint n_cols;
+  GValue *values;
+};
+
+/* Copy the populated cells of CH which lie within the block */
+static gboolean
+chunk_copy_in (const struct chunk *ch, gint col0, gint row0, gint col1, gint row1,
+               gpointer data)
+{
+  struct block *b = data;
+  gint top = ch->crow * CHUNK_ROWS;
+  gint left = ch->ccol * CHUNK_COLS;
+
+  guint i;
+  for (i = 0; i < ch->cells->len; ++i)
+    {
+      const struct cell *c = &g_array_index (ch->cells, struct cell, i);
+      gint row = top + c->offset / CHUNK_COLS;
+      gint col = left + c->offset % CHUNK_COLS;
+      if (row >= row0 && row < row1 && col >= col0 && col < col1)
+        g_value_copy (&c->value,
+                      b->values + (row - b->row0) * b->n_cols + col - b->col0);
+    }
+
+  return TRUE;
+}
+
+static gboolean
+__is_block_empty (SswSparseModel *m, gint col0, gint row0,
+                  gint n_cols, gint n_rows)
+{
+  if (n_cols <= 0 || n_rows <= 0)
+    return TRUE;
+
+  return foreach_chunk_in (m, col0, row0, col0 + n_cols, row0 + n_rows,
+                           chunk_empty_in, NULL);
+}
+
+static gboolean
+__fetch_block (SswSparseModel *m, gint col0, gint row0,
+               gint n_cols, gint n_rows, GValue *values)
+{
+  gint i;
+
+  if (n_cols <= 0 || n_rows <= 0)
+    return TRUE;
+
+  for (i = 0; i < n_cols * n_rows; ++i)
+    g_value_init (values + i, m->value_type);
+
+  struct block b = {col0, row0, n_cols, values};
+  foreach_chunk_in (m, col0, row0, col0 + n_cols, row0 + n_rows,
+                    chunk_copy_in, &b);
+
+  return TRUE;
+}
+
+
+static  gint
+__iter_n_children (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+  return m->rows;
+}
+
+static gint
+__get_n_columns  (GtkTreeModel *tree_model)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+  return m->cols;
+}
+
+static gboolean
+__iter_nth_child  (GtkTreeModel *tree_model,
+                   GtkTreeIter  *iter,
+                   GtkTreeIter  *parent,
+                   gint          n)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+
+  g_assert (parent == NULL);
+
+  if (n < 0 || n >= m->rows)
+    return FALSE;
+
+  iter->stamp = m->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+  return TRUE;
+}
+
+static void
+__get_value (GtkTreeModel *tree_model,
+             GtkTreeIter  *iter,
+             gint          column,
+             GValue       *value)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+  g_return_if_fail (iter->stamp == m->stamp);
+
+  gint row = GPOINTER_TO_INT (iter->user_data);
+
+  g_value_init (value, m->value_type);
+
+  const struct chunk *ch = lookup_chunk (m, column, row);
+  guint idx;
+  if (ch && find_cell (ch, cell_offset (column, row), &idx))
+    g_value_copy (&g_array_index (ch->cells, struct cell, idx).value, value);
+}
+
+static GType
+__get_type (GtkTreeModel *tree_model,
+            gint col)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+  return m->value_type;
+}
+
+
+static GtkTreePath *
+__get_path (GtkTreeModel *tree_model,
+            GtkTreeIter  *iter)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (tree_model);
+  g_return_val_if_fail (iter->stamp == m->stamp, NULL);
+  return gtk_tree_path_new_from_indices (GPOINTER_TO_INT (iter->user_data), -1);
+}
+
+static GtkTreeModelFlags
+__get_flags (GtkTreeModel *tm)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+
+static void
+__init_iface (GtkTreeModelIface *iface)
+{
+  iface->iter_n_children = __iter_n_children;
+  iface->get_n_columns = __get_n_columns;
+  iface->iter_nth_child = __iter_nth_child;
+  iface->get_value = __get_value;
+  iface->get_column_type = __get_type;
+  iface->get_path = __get_path;
+  iface->get_flags = __get_flags;
+}
+
+G_DEFINE_TYPE_WITH_CODE (SswSparseModel, ssw_sparse_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL, __init_iface));
+
+
+void
+ssw_sparse_model_set_value (SswSparseModel *m, gint col, gint row,
+                            const GValue *value)
+{
+  g_return_if_fail (SSW_IS_SPARSE_MODEL (m));
+  g_return_if_fail (col >= 0 && col < m->cols);
+  g_return_if_fail (row >= 0 && row < m->rows);
+
+  struct chunk *ch = lookup_chunk (m, col, row);
+  guint16 offset = cell_offset (col, row);
+  guint idx;
+
+  if (value == NULL)
+    {
+      if (ch == NULL || !find_cell (ch, offset, &idx))
+        return;
+
+      g_value_unset (&g_array_index (ch->cells, struct cell, idx).value);
+      g_array_remove_index (ch->cells, idx);
+      if (ch->cells->len == 0)
+        g_hash_table_remove (m->chunks, ch);
+    }
+  else
+    {
+      if (ch == NULL)
+        {
+          ch = g_malloc (sizeof *ch);
+          ch->crow = row / CHUNK_ROWS;
+          ch->ccol = col / CHUNK_COLS;
+          ch->cells = g_array_new (FALSE, FALSE, sizeof (struct cell));
+          g_hash_table_add (m->chunks, ch);
+        }
+
+      if (find_cell (ch, offset, &idx))
+        {
+          GValue *v = &g_array_index (ch->cells, struct cell, idx).value;
+          g_value_unset (v);
+          g_value_init (v, m->value_type);
+          g_value_transform (value, v);
+        }
+      else
+        {
+          struct cell c = {offset, G_VALUE_INIT};
+          g_value_init (&c.value, m->value_type);
+          g_value_transform (value, &c.value);
+          g_array_insert_val (ch->cells, idx, c);
+        }
+    }
+
+  g_signal_emit (m, signals [ITEMS_CHANGED], 0, row, 1, 1);
+}
+
+
+static void
+__finalize (GObject *obj)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (obj);
+
+  g_hash_table_unref (m->chunks);
+
+  G_OBJECT_CLASS (ssw_sparse_model_parent_class)->finalize (obj);
+}
+
+
+enum
+  {
+   PROP_0,
+   PROP_COLS,
+   PROP_ROWS,
+   PROP_VALUE_TYPE,
+   PROP_THREAD_SAFE_READ
+  };
+
+
+/* GObject vfuncs {{{ */
+static void
+__set_property (GObject *object,
+                guint prop_id, const GValue *value, GParamSpec * pspec)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (object);
+
+  switch (prop_id)
+    {
+    case PROP_COLS:
+      m->cols = g_value_get_int (value);
+      break;
+    case PROP_ROWS:
+      m->rows = g_value_get_int (value);
+      break;
+    case PROP_VALUE_TYPE:
+      m->value_type = g_value_get_gtype (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+static void
+__get_property (GObject * object,
+                guint prop_id, GValue * value, GParamSpec * pspec)
+{
+  SswSparseModel *m = SSW_SPARSE_MODEL (object);
+  switch (prop_id)
+    {
+    case PROP_COLS:
+      g_value_set_int (value, m->cols);
+      break;
+    case PROP_ROWS:
+      g_value_set_int (value, m->rows);
+      break;
+    case PROP_VALUE_TYPE:
+      g_value_set_gtype (value, m->value_type);
+      break;
+    case PROP_THREAD_SAFE_READ:
+      g_value_set_boolean (value, TRUE);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+ssw_sparse_model_class_init (SswSparseModelClass *class)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (class);
+
+  object_class->set_property = __set_property;
+  object_class->get_property = __get_property;
+  object_class->finalize = __finalize;
+
+  GParamSpec *cols_spec =
+    g_param_spec_int ("columns",
+                      P_("Columns"),
+                      P_("The number of columns in the model"),
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *rows_spec =
+    g_param_spec_int ("rows",
+                      P_("Rows"),
+                      P_("The number of rows in the model"),
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *value_type_spec =
+    g_param_spec_gtype ("value-type",
+                        P_("Value Type"),
+                        P_("The type of every cell in the model"),
+                        G_TYPE_NONE,
+                        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+
+  GParamSpec *thread_safe_read_spec =
+    g_param_spec_boolean ("thread-safe-read",
+                          P_("Thread Safe Read"),
+                          P_("True if the model may be read from several threads at once"),
+                          TRUE,
+                          G_PARAM_READABLE);
+
+  g_object_class_install_property (object_class,
+                                   PROP_COLS,
+                                   cols_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_ROWS,
+                                   rows_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_VALUE_TYPE,
+                                   value_type_spec);
+
+  g_object_class_install_property (object_class,
+                                   PROP_THREAD_SAFE_READ,
+                                   thread_safe_read_spec);
+
+  signals [ITEMS_CHANGED] =
+    g_signal_new ("items-changed",
+                  G_TYPE_FROM_CLASS (class),
+                  G_SIGNAL_RUN_FIRST,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_generic,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT,
+                  G_TYPE_UINT);
+
+  signals [IS_BLOCK_EMPTY] =
+    g_signal_new_class_handler ("is-block-empty",
+                                G_TYPE_FROM_CLASS (class),
+                                G_SIGNAL_RUN_LAST,
+                                G_CALLBACK (__is_block_empty),
+                                NULL, NULL,
+                                ssw_cclosure_marshal_BOOLEAN__INT_INT_INT_INT,
+                                G_TYPE_BOOLEAN,
+                                4,
+                                G_TYPE_INT,
+                                G_TYPE_INT,
+                                G_TYPE_INT,
+                                G_TYPE_INT);
+
+  signals [FETCH_BLOCK] =
+    g_signal_new_class_handler ("fetch-block",
+                                G_TYPE_FROM_CLASS (class),
+                                G_SIGNAL_RUN_LAST,
+                                G_CALLBACK (__fetch_block),
+                                NULL, NULL,
+                                ssw_cclosure_marshal_BOOLEAN__INT_INT_INT_INT_POINTER,
+                                G_TYPE_BOOLEAN,
+                                5,
+                                G_TYPE_INT,
+                                G_TYPE_INT,
+                                G_TYPE_INT,
+                                G_TYPE_INT,
+                                G_TYPE_POINTER);
+}
+
+static void
+ssw_sparse_model_init (SswSparseModel *m)
+{
+  m->chunks = g_hash_table_new_full (chunk_hash, chunk_equal, chunk_free, NULL);
+  m->stamp = g_random_int ();
+}
+
+
+GObject *
+ssw_sparse_model_new (gint cols, gint rows, GType value_type)
+{
+  return g_object_new (SSW_TYPE_SPARSE_MODEL,
+                       "columns", cols,
+                       "rows", rows,
+                       "value-type", value_type,
+                       NULL);
+}
@@ -0,0 +1,61 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* An implementation of GtkTreeModel suitable for very large grids
+   of which only a small proportion of cells are populated.  The grid
+   is divided into fixed size chunks, and only chunks containing at
+   least one populated cell are stored.  Unpopulated cells read as the
+   default value of the model's value type.
+*/
+
+#ifndef _SSW_SPARSE_MODEL_H
+#define _SSW_SPARSE_MODEL_H
+
+#include <gtk/gtk.h>
+
+struct _SswSparseModel
+{
+  GObject parent_instance;
+
+  gint cols;
+  gint rows;
+  GType value_type;
+
+  /* The populated chunks, keyed by their coordinates */
+  GHashTable *chunks;
+
+  guint32 stamp;
+};
+
+struct _SswSparseModelClass
+{
+  GObjectClass parent_class;
+};
+
+#define SSW_TYPE_SPARSE_MODEL ssw_sparse_model_get_type ()
+
+G_DECLARE_FINAL_TYPE (SswSparseModel, ssw_sparse_model, SSW, SPARSE_MODEL, GObject)
+
+  GObject * ssw_sparse_model_new (gint cols, gint rows, GType value_type);
+
+/* Set the cell at COL, ROW to VALUE.  If VALUE is NULL the cell
+   becomes unpopulated.  */
+void ssw_sparse_model_set_value (SswSparseModel *m, gint col, gint row,
+                                 const GValue *value);
+
+#endif
@@ -126,7 +126,8 @@ enum
   {
    PROP_0,
    PROP_COLS,
-   PROP_ROWS
+   PROP_ROWS,
+   PROP_THREAD_SAFE_READ
   };
 
 
@@ -198,6 +199,9 @@ __get_property (GObject * object,
     case PROP_ROWS:
       g_value_set_uint (value, m->rows);
       break;
+    case PROP_THREAD_SAFE_READ:
+      g_value_set_boolean (value, TRUE);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -228,6 +232,12 @@ ssw_virtual_model_class_init (SswVirtualModelClass *class)
                        0, UINT_MAX, 10000,
                        G_PARAM_READWRITE);
 
+  GParamSpec *thread_safe_read_spec =
+    g_param_spec_boolean ("thread-safe-read",
+                          P_("Thread Safe Read"),
+                          P_("True if the model may be read from several threads at once"),
+                          TRUE,
+                          G_PARAM_READABLE);
 
   g_object_class_install_property (object_class,
                                    PROP_COLS,
@@ -237,6 +247,10 @@ ssw_virtual_model_class_init (SswVirtualModelClass *class)
                                    PROP_ROWS,
                                    rows_spec);
 
+  g_object_class_install_property (object_class,
+                                   PROP_THREAD_SAFE_READ,
+                                   thread_safe_read_spec);
+
   object_class->finalize = __finalize;
 
   signals [ITEMS_CHANGED] =
@@ -0,0 +1,119 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Check that moves of the active cell made by the keyboard, some of
+   which are put off until the next frame, land on the right cell when
+   several happen within one frame.  */
+
+#include <config.h>
+#include <gtk/gtk.h>
+#include "ssw-sheet.h"
+#include "ssw-sheet-single.h"
+
+static gboolean
+quit_loop (gpointer loop)
+{
+  g_main_loop_quit (loop);
+  return G_SOURCE_REMOVE;
+}
+
+/* Run the main loop for MS milliseconds, so that several frames pass */
+static void
+run_frames (guint ms)
+{
+  GMainLoop *loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (ms, quit_loop, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+}
+
+static void
+press (GtkWidget *w, guint keyval)
+{
+  GdkEvent *e = gdk_event_new (GDK_KEY_PRESS);
+
+  e->key.window = g_object_ref (gtk_widget_get_window (w));
+  e->key.keyval = keyval;
+  e->key.time = GDK_CURRENT_TIME;
+  gtk_widget_event (w, e);
+  gdk_event_free (e);
+}
+
+static gboolean
+check_active (SswSheet *sheet, gint col, gint row, const gchar *what)
+{
+  gint c = -1, r = -1;
+
+  ssw_sheet_get_active_cell (sheet, &c, &r);
+  if (c == col && r == row)
+    return TRUE;
+
+  g_printerr ("%s: active cell is %d,%d, not %d,%d\n", what, c, r, col, row);
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  gboolean ok = TRUE;
+  gint i;
+
+  /* Skip the test where there is no display */
+  if (!gtk_init_check (&argc, &argv))
+    return 77;
+
+  GtkListStore *store = gtk_list_store_new (4, G_TYPE_INT, G_TYPE_INT,
+                                            G_TYPE_INT, G_TYPE_INT);
+  for (i = 0; i < 10; ++i)
+    {
+      GtkTreeIter iter;
+      gtk_list_store_append (store, &iter);
+      gtk_list_store_set (store, &iter, 0, i, 1, i, 2, i, 3, i, -1);
+    }
+
+  GtkWidget *window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  GtkWidget *sheet = ssw_sheet_new ();
+  g_object_set (sheet, "data-model", store, NULL);
+  gtk_container_add (GTK_CONTAINER (window), sheet);
+  gtk_widget_show_all (window);
+
+  GtkWidget *body = SSW_SHEET_SINGLE (SSW_SHEET (sheet)->sheet[0])->body;
+  while (!gtk_widget_get_mapped (body))
+    gtk_main_iteration ();
+  run_frames (200);
+
+  /* Down is put off until the next frame.  Tab, in the same frame,
+     must first apply it, and nothing may then undo the Tab.  */
+  ssw_sheet_set_active_cell (SSW_SHEET (sheet), 0, 0, NULL);
+  press (body, GDK_KEY_Down);
+  press (body, GDK_KEY_Tab);
+  run_frames (200);
+  ok &= check_active (SSW_SHEET (sheet), 1, 1, "Down then Tab");
+
+  /* Two moves put off within one frame are both applied, once */
+  ssw_sheet_set_active_cell (SSW_SHEET (sheet), 0, 0, NULL);
+  press (body, GDK_KEY_Down);
+  press (body, GDK_KEY_Down);
+  run_frames (200);
+  ok &= check_active (SSW_SHEET (sheet), 0, 2, "Down then Down");
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Check that a reordering survives the insertion and deletion of
+   items in the data model.  */
+
+#include <config.h>
+#include <string.h>
+#include <glib.h>
+#include "ssw-permutation.h"
+
+static gboolean
+check_order (const struct ssw_permutation *p, gint n, const gint *expected,
+             const gchar *what)
+{
+  gint *order = ssw_permutation_export (p, n);
+  gboolean ok = memcmp (order, expected, n * sizeof *order) == 0;
+  gint i;
+
+  if (!ok)
+    {
+      g_printerr ("%s: order is", what);
+      for (i = 0; i < n; ++i)
+        g_printerr (" %d", order[i]);
+      g_printerr ("\n");
+    }
+
+  g_free (order);
+  return ok;
+}
+
+int
+main (int argc, char **argv)
+{
+  gboolean ok = TRUE;
+  struct ssw_permutation *p = ssw_permutation_new ();
+
+  /* A move of nothing leaves the identity alone */
+  ssw_permutation_move (p, 0, 0, 0);
+  if (!ssw_permutation_is_identity (p))
+    {
+      g_printerr ("An empty move is not the identity\n");
+      ok = FALSE;
+    }
+
+  /* Move the first of 6 items to the end */
+  ssw_permutation_move (p, 6, 0, 6);
+  {
+    const gint expected[] = {1, 2, 3, 4, 5, 0};
+    ok &= check_order (p, 6, expected, "Move");
+  }
+
+  /* Insert 2 items at model position 2.  They are displayed before
+     the item which followed them.  */
+  ssw_permutation_shift (p, 2, 0, 2);
+  {
+    const gint expected[] = {1, 2, 3, 4, 5, 6, 7, 0};
+    ok &= check_order (p, 8, expected, "Insert");
+  }
+
+  /* Delete the item at model position 3 */
+  ssw_permutation_shift (p, 3, 1, 0);
+  {
+    const gint expected[] = {1, 2, 3, 4, 5, 6, 0};
+    ok &= check_order (p, 7, expected, "Delete");
+  }
+
+  /* Append an item, and move it to the front */
+  ssw_permutation_shift (p, 7, 0, 1);
+  ssw_permutation_move (p, 8, 7, 0);
+  {
+    const gint expected[] = {7, 1, 2, 3, 4, 5, 6, 0};
+    ok &= check_order (p, 8, expected, "Append");
+  }
+
+  /* Deleting the item out of place restores the identity */
+  ssw_permutation_shift (p, 0, 1, 0);
+  ssw_permutation_shift (p, 6, 1, 0);
+  if (!ssw_permutation_is_identity (p))
+    {
+      g_printerr ("The order is not restored\n");
+      ok = FALSE;
+    }
+
+  ssw_permutation_free (p);
+
+  return ok ? 0 : 1;
+}
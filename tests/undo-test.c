@@ -0,0 +1,143 @@
+/*
+  A widget to display and manipulate tabular data
+  Copyright (C) 2020  John Darrington
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Check that undoing an edit to a cell which held nothing clears the
+   cell, rather than leaving the new value in place, and that edits are
+   undone in the right rows after rows are inserted or deleted.  */
+
+#include <config.h>
+#include <gtk/gtk.h>
+#include "ssw-sheet.h"
+#include "ssw-sheet-single.h"
+
+#define N_ROWS 3
+
+/* Store VALUE in the model, appending rows to reach ROW if need be */
+static void
+store_value (SswSheet *sheet, gint col, gint row, const GValue *value,
+             gpointer data)
+{
+  GtkListStore *store = data;
+  GtkTreeIter iter;
+
+  while (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter,
+                                         NULL, row))
+    gtk_list_store_append (store, &iter);
+
+  gtk_list_store_set_value (store, &iter, col, (GValue *) value);
+}
+
+static gboolean
+check_cell (GtkListStore *store, gint col, gint row, gint expected,
+            const gchar *what)
+{
+  GtkTreeIter iter;
+  gint x = -1;
+
+  if (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter,
+                                      NULL, row))
+    {
+      g_printerr ("%s: row %d does not exist\n", what, row);
+      return FALSE;
+    }
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, col, &x, -1);
+  if (x == expected)
+    return TRUE;
+
+  g_printerr ("%s: cell %d,%d holds %d, not %d\n", what, col, row,
+              x, expected);
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  gboolean ok = TRUE;
+  gint i;
+
+  /* Skip the test where there is no display */
+  if (!gtk_init_check (&argc, &argv))
+    return 77;
+
+  GtkListStore *store = gtk_list_store_new (2, G_TYPE_INT, G_TYPE_INT);
+  for (i = 0; i < N_ROWS; ++i)
+    {
+      GtkTreeIter iter;
+      gtk_list_store_append (store, &iter);
+      gtk_list_store_set (store, &iter, 0, i + 1, 1, i + 1, -1);
+    }
+
+  GtkWidget *sheet = g_object_ref_sink (ssw_sheet_new ());
+  g_object_set (sheet, "data-model", store, NULL);
+  g_signal_connect (sheet, "value-changed", G_CALLBACK (store_value), store);
+
+  GtkWidget *body = SSW_SHEET_SINGLE (SSW_SHEET (sheet)->sheet[0])->body;
+  GValue value = G_VALUE_INIT;
+  g_value_init (&value, G_TYPE_INT);
+
+  /* An edit to a cell which held something is undone by restoring it */
+  g_value_set_int (&value, 42);
+  g_signal_emit_by_name (body, "value-changed", 0, 1, &value);
+  ok &= check_cell (store, 0, 1, 42, "Edit");
+  ssw_sheet_undo (SSW_SHEET (sheet));
+  ok &= check_cell (store, 0, 1, 2, "Undo of an edit");
+
+  /* An edit to a cell beyond the last row, which held nothing, is
+     undone by clearing it */
+  g_value_set_int (&value, 43);
+  g_signal_emit_by_name (body, "value-changed", 1, N_ROWS, &value);
+  ok &= check_cell (store, 1, N_ROWS, 43, "Edit of an empty cell");
+  ssw_sheet_undo (SSW_SHEET (sheet));
+  ok &= check_cell (store, 1, N_ROWS, 0, "Undo of an edit to an empty cell");
+  ssw_sheet_redo (SSW_SHEET (sheet));
+  ok &= check_cell (store, 1, N_ROWS, 43, "Redo of an edit to an empty cell");
+
+  /* Column 0 holds 1, 2, 3, 0.  An edit is undone in the row to which an
+     insertion above has moved it.  */
+  GtkTreeIter iter;
+  ssw_sheet_clear_history (SSW_SHEET (sheet));
+  g_value_set_int (&value, 42);
+  g_signal_emit_by_name (body, "value-changed", 0, 1, &value);
+  gtk_list_store_insert_with_values (store, &iter, 0, 0, 100, 1, 100, -1);
+  ssw_sheet_undo (SSW_SHEET (sheet));
+  ok &= check_cell (store, 0, 2, 2, "Undo after an insertion");
+  ok &= check_cell (store, 0, 0, 100, "Inserted row after an undo");
+
+  /* Column 0 holds 100, 1, 2, 3, 0.  An edit to a row which has since been
+     deleted is forgotten, rather than undone in the row which took its
+     place.  */
+  ssw_sheet_clear_history (SSW_SHEET (sheet));
+  g_value_set_int (&value, 55);
+  g_signal_emit_by_name (body, "value-changed", 0, 2, &value);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, 2);
+  gtk_list_store_remove (store, &iter);
+  if (ssw_sheet_undo (SSW_SHEET (sheet)))
+    {
+      g_printerr ("An edit to a deleted row was undone\n");
+      ok = FALSE;
+    }
+  ok &= check_cell (store, 0, 2, 3, "Undo after a deletion");
+
+  g_value_unset (&value);
+  gtk_widget_destroy (sheet);
+  g_object_unref (sheet);
+  g_object_unref (store);
+
+  return ok ? 0 : 1;
+}